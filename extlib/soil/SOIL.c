@@ -38,8 +38,18 @@
 #include <stdlib.h>
 #include <string.h>
 
-/*	error reporting	*/
-char *result_string_pointer = "SOIL initialized";
+/*	error reporting, per thread so that images can be loaded on several threads at once	*/
+#if defined( _MSC_VER )
+	#define SOIL_THREAD_LOCAL __declspec( thread )
+#elif defined( __GNUC__ )
+	#define SOIL_THREAD_LOCAL __thread
+#elif defined( __STDC_VERSION__ ) && __STDC_VERSION__ >= 201112L
+	#define SOIL_THREAD_LOCAL _Thread_local
+#else
+	#define SOIL_THREAD_LOCAL
+#endif
+
+SOIL_THREAD_LOCAL char *result_string_pointer = "SOIL initialized";
 
 /*	for loading cube maps	*/
 enum{
@@ -1055,27 +1065,7 @@ unsigned int
 		(and do we even _have_ alpha?)	*/
 	if( flags & SOIL_FLAG_MULTIPLY_ALPHA )
 	{
-		int i;
-		switch( channels )
-		{
-		case 2:
-			for( i = 0; i < 2*width*height; i += 2 )
-			{
-				img[i] = (img[i] * img[i+1] + 128) >> 8;
-			}
-			break;
-		case 4:
-			for( i = 0; i < 4*width*height; i += 4 )
-			{
-				img[i+0] = (img[i+0] * img[i+3] + 128) >> 8;
-				img[i+1] = (img[i+1] * img[i+3] + 128) >> 8;
-				img[i+2] = (img[i+2] * img[i+3] + 128) >> 8;
-			}
-			break;
-		default:
-			/*	no other number of channels contains alpha data	*/
-			break;
-		}
+		multiply_alpha( img, width, height, channels );
 	}
 	/*	if the user can't support NPOT textures, make sure we force the POT option	*/
 	if( (query_NPOT_capability() == SOIL_CAPABILITY_NONE) &&
@@ -1087,10 +1077,12 @@ unsigned int
 	/*	how large of a texture can this OpenGL implementation handle?	*/
 	/*	texture_check_size_enum will be GL_MAX_TEXTURE_SIZE or SOIL_MAX_CUBE_MAP_TEXTURE_SIZE	*/
 	glGetIntegerv( texture_check_size_enum, &max_supported_size );
-	/*	do I need to make it a power of 2?	*/
+	/*	do I need to make it a power of 2?
+		(with NPOT support the MIP-maps can be any size, so skip the CPU rescale)	*/
 	if(
 		(flags & SOIL_FLAG_POWER_OF_TWO) ||	/*	user asked for it	*/
-		(flags & SOIL_FLAG_MIPMAPS) ||		/*	need it for the MIP-maps	*/
+		((flags & SOIL_FLAG_MIPMAPS) &&		/*	need it for the MIP-maps	*/
+		(query_NPOT_capability() == SOIL_CAPABILITY_NONE)) ||
 		(width > max_supported_size) ||		/*	it's too big, (make sure it's	*/
 		(height > max_supported_size) )		/*	2^n for later down-sampling)	*/
 	{
@@ -1258,9 +1250,11 @@ unsigned int
 		/*	are any MIPmaps desired?	*/
 		if( flags & SOIL_FLAG_MIPMAPS )
 		{
+			/*	each level is half the size of the previous one, rounded down
+				(like OpenGL expects of NPOT MIP-maps, and like mipmap_image makes them)	*/
 			int MIPlevel = 1;
-			int MIPwidth = (width+1) / 2;
-			int MIPheight = (height+1) / 2;
+			int MIPwidth = (width > 1) ? width / 2 : 1;
+			int MIPheight = (height > 1) ? height / 2 : 1;
 			unsigned char *resampled = (unsigned char*)malloc( channels*MIPwidth*MIPheight );
 			while( ((1<<MIPlevel) <= width) || ((1<<MIPlevel) <= height) )
 			{
@@ -1314,8 +1308,8 @@ unsigned int
 				}
 				/*	prep for the next level	*/
 				++MIPlevel;
-				MIPwidth = (MIPwidth + 1) / 2;
-				MIPheight = (MIPheight + 1) / 2;
+				MIPwidth = (MIPwidth > 1) ? MIPwidth / 2 : 1;
+				MIPheight = (MIPheight > 1) ? MIPheight / 2 : 1;
 			}
 			SOIL_free_image_data( resampled );
 			/*	instruct OpenGL to use the MIPmaps	*/
@@ -1704,8 +1698,14 @@ unsigned int SOIL_direct_load_DDS_from_memory(
 		mipmaps = 0;
 		DDS_full_size = DDS_main_size;
 	}
-	DDS_data = (unsigned char*)malloc( DDS_full_size );
-	/*	got the image data RAM, create or use an existing OpenGL texture handle	*/
+	/*	compressed data is uploaded straight from the buffer, only
+		uncompressed data needs a copy to swizzle	*/
+	DDS_data = NULL;
+	if( uncompressed )
+	{
+		DDS_data = (unsigned char*)malloc( DDS_full_size );
+	}
+	/*	create or use an existing OpenGL texture handle	*/
 	tex_ID = reuse_texture_ID;
 	if( tex_ID == 0 )
 	{
@@ -1719,7 +1719,13 @@ unsigned int SOIL_direct_load_DDS_from_memory(
 		if( buffer_index + DDS_full_size <= buffer_length )
 		{
 			unsigned int byte_offset = DDS_main_size;
-			memcpy( (void*)DDS_data, (const void*)(&buffer[buffer_index]), DDS_full_size );
+			if( uncompressed )
+			{
+				memcpy( (void*)DDS_data, (const void*)(&buffer[buffer_index]), DDS_full_size );
+			} else
+			{
+				DDS_data = (unsigned char*)(&buffer[buffer_index]);
+			}
 			buffer_index += DDS_full_size;
 			/*	upload the main chunk	*/
 			if( uncompressed )
@@ -1786,7 +1792,10 @@ unsigned int SOIL_direct_load_DDS_from_memory(
 			result_string_pointer = "DDS file was too small for expected image data";
 		}
 	}/* end reading each face */
-	SOIL_free_image_data( DDS_data );
+	if( uncompressed )
+	{
+		SOIL_free_image_data( DDS_data );
+	}
 	if( tex_ID )
 	{
 		/*	did I have MIPmaps?	*/
@@ -1875,10 +1884,14 @@ int query_NPOT_capability( void )
 	/*	check for the capability	*/
 	if( has_NPOT_capability == SOIL_CAPABILITY_UNKNOWN )
 	{
-		/*	we haven't yet checked for the capability, do so	*/
+		/*	we haven't yet checked for the capability, do so
+			(it's core since OpenGL 2.0)	*/
+		char const *version = (char const*)glGetString( GL_VERSION );
+		char const *extensions = (char const*)glGetString( GL_EXTENSIONS );
 		if(
-			(NULL == strstr( (char const*)glGetString( GL_EXTENSIONS ),
-				"GL_ARB_texture_non_power_of_two" ) )
+			((NULL == version) || (version[0] < '2') || (version[0] > '9')) &&
+			((NULL == extensions) || (NULL == strstr( extensions,
+				"GL_ARB_texture_non_power_of_two" ) ))
 			)
 		{
 			/*	not there, flag the failure	*/
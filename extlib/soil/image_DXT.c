@@ -13,12 +13,31 @@
 #include <string.h>
 #include <stdio.h>
 
+/*	the SSE2 path compresses 4 blocks at once, one per lane	*/
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define DXT_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <pthread.h>
+#include <unistd.h>
+#endif
+
 /*	set this =1 if you want to use the covarince matrix method...
 	which is better than my method of using standard deviations
 	overall, except on the infintesimal chance that the power
 	method fails for finding the largest eigenvector	*/
 #define USE_COV_MAT	1
 
+/*	images are split into rows of blocks across this many threads at most,
+	and each thread gets at least DXT_MIN_BLOCKS_PER_THREAD blocks	*/
+#define DXT_MAX_THREADS	16
+#define DXT_MIN_BLOCKS_PER_THREAD	1024
+
 /********* Function Prototypes *********/
 /*
 	Takes a 4x4 block of pixels and compresses it into 8 bytes
@@ -38,6 +57,37 @@ void compress_DDS_alpha_block(
 				const unsigned char *const uncompressed,
 				unsigned char compressed[8] );
 
+#if USE_COV_MAT && defined(DXT_SSE2)
+/*
+	The same as the two functions above for 4 consecutive blocks
+	(16*channels bytes each), writing every stride bytes.  All the
+	math is done in the same order, so the output is identical.
+*/
+static void compress_DDS_color_blocks_SSE2(
+				int channels,
+				const unsigned char *const uncompressed,
+				unsigned char *compressed, int stride );
+static void compress_DDS_alpha_blocks_SSE2(
+				const unsigned char *const uncompressed,
+				unsigned char *compressed, int stride );
+#endif
+
+/*	a range of block rows to compress, possibly on its own thread	*/
+typedef struct
+{
+	const unsigned char *uncompressed;
+	int width, height, channels;
+	int DXT5;
+	unsigned char *compressed;
+	int first_block_row, end_block_row;
+}
+DXT_job;
+
+static unsigned char* convert_image_to_DXT(
+		const unsigned char *const uncompressed,
+		int width, int height, int channels,
+		int DXT5, int *out_size );
+
 /********* Actual Exposed Functions *********/
 int
 	save_image_as_DDS
@@ -103,172 +153,250 @@ unsigned char* convert_image_to_DXT1(
 		int width, int height, int channels,
 		int *out_size )
 {
-	unsigned char *compressed;
-	int i, j, x, y;
-	unsigned char ublock[16*3];
-	unsigned char cblock[8];
-	int index = 0, chan_step = 1;
-	int block_count = 0;
-	/*	error check	*/
-	*out_size = 0;
-	if( (width < 1) || (height < 1) ||
-		(NULL == uncompressed) ||
-		(channels < 1) || (channels > 4) )
-	{
-		return NULL;
-	}
+	return convert_image_to_DXT( uncompressed, width, height, channels, 0, out_size );
+}
+
+unsigned char* convert_image_to_DXT5(
+		const unsigned char *const uncompressed,
+		int width, int height, int channels,
+		int *out_size )
+{
+	return convert_image_to_DXT( uncompressed, width, height, channels, 1, out_size );
+}
+
+/********* Block Row Compression *********/
+/*
+	Copies the 4x4 block at (i,j) into ublock as RGB (DXT1) or RGBA
+	(DXT5), filling the pixels outside the image with the first one.
+*/
+static void get_DDS_block(
+		const unsigned char *const uncompressed,
+		int width, int height, int channels,
+		int i, int j, int DXT5,
+		unsigned char *ublock )
+{
+	const int block_channels = 3 + DXT5;
+	int x, y, c, idx = 0;
+	int mx = 4, my = 4;
+	int chan_step = 1, has_alpha;
 	/*	for channels == 1 or 2, I do not step forward for R,G,B values	*/
 	if( channels < 3 )
 	{
 		chan_step = 0;
 	}
-	/*	get the RAM for the compressed image
-		(8 bytes per 4x4 pixel block)	*/
-	*out_size = ((width+3) >> 2) * ((height+3) >> 2) * 8;
-	compressed = (unsigned char*)malloc( *out_size );
-	/*	go through each block	*/
-	for( j = 0; j < height; j += 4 )
+	/*	# channels = 1 or 3 have no alpha, 2 & 4 do have alpha	*/
+	has_alpha = 1 - (channels & 1);
+	if( j+4 >= height )
+	{
+		my = height - j;
+	}
+	if( i+4 >= width )
 	{
-		for( i = 0; i < width; i += 4 )
+		mx = width - i;
+	}
+	for( y = 0; y < my; ++y )
+	{
+		const unsigned char *pixel = uncompressed + ((j+y)*width + i)*channels;
+		for( x = 0; x < mx; ++x )
 		{
-			/*	copy this block into a new one	*/
-			int idx = 0;
-			int mx = 4, my = 4;
-			if( j+4 >= height )
+			ublock[idx++] = pixel[0];
+			ublock[idx++] = pixel[chan_step];
+			ublock[idx++] = pixel[chan_step+chan_step];
+			if( DXT5 )
 			{
-				my = height - j;
+				ublock[idx++] = has_alpha * pixel[channels-1] + (1-has_alpha)*255;
 			}
-			if( i+4 >= width )
+			pixel += channels;
+		}
+		for( x = mx; x < 4; ++x )
+		{
+			for( c = 0; c < block_channels; ++c )
 			{
-				mx = width - i;
+				ublock[idx++] = ublock[c];
 			}
-			for( y = 0; y < my; ++y )
+		}
+	}
+	for( y = my; y < 4; ++y )
+	{
+		for( x = 0; x < 4; ++x )
+		{
+			for( c = 0; c < block_channels; ++c )
+			{
+				ublock[idx++] = ublock[c];
+			}
+		}
+	}
+}
+
+static void compress_DXT_block_rows( DXT_job *job )
+{
+	const int blocks_x = (job->width + 3) >> 2;
+	const int block_bytes = job->DXT5 ? 16 : 8;
+	const int block_size = 16 * (3 + job->DXT5);
+	unsigned char ublock[4*16*4];
+	int row, i;
+	for( row = job->first_block_row; row < job->end_block_row; ++row )
+	{
+		unsigned char *compressed = job->compressed + row * blocks_x * block_bytes;
+		i = 0;
+		#if USE_COV_MAT && defined(DXT_SSE2)
+		for( ; i + 4 <= blocks_x; i += 4 )
+		{
+			int b;
+			for( b = 0; b < 4; ++b )
 			{
-				for( x = 0; x < mx; ++x )
-				{
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels];
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels+chan_step];
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels+chan_step+chan_step];
-				}
-				for( x = mx; x < 4; ++x )
-				{
-					ublock[idx++] = ublock[0];
-					ublock[idx++] = ublock[1];
-					ublock[idx++] = ublock[2];
-				}
+				get_DDS_block( job->uncompressed, job->width, job->height, job->channels,
+						(i + b) * 4, row * 4, job->DXT5, ublock + b * block_size );
 			}
-			for( y = my; y < 4; ++y )
+			if( job->DXT5 )
 			{
-				for( x = 0; x < 4; ++x )
-				{
-					ublock[idx++] = ublock[0];
-					ublock[idx++] = ublock[1];
-					ublock[idx++] = ublock[2];
-				}
+				compress_DDS_alpha_blocks_SSE2( ublock, compressed, 16 );
+				compress_DDS_color_blocks_SSE2( 4, ublock, compressed + 8, 16 );
+			} else
+			{
+				compress_DDS_color_blocks_SSE2( 3, ublock, compressed, 8 );
 			}
-			/*	compress the block	*/
-			++block_count;
-			compress_DDS_color_block( 3, ublock, cblock );
-			/*	copy the data from the block into the main block	*/
-			for( x = 0; x < 8; ++x )
+			compressed += 4 * block_bytes;
+		}
+		#endif
+		for( ; i < blocks_x; ++i )
+		{
+			get_DDS_block( job->uncompressed, job->width, job->height, job->channels,
+					i * 4, row * 4, job->DXT5, ublock );
+			if( job->DXT5 )
 			{
-				compressed[index++] = cblock[x];
+				/*	the alpha block comes first	*/
+				compress_DDS_alpha_block( ublock, compressed );
+				compress_DDS_color_block( 4, ublock, compressed + 8 );
+			} else
+			{
+				compress_DDS_color_block( 3, ublock, compressed );
 			}
+			compressed += block_bytes;
 		}
 	}
-	return compressed;
 }
 
-unsigned char* convert_image_to_DXT5(
+static int get_DXT_thread_count( void )
+{
+	int count;
+	#ifdef _WIN32
+	SYSTEM_INFO info;
+	GetSystemInfo( &info );
+	count = (int)info.dwNumberOfProcessors;
+	#else
+	count = (int)sysconf( _SC_NPROCESSORS_ONLN );
+	#endif
+	if( count < 1 )
+	{
+		count = 1;
+	} else if( count > DXT_MAX_THREADS )
+	{
+		count = DXT_MAX_THREADS;
+	}
+	return count;
+}
+
+#ifdef _WIN32
+static DWORD WINAPI DXT_thread_proc( LPVOID job )
+{
+	compress_DXT_block_rows( (DXT_job*)job );
+	return 0;
+}
+#else
+static void* DXT_thread_proc( void *job )
+{
+	compress_DXT_block_rows( (DXT_job*)job );
+	return NULL;
+}
+#endif
+
+/*
+	Compresses the image one row of blocks at a time, splitting
+	the rows between threads when there are enough blocks.
+*/
+static unsigned char* convert_image_to_DXT(
 		const unsigned char *const uncompressed,
 		int width, int height, int channels,
-		int *out_size )
+		int DXT5, int *out_size )
 {
 	unsigned char *compressed;
-	int i, j, x, y;
-	unsigned char ublock[16*4];
-	unsigned char cblock[8];
-	int index = 0, chan_step = 1;
-	int block_count = 0, has_alpha;
+	DXT_job jobs[DXT_MAX_THREADS];
+	#ifdef _WIN32
+	HANDLE threads[DXT_MAX_THREADS];
+	#else
+	pthread_t threads[DXT_MAX_THREADS];
+	#endif
+	int started[DXT_MAX_THREADS];
+	int blocks_x, blocks_y, num_threads, t;
 	/*	error check	*/
 	*out_size = 0;
 	if( (width < 1) || (height < 1) ||
 		(NULL == uncompressed) ||
-		(channels < 1) || ( channels > 4) )
+		(channels < 1) || (channels > 4) )
 	{
 		return NULL;
 	}
-	/*	for channels == 1 or 2, I do not step forward for R,G,B vales	*/
-	if( channels < 3 )
+	/*	get the RAM for the compressed image
+		(8 bytes per 4x4 pixel block for DXT1, 16 for DXT5)	*/
+	blocks_x = (width+3) >> 2;
+	blocks_y = (height+3) >> 2;
+	compressed = (unsigned char*)malloc( blocks_x * blocks_y * (DXT5 ? 16 : 8) );
+	if( NULL == compressed )
 	{
-		chan_step = 0;
+		return NULL;
 	}
-	/*	# channels = 1 or 3 have no alpha, 2 & 4 do have alpha	*/
-	has_alpha = 1 - (channels & 1);
-	/*	get the RAM for the compressed image
-		(16 bytes per 4x4 pixel block)	*/
-	*out_size = ((width+3) >> 2) * ((height+3) >> 2) * 16;
-	compressed = (unsigned char*)malloc( *out_size );
-	/*	go through each block	*/
-	for( j = 0; j < height; j += 4 )
+	*out_size = blocks_x * blocks_y * (DXT5 ? 16 : 8);
+	/*	how many threads are worth starting	*/
+	num_threads = get_DXT_thread_count();
+	if( num_threads > blocks_x * blocks_y / DXT_MIN_BLOCKS_PER_THREAD )
+	{
+		num_threads = blocks_x * blocks_y / DXT_MIN_BLOCKS_PER_THREAD;
+	}
+	if( num_threads > blocks_y )
+	{
+		num_threads = blocks_y;
+	}
+	if( num_threads < 1 )
+	{
+		num_threads = 1;
+	}
+	for( t = 0; t < num_threads; ++t )
+	{
+		jobs[t].uncompressed = uncompressed;
+		jobs[t].width = width;
+		jobs[t].height = height;
+		jobs[t].channels = channels;
+		jobs[t].DXT5 = DXT5;
+		jobs[t].compressed = compressed;
+		jobs[t].first_block_row = blocks_y * t / num_threads;
+		jobs[t].end_block_row = blocks_y * (t + 1) / num_threads;
+	}
+	/*	this thread does the first share, and any a thread couldn't be started for	*/
+	for( t = 1; t < num_threads; ++t )
 	{
-		for( i = 0; i < width; i += 4 )
+		#ifdef _WIN32
+		threads[t] = CreateThread( NULL, 0, DXT_thread_proc, &jobs[t], 0, NULL );
+		started[t] = (NULL != threads[t]);
+		#else
+		started[t] = (0 == pthread_create( &threads[t], NULL, DXT_thread_proc, &jobs[t] ));
+		#endif
+		if( !started[t] )
 		{
-			/*	local variables, and my block counter	*/
-			int idx = 0;
-			int mx = 4, my = 4;
-			if( j+4 >= height )
-			{
-				my = height - j;
-			}
-			if( i+4 >= width )
-			{
-				mx = width - i;
-			}
-			for( y = 0; y < my; ++y )
-			{
-				for( x = 0; x < mx; ++x )
-				{
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels];
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels+chan_step];
-					ublock[idx++] = uncompressed[(j+y)*width*channels+(i+x)*channels+chan_step+chan_step];
-					ublock[idx++] =
-						has_alpha * uncompressed[(j+y)*width*channels+(i+x)*channels+channels-1]
-						+ (1-has_alpha)*255;
-				}
-				for( x = mx; x < 4; ++x )
-				{
-					ublock[idx++] = ublock[0];
-					ublock[idx++] = ublock[1];
-					ublock[idx++] = ublock[2];
-					ublock[idx++] = ublock[3];
-				}
-			}
-			for( y = my; y < 4; ++y )
-			{
-				for( x = 0; x < 4; ++x )
-				{
-					ublock[idx++] = ublock[0];
-					ublock[idx++] = ublock[1];
-					ublock[idx++] = ublock[2];
-					ublock[idx++] = ublock[3];
-				}
-			}
-			/*	now compress the alpha block	*/
-			compress_DDS_alpha_block( ublock, cblock );
-			/*	copy the data from the compressed alpha block into the main buffer	*/
-			for( x = 0; x < 8; ++x )
-			{
-				compressed[index++] = cblock[x];
-			}
-			/*	then compress the color block	*/
-			++block_count;
-			compress_DDS_color_block( 4, ublock, cblock );
-			/*	copy the data from the compressed color block into the main buffer	*/
-			for( x = 0; x < 8; ++x )
-			{
-				compressed[index++] = cblock[x];
-			}
+			compress_DXT_block_rows( &jobs[t] );
+		}
+	}
+	compress_DXT_block_rows( &jobs[0] );
+	for( t = 1; t < num_threads; ++t )
+	{
+		if( started[t] )
+		{
+			#ifdef _WIN32
+			WaitForSingleObject( threads[t], INFINITE );
+			CloseHandle( threads[t] );
+			#else
+			pthread_join( threads[t], NULL );
+			#endif
 		}
 	}
 	return compressed;
@@ -630,3 +758,234 @@ void
 	}
 	/*	done compressing to DXT1	*/
 }
+
+#if USE_COV_MAT && defined(DXT_SSE2)
+/*	clamps each lane to [lo,hi] with SSE2 compares	*/
+static __m128i clamp_epi32_SSE2( __m128i v, int lo, int hi )
+{
+	const __m128i vlo = _mm_set1_epi32( lo );
+	const __m128i vhi = _mm_set1_epi32( hi );
+	__m128i mask = _mm_cmplt_epi32( v, vlo );
+	v = _mm_or_si128( _mm_andnot_si128( mask, v ), _mm_and_si128( mask, vlo ) );
+	mask = _mm_cmpgt_epi32( v, vhi );
+	return _mm_or_si128( _mm_andnot_si128( mask, v ), _mm_and_si128( mask, vhi ) );
+}
+
+/*	convert_bit_range for lanes small enough to multiply in 16 bits	*/
+static __m128i convert_bit_range_SSE2( __m128i c, int from_bits, int to_bits )
+{
+	__m128i b = _mm_add_epi32( _mm_set1_epi32( 1 << (from_bits - 1) ),
+			_mm_mullo_epi16( c, _mm_set1_epi32( (1 << to_bits) - 1 ) ) );
+	b = _mm_add_epi32( b, _mm_srli_epi32( b, from_bits ) );
+	return _mm_srli_epi32( b, from_bits );
+}
+
+static void
+	compress_DDS_color_blocks_SSE2
+	(
+		int channels,
+		const unsigned char *const uncompressed,
+		unsigned char *compressed, int stride
+	)
+{
+	const int block_size = 16 * channels;
+	const unsigned char *const u0 = uncompressed;
+	const unsigned char *const u1 = uncompressed + block_size;
+	const unsigned char *const u2 = uncompressed + 2*block_size;
+	const unsigned char *const u3 = uncompressed + 3*block_size;
+	const int swizzle4[] = { 0, 2, 3, 1 };
+	__m128 r[16], g[16], b[16];
+	__m128 sum_r, sum_g, sum_b;
+	__m128 sum_rr, sum_gg, sum_bb, sum_rg, sum_rb, sum_gb;
+	__m128 dir_r, dir_g, dir_b, next_r, next_g, next_b;
+	__m128 vec_len2, dot, dot_min, dot_max, sixteen;
+	__m128i c0[3], c1[3], enc_c0, enc_c1, mask;
+	__m128 line[3], dot_offset;
+	int enc0[4], enc1[4], values[16][4];
+	int i, k;
+	/*	transpose the blocks so that each lane holds one of them	*/
+	for( i = 0; i < 16; ++i )
+	{
+		const int o = i * channels;
+		r[i] = _mm_setr_ps( u0[o+0], u1[o+0], u2[o+0], u3[o+0] );
+		g[i] = _mm_setr_ps( u0[o+1], u1[o+1], u2[o+1], u3[o+1] );
+		b[i] = _mm_setr_ps( u0[o+2], u1[o+2], u2[o+2], u3[o+2] );
+	}
+	/*	compute_color_line_STDEV: the covariance matrix...	*/
+	sum_r = sum_g = sum_b = _mm_setzero_ps();
+	sum_rr = sum_gg = sum_bb = sum_rg = sum_rb = sum_gb = _mm_setzero_ps();
+	for( i = 0; i < 16; ++i )
+	{
+		sum_r = _mm_add_ps( sum_r, r[i] );
+		sum_rr = _mm_add_ps( sum_rr, _mm_mul_ps( r[i], r[i] ) );
+		sum_g = _mm_add_ps( sum_g, g[i] );
+		sum_gg = _mm_add_ps( sum_gg, _mm_mul_ps( g[i], g[i] ) );
+		sum_b = _mm_add_ps( sum_b, b[i] );
+		sum_bb = _mm_add_ps( sum_bb, _mm_mul_ps( b[i], b[i] ) );
+		sum_rg = _mm_add_ps( sum_rg, _mm_mul_ps( r[i], g[i] ) );
+		sum_rb = _mm_add_ps( sum_rb, _mm_mul_ps( r[i], b[i] ) );
+		sum_gb = _mm_add_ps( sum_gb, _mm_mul_ps( g[i], b[i] ) );
+	}
+	sum_r = _mm_mul_ps( sum_r, _mm_set1_ps( 1.0f / 16.0f ) );
+	sum_g = _mm_mul_ps( sum_g, _mm_set1_ps( 1.0f / 16.0f ) );
+	sum_b = _mm_mul_ps( sum_b, _mm_set1_ps( 1.0f / 16.0f ) );
+	sixteen = _mm_set1_ps( 16.0f );
+	sum_rr = _mm_sub_ps( sum_rr, _mm_mul_ps( _mm_mul_ps( sixteen, sum_r ), sum_r ) );
+	sum_gg = _mm_sub_ps( sum_gg, _mm_mul_ps( _mm_mul_ps( sixteen, sum_g ), sum_g ) );
+	sum_bb = _mm_sub_ps( sum_bb, _mm_mul_ps( _mm_mul_ps( sixteen, sum_b ), sum_b ) );
+	sum_rg = _mm_sub_ps( sum_rg, _mm_mul_ps( _mm_mul_ps( sixteen, sum_r ), sum_g ) );
+	sum_rb = _mm_sub_ps( sum_rb, _mm_mul_ps( _mm_mul_ps( sixteen, sum_r ), sum_b ) );
+	sum_gb = _mm_sub_ps( sum_gb, _mm_mul_ps( _mm_mul_ps( sixteen, sum_g ), sum_b ) );
+	/*	...and 3 iterations of the power method	*/
+	dir_r = _mm_set1_ps( 1.0f );
+	dir_g = _mm_set1_ps( 2.718281828f );
+	dir_b = _mm_set1_ps( 3.141592654f );
+	for( i = 0; i < 3; ++i )
+	{
+		next_r = _mm_add_ps( _mm_add_ps( _mm_mul_ps( dir_r, sum_rr ), _mm_mul_ps( dir_g, sum_rg ) ), _mm_mul_ps( dir_b, sum_rb ) );
+		next_g = _mm_add_ps( _mm_add_ps( _mm_mul_ps( dir_r, sum_rg ), _mm_mul_ps( dir_g, sum_gg ) ), _mm_mul_ps( dir_b, sum_gb ) );
+		next_b = _mm_add_ps( _mm_add_ps( _mm_mul_ps( dir_r, sum_rb ), _mm_mul_ps( dir_g, sum_gb ) ), _mm_mul_ps( dir_b, sum_bb ) );
+		dir_r = next_r;
+		dir_g = next_g;
+		dir_b = next_b;
+	}
+	/*	LSE_master_colors_max_min	*/
+	vec_len2 = _mm_div_ps( _mm_set1_ps( 1.0f ), _mm_add_ps( _mm_add_ps( _mm_add_ps( _mm_set1_ps( 0.00001f ),
+			_mm_mul_ps( dir_r, dir_r ) ), _mm_mul_ps( dir_g, dir_g ) ), _mm_mul_ps( dir_b, dir_b ) ) );
+	dot_min = dot_max = _mm_add_ps( _mm_add_ps( _mm_mul_ps( dir_r, r[0] ), _mm_mul_ps( dir_g, g[0] ) ), _mm_mul_ps( dir_b, b[0] ) );
+	for( i = 1; i < 16; ++i )
+	{
+		dot = _mm_add_ps( _mm_add_ps( _mm_mul_ps( dir_r, r[i] ), _mm_mul_ps( dir_g, g[i] ) ), _mm_mul_ps( dir_b, b[i] ) );
+		dot_min = _mm_min_ps( dot_min, dot );
+		dot_max = _mm_max_ps( dot_max, dot );
+	}
+	dot = _mm_add_ps( _mm_add_ps( _mm_mul_ps( dir_r, sum_r ), _mm_mul_ps( dir_g, sum_g ) ), _mm_mul_ps( dir_b, sum_b ) );
+	dot_min = _mm_mul_ps( _mm_sub_ps( dot_min, dot ), vec_len2 );
+	dot_max = _mm_mul_ps( _mm_sub_ps( dot_max, dot ), vec_len2 );
+	c0[0] = clamp_epi32_SSE2( _mm_cvttps_epi32( _mm_add_ps( _mm_add_ps( _mm_set1_ps( 0.5f ), sum_r ), _mm_mul_ps( dot_max, dir_r ) ) ), 0, 255 );
+	c0[1] = clamp_epi32_SSE2( _mm_cvttps_epi32( _mm_add_ps( _mm_add_ps( _mm_set1_ps( 0.5f ), sum_g ), _mm_mul_ps( dot_max, dir_g ) ) ), 0, 255 );
+	c0[2] = clamp_epi32_SSE2( _mm_cvttps_epi32( _mm_add_ps( _mm_add_ps( _mm_set1_ps( 0.5f ), sum_b ), _mm_mul_ps( dot_max, dir_b ) ) ), 0, 255 );
+	c1[0] = clamp_epi32_SSE2( _mm_cvttps_epi32( _mm_add_ps( _mm_add_ps( _mm_set1_ps( 0.5f ), sum_r ), _mm_mul_ps( dot_min, dir_r ) ) ), 0, 255 );
+	c1[1] = clamp_epi32_SSE2( _mm_cvttps_epi32( _mm_add_ps( _mm_add_ps( _mm_set1_ps( 0.5f ), sum_g ), _mm_mul_ps( dot_min, dir_g ) ) ), 0, 255 );
+	c1[2] = clamp_epi32_SSE2( _mm_cvttps_epi32( _mm_add_ps( _mm_add_ps( _mm_set1_ps( 0.5f ), sum_b ), _mm_mul_ps( dot_min, dir_b ) ) ), 0, 255 );
+	/*	down sample to 565, the larger one is color 0	*/
+	enc_c0 = _mm_or_si128( _mm_or_si128(
+			_mm_slli_epi32( convert_bit_range_SSE2( c0[0], 8, 5 ), 11 ),
+			_mm_slli_epi32( convert_bit_range_SSE2( c0[1], 8, 6 ), 5 ) ),
+			convert_bit_range_SSE2( c0[2], 8, 5 ) );
+	enc_c1 = _mm_or_si128( _mm_or_si128(
+			_mm_slli_epi32( convert_bit_range_SSE2( c1[0], 8, 5 ), 11 ),
+			_mm_slli_epi32( convert_bit_range_SSE2( c1[1], 8, 6 ), 5 ) ),
+			convert_bit_range_SSE2( c1[2], 8, 5 ) );
+	mask = _mm_cmpgt_epi32( enc_c0, enc_c1 );
+	c0[0] = _mm_or_si128( _mm_and_si128( mask, enc_c0 ), _mm_andnot_si128( mask, enc_c1 ) );
+	enc_c1 = _mm_or_si128( _mm_and_si128( mask, enc_c1 ), _mm_andnot_si128( mask, enc_c0 ) );
+	enc_c0 = c0[0];
+	/*	compress_DDS_color_block: reconstitute the master colors	*/
+	c0[0] = convert_bit_range_SSE2( _mm_and_si128( _mm_srli_epi32( enc_c0, 11 ), _mm_set1_epi32( 31 ) ), 5, 8 );
+	c0[1] = convert_bit_range_SSE2( _mm_and_si128( _mm_srli_epi32( enc_c0, 5 ), _mm_set1_epi32( 63 ) ), 6, 8 );
+	c0[2] = convert_bit_range_SSE2( _mm_and_si128( enc_c0, _mm_set1_epi32( 31 ) ), 5, 8 );
+	c1[0] = convert_bit_range_SSE2( _mm_and_si128( _mm_srli_epi32( enc_c1, 11 ), _mm_set1_epi32( 31 ) ), 5, 8 );
+	c1[1] = convert_bit_range_SSE2( _mm_and_si128( _mm_srli_epi32( enc_c1, 5 ), _mm_set1_epi32( 63 ) ), 6, 8 );
+	c1[2] = convert_bit_range_SSE2( _mm_and_si128( enc_c1, _mm_set1_epi32( 31 ) ), 5, 8 );
+	vec_len2 = _mm_setzero_ps();
+	for( k = 0; k < 3; ++k )
+	{
+		line[k] = _mm_cvtepi32_ps( _mm_sub_epi32( c1[k], c0[k] ) );
+		vec_len2 = _mm_add_ps( vec_len2, _mm_mul_ps( line[k], line[k] ) );
+	}
+	mask = _mm_castps_si128( _mm_cmpgt_ps( vec_len2, _mm_setzero_ps() ) );
+	vec_len2 = _mm_or_ps(
+			_mm_and_ps( _mm_castsi128_ps( mask ), _mm_div_ps( _mm_set1_ps( 1.0f ), vec_len2 ) ),
+			_mm_andnot_ps( _mm_castsi128_ps( mask ), vec_len2 ) );
+	for( k = 0; k < 3; ++k )
+	{
+		line[k] = _mm_mul_ps( line[k], vec_len2 );
+	}
+	dot_offset = _mm_add_ps( _mm_add_ps(
+			_mm_mul_ps( line[0], _mm_cvtepi32_ps( c0[0] ) ),
+			_mm_mul_ps( line[1], _mm_cvtepi32_ps( c0[1] ) ) ),
+			_mm_mul_ps( line[2], _mm_cvtepi32_ps( c0[2] ) ) );
+	for( i = 0; i < 16; ++i )
+	{
+		dot = _mm_sub_ps( _mm_add_ps( _mm_add_ps( _mm_mul_ps( line[0], r[i] ), _mm_mul_ps( line[1], g[i] ) ),
+				_mm_mul_ps( line[2], b[i] ) ), dot_offset );
+		dot = _mm_add_ps( _mm_mul_ps( dot, _mm_set1_ps( 3.0f ) ), _mm_set1_ps( 0.5f ) );
+		_mm_storeu_si128( (__m128i*)values[i], clamp_epi32_SSE2( _mm_cvttps_epi32( dot ), 0, 3 ) );
+	}
+	/*	store each block	*/
+	_mm_storeu_si128( (__m128i*)enc0, enc_c0 );
+	_mm_storeu_si128( (__m128i*)enc1, enc_c1 );
+	for( k = 0; k < 4; ++k )
+	{
+		unsigned char *out = compressed + k * stride;
+		unsigned int bits = 0;
+		out[0] = (enc0[k] >> 0) & 255;
+		out[1] = (enc0[k] >> 8) & 255;
+		out[2] = (enc1[k] >> 0) & 255;
+		out[3] = (enc1[k] >> 8) & 255;
+		for( i = 0; i < 16; ++i )
+		{
+			bits |= (unsigned int)swizzle4[ values[i][k] ] << (2*i);
+		}
+		out[4] = (bits >> 0) & 255;
+		out[5] = (bits >> 8) & 255;
+		out[6] = (bits >> 16) & 255;
+		out[7] = (bits >> 24) & 255;
+	}
+}
+
+static void
+	compress_DDS_alpha_blocks_SSE2
+	(
+		const unsigned char *const uncompressed,
+		unsigned char *compressed, int stride
+	)
+{
+	const int swizzle8[] = { 1, 7, 6, 5, 4, 3, 2, 0 };
+	__m128i alpha[16], a0, a1;
+	__m128 scale_me;
+	int lo[4], hi[4], values[16][4];
+	int i, k;
+	for( i = 0; i < 16; ++i )
+	{
+		const int o = i*4 + 3;
+		alpha[i] = _mm_setr_epi32( uncompressed[o], uncompressed[64+o], uncompressed[128+o], uncompressed[192+o] );
+	}
+	/*	get the alpha limits (a0 > a1)	*/
+	a0 = a1 = alpha[0];
+	for( i = 1; i < 16; ++i )
+	{
+		/*	the values fit in 16 bits	*/
+		a0 = _mm_max_epi16( a0, alpha[i] );
+		a1 = _mm_min_epi16( a1, alpha[i] );
+	}
+	scale_me = _mm_div_ps( _mm_set1_ps( 7.9999f ), _mm_cvtepi32_ps( _mm_sub_epi32( a0, a1 ) ) );
+	for( i = 0; i < 16; ++i )
+	{
+		__m128i value = _mm_cvttps_epi32( _mm_mul_ps( _mm_cvtepi32_ps( _mm_sub_epi32( alpha[i], a1 ) ), scale_me ) );
+		_mm_storeu_si128( (__m128i*)values[i], _mm_and_si128( value, _mm_set1_epi32( 7 ) ) );
+	}
+	_mm_storeu_si128( (__m128i*)hi, a0 );
+	_mm_storeu_si128( (__m128i*)lo, a1 );
+	for( k = 0; k < 4; ++k )
+	{
+		unsigned char *out = compressed + k * stride;
+		unsigned int bits_lo = 0, bits_hi = 0;
+		out[0] = hi[k];
+		out[1] = lo[k];
+		/*	8 values of 3 bits in each half	*/
+		for( i = 0; i < 8; ++i )
+		{
+			bits_lo |= (unsigned int)swizzle8[ values[i][k] ] << (3*i);
+			bits_hi |= (unsigned int)swizzle8[ values[i+8][k] ] << (3*i);
+		}
+		out[2] = (bits_lo >> 0) & 255;
+		out[3] = (bits_lo >> 8) & 255;
+		out[4] = (bits_lo >> 16) & 255;
+		out[5] = (bits_hi >> 0) & 255;
+		out[6] = (bits_hi >> 8) & 255;
+		out[7] = (bits_hi >> 16) & 255;
+	}
+}
+#endif
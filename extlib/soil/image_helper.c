@@ -8,8 +8,735 @@
 
 #include "image_helper.h"
 #include <stdlib.h>
+#include <string.h>
 #include <math.h>
 
+/*
+	SSE2 versions of the resampling and color space loops, with AVX2 variants
+	picked at run time.  They write exactly the same bytes as the scalar code:
+	the mipmap sums and YCoCg are integers, and the bilinear filter and RGBE
+	do the same single precision operations in the same order, just on several
+	channels or pixels at once.
+*/
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && (_M_IX86_FP >= 2))
+#define IMAGE_HELPER_SSE2
+#include <emmintrin.h>
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define IMAGE_HELPER_AVX2
+#include <immintrin.h>
+#define IMAGE_HELPER_TARGET_AVX2 __attribute__((target("avx2")))
+#endif
+#endif
+
+#ifdef IMAGE_HELPER_SSE2
+
+#ifdef IMAGE_HELPER_AVX2
+static int has_AVX2( void )
+{
+	static int supported = -1;
+	if( supported < 0 )
+	{
+		__builtin_cpu_init();
+		supported = __builtin_cpu_supports( "avx2" ) ? 1 : 0;
+	}
+	return supported;
+}
+#endif
+
+/*	loads the 4 bytes of an RGBA pixel as floats	*/
+static __m128 load_RGBA_ps( const unsigned char* pixel )
+{
+	const __m128i zero = _mm_setzero_si128();
+	int packed;
+	__m128i v;
+	memcpy( &packed, pixel, 4 );
+	v = _mm_cvtsi32_si128( packed );
+	v = _mm_unpacklo_epi8( v, zero );
+	v = _mm_unpacklo_epi16( v, zero );
+	return _mm_cvtepi32_ps( v );
+}
+
+static void up_scale_row_RGBA_SSE2
+	(
+		const unsigned char* row0, const unsigned char* row1,
+		const int* offsets, const float* fractions, float sampley,
+		unsigned char* out, int resampled_width
+	)
+{
+	const __m128 sy = _mm_set1_ps( sampley );
+	const __m128 isy = _mm_set1_ps( 1.0f - sampley );
+	const __m128 half = _mm_set1_ps( 0.5f );
+	int x;
+	for( x = 0; x < resampled_width; ++x )
+	{
+		const int o = offsets[x];
+		const __m128 sx = _mm_set1_ps( fractions[x] );
+		const __m128 isx = _mm_set1_ps( 1.0f - fractions[x] );
+		__m128 value = half;
+		__m128i result;
+		int packed;
+		value = _mm_add_ps( value, _mm_mul_ps( _mm_mul_ps( load_RGBA_ps( row0 + o ), isx ), isy ) );
+		value = _mm_add_ps( value, _mm_mul_ps( _mm_mul_ps( load_RGBA_ps( row0 + o + 4 ), sx ), isy ) );
+		value = _mm_add_ps( value, _mm_mul_ps( _mm_mul_ps( load_RGBA_ps( row1 + o ), isx ), sy ) );
+		value = _mm_add_ps( value, _mm_mul_ps( _mm_mul_ps( load_RGBA_ps( row1 + o + 4 ), sx ), sy ) );
+		result = _mm_cvttps_epi32( value );
+		result = _mm_packs_epi32( result, result );
+		result = _mm_packus_epi16( result, result );
+		packed = _mm_cvtsi128_si32( result );
+		memcpy( out + x*4, &packed, 4 );
+	}
+}
+
+#ifdef IMAGE_HELPER_AVX2
+/*	loads two RGBA pixels as 8 floats	*/
+IMAGE_HELPER_TARGET_AVX2
+static __m256 load_RGBA_pair_ps( const unsigned char* pixel0, const unsigned char* pixel1 )
+{
+	int packed0, packed1;
+	__m128i v;
+	memcpy( &packed0, pixel0, 4 );
+	memcpy( &packed1, pixel1, 4 );
+	v = _mm_unpacklo_epi32( _mm_cvtsi32_si128( packed0 ), _mm_cvtsi32_si128( packed1 ) );
+	return _mm256_cvtepi32_ps( _mm256_cvtepu8_epi32( v ) );
+}
+
+IMAGE_HELPER_TARGET_AVX2
+static void up_scale_row_RGBA_AVX2
+	(
+		const unsigned char* row0, const unsigned char* row1,
+		const int* offsets, const float* fractions, float sampley,
+		unsigned char* out, int resampled_width
+	)
+{
+	const __m256 sy = _mm256_set1_ps( sampley );
+	const __m256 isy = _mm256_set1_ps( 1.0f - sampley );
+	const __m256 half = _mm256_set1_ps( 0.5f );
+	int x;
+	for( x = 0; x + 2 <= resampled_width; x += 2 )
+	{
+		const int o0 = offsets[x], o1 = offsets[x+1];
+		const float f0 = fractions[x], f1 = fractions[x+1];
+		const __m256 sx = _mm256_setr_ps( f0, f0, f0, f0, f1, f1, f1, f1 );
+		const __m256 isx = _mm256_setr_ps(
+			1.0f - f0, 1.0f - f0, 1.0f - f0, 1.0f - f0,
+			1.0f - f1, 1.0f - f1, 1.0f - f1, 1.0f - f1 );
+		__m256 value = half;
+		__m256i rounded;
+		__m128i result;
+		value = _mm256_add_ps( value, _mm256_mul_ps( _mm256_mul_ps(
+			load_RGBA_pair_ps( row0 + o0, row0 + o1 ), isx ), isy ) );
+		value = _mm256_add_ps( value, _mm256_mul_ps( _mm256_mul_ps(
+			load_RGBA_pair_ps( row0 + o0 + 4, row0 + o1 + 4 ), sx ), isy ) );
+		value = _mm256_add_ps( value, _mm256_mul_ps( _mm256_mul_ps(
+			load_RGBA_pair_ps( row1 + o0, row1 + o1 ), isx ), sy ) );
+		value = _mm256_add_ps( value, _mm256_mul_ps( _mm256_mul_ps(
+			load_RGBA_pair_ps( row1 + o0 + 4, row1 + o1 + 4 ), sx ), sy ) );
+		rounded = _mm256_cvttps_epi32( value );
+		result = _mm_packs_epi32( _mm256_castsi256_si128( rounded ), _mm256_extracti128_si256( rounded, 1 ) );
+		result = _mm_packus_epi16( result, result );
+		_mm_storel_epi64( (__m128i*)(out + x*4), result );
+	}
+	if( x < resampled_width )
+	{
+		up_scale_row_RGBA_SSE2( row0, row1, offsets + x, fractions + x, sampley, out + x*4, resampled_width - x );
+	}
+}
+#endif
+
+/*	bilinear upscale of an RGBA image with at least 2x2 pixels	*/
+static int up_scale_image_RGBA_SIMD
+	(
+		const unsigned char* const orig,
+		int width, int height,
+		unsigned char* resampled,
+		int resampled_width, int resampled_height
+	)
+{
+	float dx, dy;
+	int x, y;
+	int *offsets;
+	float *fractions;
+	offsets = (int*)malloc( resampled_width * sizeof(int) );
+	fractions = (float*)malloc( resampled_width * sizeof(float) );
+	if( (NULL == offsets) || (NULL == fractions) )
+	{
+		free( offsets );
+		free( fractions );
+		return 0;
+	}
+	/*	the x sample positions are the same for every row	*/
+	dx = (width - 1.0f) / (resampled_width - 1.0f);
+	dy = (height - 1.0f) / (resampled_height - 1.0f);
+	for( x = 0; x < resampled_width; ++x )
+	{
+		float samplex = x * dx;
+		int intx = (int)samplex;
+		if( intx > width - 2 ) { intx = width - 2; }
+		samplex -= intx;
+		offsets[x] = intx * 4;
+		fractions[x] = samplex;
+	}
+	for( y = 0; y < resampled_height; ++y )
+	{
+		float sampley = y * dy;
+		int inty = (int)sampley;
+		const unsigned char *row0, *row1;
+		unsigned char *out = resampled + y*resampled_width*4;
+		if( inty > height - 2 ) { inty = height - 2; }
+		sampley -= inty;
+		row0 = orig + inty*width*4;
+		row1 = row0 + width*4;
+#ifdef IMAGE_HELPER_AVX2
+		if( has_AVX2() )
+		{
+			up_scale_row_RGBA_AVX2( row0, row1, offsets, fractions, sampley, out, resampled_width );
+			continue;
+		}
+#endif
+		up_scale_row_RGBA_SSE2( row0, row1, offsets, fractions, sampley, out, resampled_width );
+	}
+	free( offsets );
+	free( fractions );
+	return 1;
+}
+
+/*	adds count bytes of a source row into 16 bit column sums	*/
+static void add_row_16_SSE2( const unsigned char* row, unsigned short* sums, int count )
+{
+	const __m128i zero = _mm_setzero_si128();
+	int k;
+	for( k = 0; k + 16 <= count; k += 16 )
+	{
+		__m128i bytes = _mm_loadu_si128( (const __m128i*)(row + k) );
+		__m128i lo = _mm_loadu_si128( (const __m128i*)(sums + k) );
+		__m128i hi = _mm_loadu_si128( (const __m128i*)(sums + k + 8) );
+		lo = _mm_add_epi16( lo, _mm_unpacklo_epi8( bytes, zero ) );
+		hi = _mm_add_epi16( hi, _mm_unpackhi_epi8( bytes, zero ) );
+		_mm_storeu_si128( (__m128i*)(sums + k), lo );
+		_mm_storeu_si128( (__m128i*)(sums + k + 8), hi );
+	}
+	for( ; k < count; ++k )
+	{
+		sums[k] += row[k];
+	}
+}
+
+#ifdef IMAGE_HELPER_AVX2
+IMAGE_HELPER_TARGET_AVX2
+static void add_row_16_AVX2( const unsigned char* row, unsigned short* sums, int count )
+{
+	int k;
+	for( k = 0; k + 32 <= count; k += 32 )
+	{
+		__m256i lo = _mm256_loadu_si256( (const __m256i*)(sums + k) );
+		__m256i hi = _mm256_loadu_si256( (const __m256i*)(sums + k + 16) );
+		lo = _mm256_add_epi16( lo, _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i*)(row + k) ) ) );
+		hi = _mm256_add_epi16( hi, _mm256_cvtepu8_epi16( _mm_loadu_si128( (const __m128i*)(row + k + 16) ) ) );
+		_mm256_storeu_si256( (__m256i*)(sums + k), lo );
+		_mm256_storeu_si256( (__m256i*)(sums + k + 16), hi );
+	}
+	add_row_16_SSE2( row + k, sums + k, count - k );
+}
+#endif
+
+/*	widens 16 bit column sums and adds them into 32 bit ones	*/
+static void add_sums_32_SSE2( const unsigned short* sums16, unsigned int* sums32, int count )
+{
+	const __m128i zero = _mm_setzero_si128();
+	int k;
+	for( k = 0; k + 8 <= count; k += 8 )
+	{
+		__m128i v = _mm_loadu_si128( (const __m128i*)(sums16 + k) );
+		__m128i lo = _mm_loadu_si128( (const __m128i*)(sums32 + k) );
+		__m128i hi = _mm_loadu_si128( (const __m128i*)(sums32 + k + 4) );
+		_mm_storeu_si128( (__m128i*)(sums32 + k), _mm_add_epi32( lo, _mm_unpacklo_epi16( v, zero ) ) );
+		_mm_storeu_si128( (__m128i*)(sums32 + k + 4), _mm_add_epi32( hi, _mm_unpackhi_epi16( v, zero ) ) );
+	}
+	for( ; k < count; ++k )
+	{
+		sums32[k] += sums16[k];
+	}
+}
+
+/*
+	Box filter over whole blocks only.  Each output row first sums its
+	block_size_y source rows into per column totals, 16 bits wide while they
+	can't overflow, then each output pixel adds up block_size_x columns.
+*/
+static int mipmap_image_SIMD
+	(
+		const unsigned char* const orig,
+		int width, int height, int channels,
+		unsigned char* resampled,
+		int block_size_x, int block_size_y
+	)
+{
+	const int mip_width = width / block_size_x;
+	const int mip_height = height / block_size_y;
+	const int count = mip_width * block_size_x * channels;
+	const int block_area = block_size_x * block_size_y;
+	const int wide = block_size_y > 256;
+	int shift = -1;
+	unsigned short *sums16;
+	unsigned int *sums32 = NULL;
+	void (*add_row)( const unsigned char*, unsigned short*, int ) = add_row_16_SSE2;
+	int i, j, c, u, v;
+
+	sums16 = (unsigned short*)malloc( count * sizeof(unsigned short) );
+	if( wide )
+	{
+		sums32 = (unsigned int*)malloc( count * sizeof(unsigned int) );
+	}
+	if( (NULL == sums16) || (wide && (NULL == sums32)) )
+	{
+		free( sums16 );
+		free( sums32 );
+		return 0;
+	}
+#ifdef IMAGE_HELPER_AVX2
+	if( has_AVX2() )
+	{
+		add_row = add_row_16_AVX2;
+	}
+#endif
+	if( (block_area & (block_area - 1)) == 0 )
+	{
+		for( shift = 0; (1 << shift) < block_area; ++shift );
+	}
+
+	for( j = 0; j < mip_height; ++j )
+	{
+		const unsigned char* rows = orig + j*block_size_y*width*channels;
+		unsigned char* out = resampled + j*mip_width*channels;
+		if( wide )
+		{
+			memset( sums32, 0, count * sizeof(unsigned int) );
+		}
+		for( v = 0; v < block_size_y; v += 256 )
+		{
+			const int last = (v + 256 < block_size_y) ? v + 256 : block_size_y;
+			int r;
+			memset( sums16, 0, count * sizeof(unsigned short) );
+			for( r = v; r < last; ++r )
+			{
+				add_row( rows + r*width*channels, sums16, count );
+			}
+			if( wide )
+			{
+				add_sums_32_SSE2( sums16, sums32, count );
+			}
+		}
+
+		if( channels == 4 )
+		{
+			const __m128i zero = _mm_setzero_si128();
+			const __m128i rounding = _mm_set1_epi32( block_area >> 1 );
+			for( i = 0; i < mip_width; ++i )
+			{
+				__m128i total = rounding;
+				int packed;
+				for( u = 0; u < block_size_x; ++u )
+				{
+					const int k = (i*block_size_x + u) * 4;
+					if( wide )
+					{
+						total = _mm_add_epi32( total, _mm_loadu_si128( (const __m128i*)(sums32 + k) ) );
+					}
+					else
+					{
+						total = _mm_add_epi32( total, _mm_unpacklo_epi16( _mm_loadl_epi64( (const __m128i*)(sums16 + k) ), zero ) );
+					}
+				}
+				if( shift >= 0 )
+				{
+					total = _mm_srli_epi32( total, shift );
+				}
+				else
+				{
+					int lanes[4];
+					_mm_storeu_si128( (__m128i*)lanes, total );
+					total = _mm_setr_epi32( lanes[0] / block_area, lanes[1] / block_area,
+						lanes[2] / block_area, lanes[3] / block_area );
+				}
+				total = _mm_packs_epi32( total, total );
+				total = _mm_packus_epi16( total, total );
+				packed = _mm_cvtsi128_si32( total );
+				memcpy( out + i*4, &packed, 4 );
+			}
+		}
+		else
+		{
+			for( i = 0; i < mip_width; ++i )
+			{
+				for( c = 0; c < channels; ++c )
+				{
+					int sum_value = block_area >> 1;
+					for( u = 0; u < block_size_x; ++u )
+					{
+						const int k = (i*block_size_x + u) * channels + c;
+						sum_value += wide ? (int)sums32[k] : sums16[k];
+					}
+					out[i*channels + c] = sum_value / block_area;
+				}
+			}
+		}
+	}
+	free( sums16 );
+	free( sums32 );
+	return 1;
+}
+
+/*	spreads the alpha of each 2 or 4 channel pixel over its 16-bit lanes	*/
+static __m128i spread_alpha_SSE2( __m128i v, int channels )
+{
+	if( channels == 4 )
+	{
+		v = _mm_shufflelo_epi16( v, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+		return _mm_shufflehi_epi16( v, _MM_SHUFFLE( 3, 3, 3, 3 ) );
+	}
+	v = _mm_shufflelo_epi16( v, _MM_SHUFFLE( 3, 3, 1, 1 ) );
+	return _mm_shufflehi_epi16( v, _MM_SHUFFLE( 3, 3, 1, 1 ) );
+}
+
+/*	premultiplies 16 bytes at a time, returns how many bytes were done	*/
+static int multiply_alpha_SSE2( unsigned char* orig, int count, int channels )
+{
+	const __m128i zero = _mm_setzero_si128();
+	const __m128i round = _mm_set1_epi16( 128 );
+	const __m128i alpha_mask = (channels == 4) ?
+		_mm_set1_epi32( (int)0xFF000000 ) : _mm_set1_epi16( (short)0xFF00 );
+	int i;
+	for( i = 0; i + 16 <= count; i += 16 )
+	{
+		__m128i v = _mm_loadu_si128( (const __m128i*)(orig + i) );
+		__m128i lo = _mm_unpacklo_epi8( v, zero );
+		__m128i hi = _mm_unpackhi_epi8( v, zero );
+		lo = _mm_mullo_epi16( lo, spread_alpha_SSE2( lo, channels ) );
+		hi = _mm_mullo_epi16( hi, spread_alpha_SSE2( hi, channels ) );
+		lo = _mm_srli_epi16( _mm_add_epi16( lo, round ), 8 );
+		hi = _mm_srli_epi16( _mm_add_epi16( hi, round ), 8 );
+		/*	the alpha channel itself is kept	*/
+		v = _mm_or_si128( _mm_and_si128( alpha_mask, v ),
+			_mm_andnot_si128( alpha_mask, _mm_packus_epi16( lo, hi ) ) );
+		_mm_storeu_si128( (__m128i*)(orig + i), v );
+	}
+	return i;
+}
+
+
+/*
+	4 channel YCoCg is converted 16 pixels at a time, in 16 bit lanes with one
+	vector per channel.  The math is the scalar integer math, and the min /
+	max are clamp_byte.  (Spreading 3 channel pixels into 4 channel blocks for
+	this costs more than it saves, the compiler does well enough on those.)
+*/
+
+/*	splits 8 RGBA pixels into one vector of 16 bit values per channel	*/
+static void load_channels_SSE2( const unsigned char* pixels, __m128i* c )
+{
+	const __m128i mask = _mm_set1_epi32( 0xFF );
+	const __m128i v0 = _mm_loadu_si128( (const __m128i*)pixels );
+	const __m128i v1 = _mm_loadu_si128( (const __m128i*)(pixels + 16) );
+	c[0] = _mm_packs_epi32( _mm_and_si128( v0, mask ), _mm_and_si128( v1, mask ) );
+	c[1] = _mm_packs_epi32( _mm_and_si128( _mm_srli_epi32( v0, 8 ), mask ),
+		_mm_and_si128( _mm_srli_epi32( v1, 8 ), mask ) );
+	c[2] = _mm_packs_epi32( _mm_and_si128( _mm_srli_epi32( v0, 16 ), mask ),
+		_mm_and_si128( _mm_srli_epi32( v1, 16 ), mask ) );
+	c[3] = _mm_packs_epi32( _mm_srli_epi32( v0, 24 ), _mm_srli_epi32( v1, 24 ) );
+}
+
+/*	interleaves 4 vectors of 16 bit values, all within 0..255, into 8 pixels	*/
+static void store_channels_SSE2( unsigned char* pixels, __m128i c0, __m128i c1, __m128i c2, __m128i c3 )
+{
+	const __m128i lo = _mm_or_si128( c0, _mm_slli_epi16( c1, 8 ) );
+	const __m128i hi = _mm_or_si128( c2, _mm_slli_epi16( c3, 8 ) );
+	_mm_storeu_si128( (__m128i*)pixels, _mm_unpacklo_epi16( lo, hi ) );
+	_mm_storeu_si128( (__m128i*)(pixels + 16), _mm_unpackhi_epi16( lo, hi ) );
+}
+
+static __m128i clamp_byte_SSE2( __m128i x )
+{
+	return _mm_min_epi16( _mm_max_epi16( x, _mm_setzero_si128() ), _mm_set1_epi16( 255 ) );
+}
+
+/*	converts 8 pixels, laid out CoCgAY	*/
+static void convert_YCoCg_8_SSE2( unsigned char* pixels, int to_YCoCg )
+{
+	const __m128i one = _mm_set1_epi16( 1 );
+	const __m128i two = _mm_set1_epi16( 2 );
+	const __m128i half = _mm_set1_epi16( 128 );
+	__m128i c[4];
+	load_channels_SSE2( pixels, c );
+	if( to_YCoCg )
+	{
+		const __m128i g = _mm_srli_epi16( _mm_add_epi16( c[1], one ), 1 );
+		const __m128i tmp = _mm_srli_epi16( _mm_add_epi16( _mm_add_epi16( c[0], c[2] ), two ), 2 );
+		const __m128i co = clamp_byte_SSE2( _mm_add_epi16( half,
+			_mm_srai_epi16( _mm_add_epi16( _mm_sub_epi16( c[0], c[2] ), one ), 1 ) ) );
+		const __m128i cg = clamp_byte_SSE2( _mm_sub_epi16( _mm_add_epi16( half, g ), tmp ) );
+		const __m128i y = clamp_byte_SSE2( _mm_add_epi16( g, tmp ) );
+		store_channels_SSE2( pixels, co, cg, c[3], y );
+	} else
+	{
+		const __m128i co = _mm_sub_epi16( c[0], half );
+		const __m128i cg = _mm_sub_epi16( c[1], half );
+		const __m128i y = c[3];
+		store_channels_SSE2( pixels,
+			clamp_byte_SSE2( _mm_sub_epi16( _mm_add_epi16( y, co ), cg ) ),
+			clamp_byte_SSE2( _mm_add_epi16( y, cg ) ),
+			clamp_byte_SSE2( _mm_sub_epi16( _mm_sub_epi16( y, co ), cg ) ),
+			c[2] );
+	}
+}
+
+static void convert_YCoCg_16_SSE2( unsigned char* pixels, int to_YCoCg )
+{
+	convert_YCoCg_8_SSE2( pixels, to_YCoCg );
+	convert_YCoCg_8_SSE2( pixels + 32, to_YCoCg );
+}
+
+#ifdef IMAGE_HELPER_AVX2
+/*	the 128 bit lanes hold pixels 0-3 and 8-11, then 4-7 and 12-15, which
+	store_channels_AVX2 puts back in order	*/
+IMAGE_HELPER_TARGET_AVX2
+static void load_channels_AVX2( const unsigned char* pixels, __m256i* c )
+{
+	const __m256i mask = _mm256_set1_epi32( 0xFF );
+	const __m256i v0 = _mm256_loadu_si256( (const __m256i*)pixels );
+	const __m256i v1 = _mm256_loadu_si256( (const __m256i*)(pixels + 32) );
+	c[0] = _mm256_packs_epi32( _mm256_and_si256( v0, mask ), _mm256_and_si256( v1, mask ) );
+	c[1] = _mm256_packs_epi32( _mm256_and_si256( _mm256_srli_epi32( v0, 8 ), mask ),
+		_mm256_and_si256( _mm256_srli_epi32( v1, 8 ), mask ) );
+	c[2] = _mm256_packs_epi32( _mm256_and_si256( _mm256_srli_epi32( v0, 16 ), mask ),
+		_mm256_and_si256( _mm256_srli_epi32( v1, 16 ), mask ) );
+	c[3] = _mm256_packs_epi32( _mm256_srli_epi32( v0, 24 ), _mm256_srli_epi32( v1, 24 ) );
+}
+
+IMAGE_HELPER_TARGET_AVX2
+static void store_channels_AVX2( unsigned char* pixels, __m256i c0, __m256i c1, __m256i c2, __m256i c3 )
+{
+	const __m256i lo = _mm256_or_si256( c0, _mm256_slli_epi16( c1, 8 ) );
+	const __m256i hi = _mm256_or_si256( c2, _mm256_slli_epi16( c3, 8 ) );
+	_mm256_storeu_si256( (__m256i*)pixels, _mm256_unpacklo_epi16( lo, hi ) );
+	_mm256_storeu_si256( (__m256i*)(pixels + 32), _mm256_unpackhi_epi16( lo, hi ) );
+}
+
+IMAGE_HELPER_TARGET_AVX2
+static __m256i clamp_byte_AVX2( __m256i x )
+{
+	return _mm256_min_epi16( _mm256_max_epi16( x, _mm256_setzero_si256() ), _mm256_set1_epi16( 255 ) );
+}
+
+IMAGE_HELPER_TARGET_AVX2
+static void convert_YCoCg_16_AVX2( unsigned char* pixels, int to_YCoCg )
+{
+	const __m256i one = _mm256_set1_epi16( 1 );
+	const __m256i two = _mm256_set1_epi16( 2 );
+	const __m256i half = _mm256_set1_epi16( 128 );
+	__m256i c[4];
+	load_channels_AVX2( pixels, c );
+	if( to_YCoCg )
+	{
+		const __m256i g = _mm256_srli_epi16( _mm256_add_epi16( c[1], one ), 1 );
+		const __m256i tmp = _mm256_srli_epi16( _mm256_add_epi16( _mm256_add_epi16( c[0], c[2] ), two ), 2 );
+		const __m256i co = clamp_byte_AVX2( _mm256_add_epi16( half,
+			_mm256_srai_epi16( _mm256_add_epi16( _mm256_sub_epi16( c[0], c[2] ), one ), 1 ) ) );
+		const __m256i cg = clamp_byte_AVX2( _mm256_sub_epi16( _mm256_add_epi16( half, g ), tmp ) );
+		const __m256i y = clamp_byte_AVX2( _mm256_add_epi16( g, tmp ) );
+		store_channels_AVX2( pixels, co, cg, c[3], y );
+	} else
+	{
+		const __m256i co = _mm256_sub_epi16( c[0], half );
+		const __m256i cg = _mm256_sub_epi16( c[1], half );
+		const __m256i y = c[3];
+		store_channels_AVX2( pixels,
+			clamp_byte_AVX2( _mm256_sub_epi16( _mm256_add_epi16( y, co ), cg ) ),
+			clamp_byte_AVX2( _mm256_add_epi16( y, cg ) ),
+			clamp_byte_AVX2( _mm256_sub_epi16( _mm256_sub_epi16( y, co ), cg ) ),
+			c[2] );
+	}
+}
+#endif
+
+/*	converts 16 RGBA pixels at a time, returns how many pixels were done	*/
+static int convert_YCoCg_SIMD( unsigned char* orig, int num_pixels, int to_YCoCg )
+{
+	void (*convert)( unsigned char*, int ) = convert_YCoCg_16_SSE2;
+	int i;
+#ifdef IMAGE_HELPER_AVX2
+	if( has_AVX2() )
+	{
+		convert = convert_YCoCg_16_AVX2;
+	}
+#endif
+	for( i = 0; i + 16 <= num_pixels; i += 16 )
+	{
+		convert( orig + i*4, to_YCoCg );
+	}
+	return i;
+}
+
+/*
+	RGBE is converted 4 pixels at a time (8 with AVX2) in floats.  e is
+	looked up from the exponent table, and the rest are the scalar float
+	operations in the same order.  The truncations round trip through
+	cvttps like the scalar casts do on x86, and the comparisons pick the
+	same operand as the scalar ternaries, so even the degenerate cases
+	(0 / 0 when rescaling a black image) come out the same.
+*/
+static __m128i select_SSE2( __m128i mask, __m128i a, __m128i b )
+{
+	return _mm_or_si128( _mm_and_si128( mask, a ), _mm_andnot_si128( mask, b ) );
+}
+
+/*	(iv > 255) ? 255 : iv, cut to a byte like the store to unsigned char	*/
+static __m128i saturate_byte_SSE2( __m128i iv )
+{
+	const __m128i max = _mm_set1_epi32( 255 );
+	return _mm_and_si128( select_SSE2( _mm_cmpgt_epi32( iv, max ), max, iv ), max );
+}
+
+static int RGBE_to_RGBdivA_SSE2( unsigned char* img, int num_pixels, const float* e_table, int squared )
+{
+	const __m128i mask = _mm_set1_epi32( 0xFF );
+	const __m128i one = _mm_set1_epi32( 1 );
+	const __m128i max = _mm_set1_epi32( 255 );
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 half = _mm_set1_ps( 0.5f );
+	const __m128 c255 = _mm_set1_ps( 255.0f );
+	const __m128 c65025 = _mm_set1_ps( 255.0f * 255.0f );
+	int i;
+	for( i = 0; i + 4 <= num_pixels; i += 4 )
+	{
+		unsigned char* p = img + i*4;
+		const __m128i v = _mm_loadu_si128( (const __m128i*)p );
+		const __m128 e = _mm_setr_ps( e_table[p[3]], e_table[p[7]], e_table[p[11]], e_table[p[15]] );
+		const __m128 r = _mm_mul_ps( e, _mm_cvtepi32_ps( _mm_and_si128( v, mask ) ) );
+		const __m128 g = _mm_mul_ps( e, _mm_cvtepi32_ps( _mm_and_si128( _mm_srli_epi32( v, 8 ), mask ) ) );
+		const __m128 b = _mm_mul_ps( e, _mm_cvtepi32_ps( _mm_and_si128( _mm_srli_epi32( v, 16 ), mask ) ) );
+		const __m128 m = _mm_max_ps( b, _mm_max_ps( r, g ) );
+		__m128 fa;
+		__m128i a, out;
+		a = _mm_cvttps_epi32( squared ? _mm_sqrt_ps( _mm_div_ps( c65025, m ) ) : _mm_div_ps( c255, m ) );
+		a = select_SSE2( _mm_castps_si128( _mm_cmpneq_ps( m, zero ) ), a, one );
+		a = select_SSE2( _mm_cmplt_epi32( a, one ), one, a );
+		a = select_SSE2( _mm_cmpgt_epi32( a, max ), max, a );
+		fa = _mm_cvtepi32_ps( a );
+		out = _mm_slli_epi32( a, 24 );
+		if( squared )
+		{
+			/*	img[3] * img[3] is an int, exact as a float	*/
+			const __m128 fa2 = _mm_mul_ps( fa, fa );
+			out = _mm_or_si128( out, saturate_byte_SSE2( _mm_cvttps_epi32(
+				_mm_add_ps( _mm_div_ps( _mm_mul_ps( fa2, r ), c255 ), half ) ) ) );
+			out = _mm_or_si128( out, _mm_slli_epi32( saturate_byte_SSE2( _mm_cvttps_epi32(
+				_mm_add_ps( _mm_div_ps( _mm_mul_ps( fa2, g ), c255 ), half ) ) ), 8 ) );
+			out = _mm_or_si128( out, _mm_slli_epi32( saturate_byte_SSE2( _mm_cvttps_epi32(
+				_mm_add_ps( _mm_div_ps( _mm_mul_ps( fa2, b ), c255 ), half ) ) ), 16 ) );
+		} else
+		{
+			out = _mm_or_si128( out, saturate_byte_SSE2( _mm_cvttps_epi32(
+				_mm_add_ps( _mm_mul_ps( fa, r ), half ) ) ) );
+			out = _mm_or_si128( out, _mm_slli_epi32( saturate_byte_SSE2( _mm_cvttps_epi32(
+				_mm_add_ps( _mm_mul_ps( fa, g ), half ) ) ), 8 ) );
+			out = _mm_or_si128( out, _mm_slli_epi32( saturate_byte_SSE2( _mm_cvttps_epi32(
+				_mm_add_ps( _mm_mul_ps( fa, b ), half ) ) ), 16 ) );
+		}
+		_mm_storeu_si128( (__m128i*)p, out );
+	}
+	return i;
+}
+
+#ifdef IMAGE_HELPER_AVX2
+IMAGE_HELPER_TARGET_AVX2
+static __m256i select_AVX2( __m256i mask, __m256i a, __m256i b )
+{
+	return _mm256_or_si256( _mm256_and_si256( mask, a ), _mm256_andnot_si256( mask, b ) );
+}
+
+IMAGE_HELPER_TARGET_AVX2
+static __m256i saturate_byte_AVX2( __m256i iv )
+{
+	const __m256i max = _mm256_set1_epi32( 255 );
+	return _mm256_and_si256( select_AVX2( _mm256_cmpgt_epi32( iv, max ), max, iv ), max );
+}
+
+IMAGE_HELPER_TARGET_AVX2
+static int RGBE_to_RGBdivA_AVX2( unsigned char* img, int num_pixels, const float* e_table, int squared )
+{
+	const __m256i mask = _mm256_set1_epi32( 0xFF );
+	const __m256i one = _mm256_set1_epi32( 1 );
+	const __m256i max = _mm256_set1_epi32( 255 );
+	const __m256 zero = _mm256_setzero_ps();
+	const __m256 half = _mm256_set1_ps( 0.5f );
+	const __m256 c255 = _mm256_set1_ps( 255.0f );
+	const __m256 c65025 = _mm256_set1_ps( 255.0f * 255.0f );
+	int i;
+	for( i = 0; i + 8 <= num_pixels; i += 8 )
+	{
+		unsigned char* p = img + i*4;
+		const __m256i v = _mm256_loadu_si256( (const __m256i*)p );
+		const __m256 e = _mm256_i32gather_ps( e_table, _mm256_srli_epi32( v, 24 ), 4 );
+		const __m256 r = _mm256_mul_ps( e, _mm256_cvtepi32_ps( _mm256_and_si256( v, mask ) ) );
+		const __m256 g = _mm256_mul_ps( e, _mm256_cvtepi32_ps( _mm256_and_si256( _mm256_srli_epi32( v, 8 ), mask ) ) );
+		const __m256 b = _mm256_mul_ps( e, _mm256_cvtepi32_ps( _mm256_and_si256( _mm256_srli_epi32( v, 16 ), mask ) ) );
+		const __m256 m = _mm256_max_ps( b, _mm256_max_ps( r, g ) );
+		__m256 fa;
+		__m256i a, out;
+		a = _mm256_cvttps_epi32( squared ? _mm256_sqrt_ps( _mm256_div_ps( c65025, m ) ) : _mm256_div_ps( c255, m ) );
+		a = select_AVX2( _mm256_castps_si256( _mm256_cmp_ps( m, zero, _CMP_NEQ_UQ ) ), a, one );
+		a = _mm256_min_epi32( _mm256_max_epi32( a, one ), max );
+		fa = _mm256_cvtepi32_ps( a );
+		out = _mm256_slli_epi32( a, 24 );
+		if( squared )
+		{
+			const __m256 fa2 = _mm256_mul_ps( fa, fa );
+			out = _mm256_or_si256( out, saturate_byte_AVX2( _mm256_cvttps_epi32(
+				_mm256_add_ps( _mm256_div_ps( _mm256_mul_ps( fa2, r ), c255 ), half ) ) ) );
+			out = _mm256_or_si256( out, _mm256_slli_epi32( saturate_byte_AVX2( _mm256_cvttps_epi32(
+				_mm256_add_ps( _mm256_div_ps( _mm256_mul_ps( fa2, g ), c255 ), half ) ) ), 8 ) );
+			out = _mm256_or_si256( out, _mm256_slli_epi32( saturate_byte_AVX2( _mm256_cvttps_epi32(
+				_mm256_add_ps( _mm256_div_ps( _mm256_mul_ps( fa2, b ), c255 ), half ) ) ), 16 ) );
+		} else
+		{
+			out = _mm256_or_si256( out, saturate_byte_AVX2( _mm256_cvttps_epi32(
+				_mm256_add_ps( _mm256_mul_ps( fa, r ), half ) ) ) );
+			out = _mm256_or_si256( out, _mm256_slli_epi32( saturate_byte_AVX2( _mm256_cvttps_epi32(
+				_mm256_add_ps( _mm256_mul_ps( fa, g ), half ) ) ), 8 ) );
+			out = _mm256_or_si256( out, _mm256_slli_epi32( saturate_byte_AVX2( _mm256_cvttps_epi32(
+				_mm256_add_ps( _mm256_mul_ps( fa, b ), half ) ) ), 16 ) );
+		}
+		_mm256_storeu_si256( (__m256i*)p, out );
+	}
+	return i + RGBE_to_RGBdivA_SSE2( img + i*4, num_pixels - i, e_table, squared );
+}
+#endif
+
+/*	the largest channel of whole groups of 4 pixels, which are counted in *done	*/
+static float find_max_RGBE_SSE2( const unsigned char* img, int num_pixels, const float* scale_table, int* done )
+{
+	const __m128i mask = _mm_set1_epi32( 0xFF );
+	__m128 max_val = _mm_setzero_ps();
+	float lanes[4];
+	int i;
+	for( i = 0; i + 4 <= num_pixels; i += 4 )
+	{
+		const unsigned char* p = img + i*4;
+		const __m128i v = _mm_loadu_si128( (const __m128i*)p );
+		const __m128 scale = _mm_setr_ps( scale_table[p[3]], scale_table[p[7]], scale_table[p[11]], scale_table[p[15]] );
+		max_val = _mm_max_ps( max_val, _mm_mul_ps( _mm_cvtepi32_ps( _mm_and_si128( v, mask ) ), scale ) );
+		max_val = _mm_max_ps( max_val, _mm_mul_ps( _mm_cvtepi32_ps( _mm_and_si128( _mm_srli_epi32( v, 8 ), mask ) ), scale ) );
+		max_val = _mm_max_ps( max_val, _mm_mul_ps( _mm_cvtepi32_ps( _mm_and_si128( _mm_srli_epi32( v, 16 ), mask ) ), scale ) );
+	}
+	_mm_storeu_ps( lanes, max_val );
+	*done = i;
+	lanes[0] = (lanes[1] > lanes[0]) ? lanes[1] : lanes[0];
+	lanes[0] = (lanes[2] > lanes[0]) ? lanes[2] : lanes[0];
+	return (lanes[3] > lanes[0]) ? lanes[3] : lanes[0];
+}
+
+#endif
+
 /*	Upscaling the image uses simple bilinear interpolation	*/
 int
 	up_scale_image
@@ -32,6 +759,13 @@ int
         /*	signify badness	*/
         return 0;
     }
+#ifdef IMAGE_HELPER_SSE2
+	if( (channels == 4) && (width > 1) && (height > 1) &&
+		up_scale_image_RGBA_SIMD( orig, width, height, resampled, resampled_width, resampled_height ) )
+	{
+		return 1;
+	}
+#endif
     /*
 		for each given pixel in the new map, find the exact location
 		from the original map which would contribute to this guy
@@ -112,6 +846,14 @@ int
 	{
 		mip_height = 1;
 	}
+#ifdef IMAGE_HELPER_SSE2
+	/*	only the edge blocks of small non-square mips are partial	*/
+	if( (block_size_x <= width) && (block_size_y <= height) &&
+		mipmap_image_SIMD( orig, width, height, channels, resampled, block_size_x, block_size_y ) )
+	{
+		return 1;
+	}
+#endif
 	for( j = 0; j < mip_height; ++j )
 	{
 		for( i = 0; i < mip_width; ++i )
@@ -188,6 +930,40 @@ int
 	return 1;
 }
 
+int
+	multiply_alpha
+	(
+		unsigned char* orig,
+		int width, int height, int channels
+	)
+{
+	int i = 0, j;
+	const int count = width*height*channels;
+	/*	error check	*/
+	if( (width < 1) || (height < 1) ||
+		(orig == NULL) )
+	{
+		/*	nothing to do	*/
+		return 0;
+	}
+	if( (channels != 2) && (channels != 4) )
+	{
+		/*	no other number of channels contains alpha data	*/
+		return 1;
+	}
+#ifdef IMAGE_HELPER_SSE2
+	i = multiply_alpha_SSE2( orig, count, channels );
+#endif
+	for( ; i < count; i += channels )
+	{
+		for( j = 0; j < channels - 1; ++j )
+		{
+			orig[i+j] = (orig[i+j] * orig[i+channels-1] + 128) >> 8;
+		}
+	}
+	return 1;
+}
+
 unsigned char clamp_byte( int x ) { return ( (x) < 0 ? (0) : ( (x) > 255 ? 255 : (x) ) ); }
 
 /*
@@ -214,9 +990,16 @@ int
 		return -1;
 	}
 	/*	do the conversion	*/
+	i = 0;
+#ifdef IMAGE_HELPER_SSE2
+	if( channels == 4 )
+	{
+		i = convert_YCoCg_SIMD( orig, width*height, 1 ) * 4;
+	}
+#endif
 	if( channels == 3 )
 	{
-		for( i = 0; i < width*height*3; i += 3 )
+		for( ; i < width*height*3; i += 3 )
 		{
 			int r = orig[i+0];
 			int g = (orig[i+1] + 1) >> 1;
@@ -231,7 +1014,7 @@ int
 		}
 	} else
 	{
-		for( i = 0; i < width*height*4; i += 4 )
+		for( ; i < width*height*4; i += 4 )
 		{
 			int r = orig[i+0];
 			int g = (orig[i+1] + 1) >> 1;
@@ -273,9 +1056,16 @@ int
 		return -1;
 	}
 	/*	do the conversion	*/
+	i = 0;
+#ifdef IMAGE_HELPER_SSE2
+	if( channels == 4 )
+	{
+		i = convert_YCoCg_SIMD( orig, width*height, 0 ) * 4;
+	}
+#endif
 	if( channels == 3 )
 	{
-		for( i = 0; i < width*height*3; i += 3 )
+		for( ; i < width*height*3; i += 3 )
 		{
 			int co = orig[i+0] - 128;
 			int y  = orig[i+1];
@@ -289,7 +1079,7 @@ int
 		}
 	} else
 	{
-		for( i = 0; i < width*height*4; i += 4 )
+		for( ; i < width*height*4; i += 4 )
 		{
 			int co = orig[i+0] - 128;
 			int cg = orig[i+1] - 128;
@@ -309,6 +1099,25 @@ int
 	return 0;
 }
 
+/*
+	ldexp is slow, and only depends on the exponent byte, so the factor
+	for each exponent is computed once, with the same expression
+*/
+static void
+RGBE_scale_table
+(
+	float scale,
+	float table[256]
+)
+{
+	int i;
+	for( i = 0; i < 256; ++i )
+	{
+		/* table[i] = scale * powf( 2.0f, i - 128.0f ) / 255.0f; */
+		table[i] = scale * ldexp( 1.0f / 255.0f, i - 128 );
+	}
+}
+
 float
 find_max_RGBE
 (
@@ -318,11 +1127,16 @@ find_max_RGBE
 {
 	float max_val = 0.0f;
 	unsigned char *img = image;
-	int i, j;
-	for( i = width * height; i > 0; --i )
+	float scale_table[256];
+	int i, j, done = 0;
+	RGBE_scale_table( 1.0f, scale_table );
+#ifdef IMAGE_HELPER_SSE2
+	max_val = find_max_RGBE_SSE2( img, width * height, scale_table, &done );
+	img += done * 4;
+#endif
+	for( i = width * height - done; i > 0; --i )
 	{
-		/* float scale = powf( 2.0f, img[3] - 128.0f ) / 255.0f; */
-		float scale = ldexp( 1.0f / 255.0f, (int)(img[3]) - 128 );
+		float scale = scale_table[img[3]];
 		for( j = 0; j < 3; ++j )
 		{
 			if( img[j] * scale > max_val )
@@ -345,9 +1159,10 @@ RGBE_to_RGBdivA
 )
 {
 	/* local variables */
-	int i, iv;
+	int i, iv, done = 0;
 	unsigned char *img = image;
 	float scale = 1.0f;
+	float e_table[256];
 	/* error check */
 	if( (!image) || (width < 1) || (height < 1) )
 	{
@@ -358,12 +1173,24 @@ RGBE_to_RGBdivA
 	{
 		scale = 255.0f / find_max_RGBE( image, width, height );
 	}
-	for( i = width * height; i > 0; --i )
+	RGBE_scale_table( scale, e_table );
+#ifdef IMAGE_HELPER_SSE2
+#ifdef IMAGE_HELPER_AVX2
+	if( has_AVX2() )
+	{
+		done = RGBE_to_RGBdivA_AVX2( img, width * height, e_table, 0 );
+	} else
+#endif
+	{
+		done = RGBE_to_RGBdivA_SSE2( img, width * height, e_table, 0 );
+	}
+	img += done * 4;
+#endif
+	for( i = width * height - done; i > 0; --i )
 	{
 		/* decode this pixel, and find the max */
 		float r,g,b,e, m;
-		/* e = scale * powf( 2.0f, img[3] - 128.0f ) / 255.0f; */
-		e = scale * ldexp( 1.0f / 255.0f, (int)(img[3]) - 128 );
+		e = e_table[img[3]];
 		r = e * img[0];
 		g = e * img[1];
 		b = e * img[2];
@@ -394,9 +1221,10 @@ RGBE_to_RGBdivA2
 )
 {
 	/* local variables */
-	int i, iv;
+	int i, iv, done = 0;
 	unsigned char *img = image;
 	float scale = 1.0f;
+	float e_table[256];
 	/* error check */
 	if( (!image) || (width < 1) || (height < 1) )
 	{
@@ -407,12 +1235,24 @@ RGBE_to_RGBdivA2
 	{
 		scale = 255.0f * 255.0f / find_max_RGBE( image, width, height );
 	}
-	for( i = width * height; i > 0; --i )
+	RGBE_scale_table( scale, e_table );
+#ifdef IMAGE_HELPER_SSE2
+#ifdef IMAGE_HELPER_AVX2
+	if( has_AVX2() )
+	{
+		done = RGBE_to_RGBdivA_AVX2( img, width * height, e_table, 1 );
+	} else
+#endif
+	{
+		done = RGBE_to_RGBdivA_SSE2( img, width * height, e_table, 1 );
+	}
+	img += done * 4;
+#endif
+	for( i = width * height - done; i > 0; --i )
 	{
 		/* decode this pixel, and find the max */
 		float r,g,b,e, m;
-		/* e = scale * powf( 2.0f, img[3] - 128.0f ) / 255.0f; */
-		e = scale * ldexp( 1.0f / 255.0f, (int)(img[3]) - 128 );
+		e = e_table[img[3]];
 		r = e * img[0];
 		g = e * img[1];
 		b = e * img[2];
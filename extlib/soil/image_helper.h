@@ -57,6 +57,18 @@ int
 		int width, int height, int channels
 	);
 
+/**
+	This function converts the color components of a
+	2 or 4 channel image from straight to pre-multiplied
+	alpha.  Other images are left alone.
+**/
+int
+	multiply_alpha
+	(
+		unsigned char* orig,
+		int width, int height, int channels
+	);
+
 /**
 	This function takes the RGB components of the image
 	and converts them into YCoCg.  3 components will be
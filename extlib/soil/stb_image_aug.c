@@ -16,7 +16,7 @@
       supports installable dequantizing-IDCT, YCbCr-to-RGB conversion (define STBI_SIMD)
 
    TODO:
-      stbi_info_*
+      stbi_info_* for formats other than JPEG and PNG
 
    history:
       1.16   major bugfix - convert_format converted one too many pixels
@@ -94,10 +94,27 @@ typedef   signed short  int16;
 typedef unsigned int   uint32;
 typedef   signed int    int32;
 typedef unsigned int   uint;
+#ifdef _MSC_VER
+typedef unsigned __int64 uint64;
+#else
+typedef unsigned long long uint64;
+#endif
 
 // should produce compiler error if size is wrong
 typedef unsigned char validate_uint32[sizeof(uint32)==4];
 
+// SSE2 versions of the PNG filters and of the RGB to RGBA expansion, with
+// an SSSE3 shuffle picked at run time; they give exactly the same bytes
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define STBI_SSE2
+#include <emmintrin.h>
+#if (defined(__GNUC__) || defined(__clang__)) && (defined(__x86_64__) || defined(__i386__))
+#define STBI_SSSE3
+#include <tmmintrin.h>
+#define STBI_TARGET_SSSE3 __attribute__((target("ssse3")))
+#endif
+#endif
+
 #if defined(STBI_NO_STDIO) && !defined(STBI_NO_WRITE)
 #define STBI_NO_WRITE
 #endif
@@ -114,8 +131,18 @@ typedef unsigned char validate_uint32[sizeof(uint32)==4];
 // Generic API that works on all image types
 //
 
-// this is not threadsafe
-static char *failure_reason;
+// each thread has its own failure reason, so that images can be loaded on several threads at once
+#if defined(_MSC_VER)
+   #define STBI_THREAD_LOCAL __declspec(thread)
+#elif defined(__GNUC__)
+   #define STBI_THREAD_LOCAL __thread
+#elif defined(__STDC_VERSION__) && __STDC_VERSION__ >= 201112L
+   #define STBI_THREAD_LOCAL _Thread_local
+#else
+   #define STBI_THREAD_LOCAL
+#endif
+
+static STBI_THREAD_LOCAL char *failure_reason;
 
 char *stbi_failure_reason(void)
 {
@@ -320,12 +347,37 @@ extern int      stbi_is_hdr_from_file(FILE *f)
 
 #endif
 
-// @TODO: get image dimensions & components without fully decoding
+// get image dimensions & components without fully decoding; only JPEG and
+// PNG headers are understood so far
 #ifndef STBI_NO_STDIO
-extern int      stbi_info            (char const *filename,           int *x, int *y, int *comp);
-extern int      stbi_info_from_file  (FILE *f,                  int *x, int *y, int *comp);
+int stbi_info(char const *filename, int *x, int *y, int *comp)
+{
+   FILE *f = fopen(filename, "rb");
+   int result;
+   if (!f) return e("can't fopen", "Unable to open file");
+   result = stbi_info_from_file(f, x, y, comp);
+   fclose(f);
+   return result;
+}
+
+int stbi_info_from_file(FILE *f, int *x, int *y, int *comp)
+{
+   if (stbi_jpeg_test_file(f))
+      return stbi_jpeg_info_from_file(f,x,y,comp);
+   if (stbi_png_test_file(f))
+      return stbi_png_info_from_file(f,x,y,comp);
+   return e("unknown image type", "Image not of any known type, or corrupt");
+}
 #endif
-extern int      stbi_info_from_memory(stbi_uc const *buffer, int len, int *x, int *y, int *comp);
+
+int stbi_info_from_memory(stbi_uc const *buffer, int len, int *x, int *y, int *comp)
+{
+   if (stbi_jpeg_test_memory(buffer,len))
+      return stbi_jpeg_info_from_memory(buffer,len,x,y,comp);
+   if (stbi_png_test_memory(buffer,len))
+      return stbi_png_info_from_memory(buffer,len,x,y,comp);
+   return e("unknown image type", "Image not of any known type, or corrupt");
+}
 
 #ifndef STBI_NO_HDR
 static float h2l_gamma_i=1.0f/2.2f, h2l_scale_i=1.0f;
@@ -467,6 +519,54 @@ static uint8 compute_y(int r, int g, int b)
    return (uint8) (((r*77) + (g*150) +  (29*b)) >> 8);
 }
 
+#ifdef STBI_SSSE3
+static int has_ssse3(void)
+{
+   static int supported = -1;
+   if (supported < 0) {
+      __builtin_cpu_init();
+      supported = __builtin_cpu_supports("ssse3") ? 1 : 0;
+   }
+   return supported;
+}
+
+// expands 16 pixels at a time, returns how many were done
+STBI_TARGET_SSSE3 static uint expand_rgb_to_rgba_ssse3(uint8 *dest, uint8 *src, uint count)
+{
+   const __m128i spread = _mm_setr_epi8(0,1,2,-1, 3,4,5,-1, 6,7,8,-1, 9,10,11,-1);
+   const __m128i alpha = _mm_set1_epi32((int) 0xff000000);
+   uint i;
+   for (i=0; i + 16 <= count; i += 16, src += 48, dest += 64) {
+      __m128i v0 = _mm_loadu_si128((__m128i *) src);
+      __m128i v1 = _mm_loadu_si128((__m128i *) (src + 16));
+      __m128i v2 = _mm_loadu_si128((__m128i *) (src + 32));
+      _mm_storeu_si128((__m128i *)  dest      , _mm_or_si128(_mm_shuffle_epi8(v0, spread), alpha));
+      _mm_storeu_si128((__m128i *) (dest + 16), _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(v1, v0, 12), spread), alpha));
+      _mm_storeu_si128((__m128i *) (dest + 32), _mm_or_si128(_mm_shuffle_epi8(_mm_alignr_epi8(v2, v1, 8), spread), alpha));
+      _mm_storeu_si128((__m128i *) (dest + 48), _mm_or_si128(_mm_shuffle_epi8(_mm_srli_si128(v2, 4), spread), alpha));
+   }
+   return i;
+}
+#endif
+
+static void expand_rgb_to_rgba(uint8 *dest, uint8 *src, uint count)
+{
+   uint i = 0;
+   #ifdef STBI_SSSE3
+   if (has_ssse3()) {
+      i = expand_rgb_to_rgba_ssse3(dest, src, count);
+      src += i*3;
+      dest += i*4;
+   }
+   #endif
+   for (; i < count; ++i, src += 3, dest += 4) {
+      dest[0] = src[0];
+      dest[1] = src[1];
+      dest[2] = src[2];
+      dest[3] = 255;
+   }
+}
+
 static unsigned char *convert_format(unsigned char *data, int img_n, int req_comp, uint x, uint y)
 {
    int i,j;
@@ -496,7 +596,7 @@ static unsigned char *convert_format(unsigned char *data, int img_n, int req_com
          CASE(2,1) dest[0]=src[0]; break;
          CASE(2,3) dest[0]=dest[1]=dest[2]=src[0]; break;
          CASE(2,4) dest[0]=dest[1]=dest[2]=src[0], dest[3]=src[1]; break;
-         CASE(3,4) dest[0]=src[0],dest[1]=src[1],dest[2]=src[2],dest[3]=255; break;
+         case COMBO(3,4): expand_rgb_to_rgba(dest, src, x); break;
          CASE(3,1) dest[0]=compute_y(src[0],src[1],src[2]); break;
          CASE(3,2) dest[0]=compute_y(src[0],src[1],src[2]), dest[1] = 255; break;
          CASE(4,1) dest[0]=compute_y(src[0],src[1],src[2]); break;
@@ -1589,12 +1689,45 @@ int stbi_jpeg_test_memory(stbi_uc const *buffer, int len)
    return decode_jpeg_header(&j, SCAN_type);
 }
 
-// @TODO:
+// reads up to the frame header, which has the size and components
+static int jpeg_info(jpeg *j, int *x, int *y, int *comp)
+{
+   if (!decode_jpeg_header(j, SCAN_header)) return 0;
+   if (x) *x = j->s.img_x;
+   if (y) *y = j->s.img_y;
+   if (comp) *comp = j->s.img_n;
+   return 1;
+}
+
 #ifndef STBI_NO_STDIO
-extern int      stbi_jpeg_info            (char const *filename,           int *x, int *y, int *comp);
-extern int      stbi_jpeg_info_from_file  (FILE *f,                  int *x, int *y, int *comp);
+int stbi_jpeg_info(char const *filename, int *x, int *y, int *comp)
+{
+   FILE *f = fopen(filename, "rb");
+   int result;
+   if (!f) return e("can't fopen", "Unable to open file");
+   result = stbi_jpeg_info_from_file(f, x, y, comp);
+   fclose(f);
+   return result;
+}
+
+int stbi_jpeg_info_from_file(FILE *f, int *x, int *y, int *comp)
+{
+   int n,r;
+   jpeg j;
+   n = ftell(f);
+   start_file(&j.s, f);
+   r = jpeg_info(&j, x, y, comp);
+   fseek(f,n,SEEK_SET);
+   return r;
+}
 #endif
-extern int      stbi_jpeg_info_from_memory(stbi_uc const *buffer, int len, int *x, int *y, int *comp);
+
+int stbi_jpeg_info_from_memory(stbi_uc const *buffer, int len, int *x, int *y, int *comp)
+{
+   jpeg j;
+   start_mem(&j.s, buffer,len);
+   return jpeg_info(&j, x, y, comp);
+}
 
 // public domain zlib decode    v0.2  Sean Barrett 2006-11-18
 //    simple implementation
@@ -1602,11 +1735,30 @@ extern int      stbi_jpeg_info_from_memory(stbi_uc const *buffer, int len, int *
 //      - all output is written to a single output buffer (can malloc/realloc)
 //    performance
 //      - fast huffman
+//      - 64-bit bit buffer refilled 8 bytes at a time
+//      - lookup tables that decode two literals, or a length or distance
+//        with its extra bits, in one step
+//      - matches copied 8 bytes at a time
 
 // fast-way is faster to check than jpeg huffman, but slow way is slower
 #define ZFAST_BITS  9 // accelerate all cases in default tables
 #define ZFAST_MASK  ((1 << ZFAST_BITS) - 1)
 
+// the lookup tables used by the block decoder
+#define ZTABLE_BITS  11
+#define ZTABLE_MASK  ((1 << ZTABLE_BITS) - 1)
+
+// a table entry holds the number of bits it consumes in its low byte,
+// what it decoded in the next 2 bits, and the decoded value(s) on top
+#define ZKIND_LITERAL   0 // one literal
+#define ZKIND_LITERAL2  1 // two literals, the first in bits 16-23
+#define ZKIND_VALUE     2 // a match length or distance, see below
+#define ZKIND_SLOW      3 // anything else, decoded with zhuffman_decode
+
+// the extra bits of a length or distance are added to the value in the
+// entry when they fit in the table, otherwise bits 12-15 hold how many
+// still have to be read after the bits the entry consumes
+
 // zlib-style huffman encoding
 // (jpegs packs from left, zlib from right, so can't share code)
 typedef struct
@@ -1617,6 +1769,7 @@ typedef struct
    uint16 firstsymbol[16];
    uint8  size[288];
    uint16 value[288];
+   uint32 table[1 << ZTABLE_BITS];
 } zhuffman;
 
 __forceinline static int bitreverse16(int n)
@@ -1636,7 +1789,7 @@ __forceinline static int bit_reverse(int v, int bits)
    return bitreverse16(v) >> (16-bits);
 }
 
-static int zbuild_huffman(zhuffman *z, uint8 *sizelist, int num)
+static int zbuild_huffman(zhuffman *z, const uint8 *sizelist, int num)
 {
    int i,k=0;
    int code, next_code[16], sizes[17];
@@ -1648,7 +1801,7 @@ static int zbuild_huffman(zhuffman *z, uint8 *sizelist, int num)
       ++sizes[sizelist[i]];
    sizes[0] = 0;
    for (i=1; i < 16; ++i)
-      assert(sizes[i] <= (1 << i));
+      if (sizes[i] > (1 << i)) return e("bad codelengths","Corrupt PNG");
    code = 0;
    for (i=1; i < 16; ++i) {
       next_code[i] = code;
@@ -1662,6 +1815,9 @@ static int zbuild_huffman(zhuffman *z, uint8 *sizelist, int num)
       k += sizes[i];
    }
    z->maxcode[16] = 0x10000; // sentinel
+   // the lookup table starts out as (code size << 16 | symbol) for
+   // the codes that fit, see zbuild_table
+   memset(z->table, 0, sizeof(z->table));
    for (i=0; i < num; ++i) {
       int s = sizelist[i];
       if (s) {
@@ -1675,6 +1831,13 @@ static int zbuild_huffman(zhuffman *z, uint8 *sizelist, int num)
                k += (1 << s);
             }
          }
+         if (s <= ZTABLE_BITS) {
+            int k = bit_reverse(next_code[s],s);
+            while (k < (1 << ZTABLE_BITS)) {
+               z->table[k] = ((uint32) s << 16) | (uint32) i;
+               k += (1 << s);
+            }
+         }
          ++next_code[s];
       }
    }
@@ -1691,7 +1854,8 @@ typedef struct
 {
    uint8 *zbuffer, *zbuffer_end;
    int num_bits;
-   uint32 code_buffer;
+   int num_past_end; // zero bytes added to code_buffer after the input ran out
+   uint64 code_buffer;
 
    char *zout;
    char *zout_start;
@@ -1707,20 +1871,42 @@ __forceinline static int zget8(zbuf *z)
    return *z->zbuffer++;
 }
 
+__forceinline static uint64 zload64(const uint8 *p)
+{
+   #if defined(__i386__) || defined(__x86_64__) || defined(_M_IX86) || defined(_M_X64)
+   uint64 v;
+   memcpy(&v, p, 8); // little endian, so the bytes are already in order
+   return v;
+   #else
+   return  (uint64) p[0]        | ((uint64) p[1] <<  8) | ((uint64) p[2] << 16) | ((uint64) p[3] << 24) |
+          ((uint64) p[4] << 32) | ((uint64) p[5] << 40) | ((uint64) p[6] << 48) | ((uint64) p[7] << 56);
+   #endif
+}
+
+// tops code_buffer up to at least 56 bits
 static void fill_bits(zbuf *z)
 {
-   do {
-      assert(z->code_buffer < (1U << z->num_bits));
-      z->code_buffer |= zget8(z) << z->num_bits;
-      z->num_bits += 8;
-   } while (z->num_bits <= 24);
+   if (z->zbuffer_end - z->zbuffer >= 8) {
+      // load 8 bytes and keep the whole ones that fit; the bits above
+      // num_bits are the next input bytes, so the next load ORs in the
+      // same values
+      z->code_buffer |= zload64(z->zbuffer) << z->num_bits;
+      z->zbuffer += (63 - z->num_bits) >> 3;
+      z->num_bits |= 56;
+   } else {
+      do {
+         if (z->zbuffer >= z->zbuffer_end) ++z->num_past_end;
+         z->code_buffer |= (uint64) zget8(z) << z->num_bits;
+         z->num_bits += 8;
+      } while (z->num_bits < 56);
+   }
 }
 
 __forceinline static unsigned int zreceive(zbuf *z, int n)
 {
    unsigned int k;
    if (z->num_bits < n) fill_bits(z);
-   k = z->code_buffer & ((1 << n) - 1);
+   k = (unsigned int) z->code_buffer & ((1 << n) - 1);
    z->code_buffer >>= n;
    z->num_bits -= n;
    return k;
@@ -1730,7 +1916,7 @@ __forceinline static int zhuffman_decode(zbuf *a, zhuffman *z)
 {
    int b,s,k;
    if (a->num_bits < 16) fill_bits(a);
-   b = z->fast[a->code_buffer & ZFAST_MASK];
+   b = z->fast[(int) a->code_buffer & ZFAST_MASK];
    if (b < 0xffff) {
       s = z->size[b];
       a->code_buffer >>= s;
@@ -1740,7 +1926,7 @@ __forceinline static int zhuffman_decode(zbuf *a, zhuffman *z)
 
    // not resolved by fast table, so compute it the slow way
    // use jpeg approach, which requires MSbits at top
-   k = bit_reverse(a->code_buffer, 16);
+   k = bit_reverse((int) a->code_buffer & 0xffff, 16);
    for (s=ZFAST_BITS+1; ; ++s)
       if (k < z->maxcode[s])
          break;
@@ -1784,30 +1970,140 @@ static int dist_base[32] = { 1,2,3,4,5,7,9,13,17,25,33,49,65,97,129,193,
 static int dist_extra[32] =
 { 0,0,0,0,1,1,2,2,3,3,4,4,5,5,6,6,7,7,8,8,9,9,10,10,11,11,12,12,13,13};
 
+// turns the (code size << 16 | symbol) entries zbuild_huffman leaves in the
+// table into entries that decode as much as possible in one lookup
+static uint32 zvalue_entry(int i, int size, int base, int extra)
+{
+   if (size + extra <= ZTABLE_BITS)
+      return (size + extra) | (ZKIND_VALUE << 8) | ((uint32) (base + ((i >> size) & ((1 << extra) - 1))) << 16);
+   return size | (ZKIND_VALUE << 8) | (extra << 12) | ((uint32) base << 16);
+}
+
+static void zbuild_table(zhuffman *z, int distance)
+{
+   int i;
+   // going down, i >> size is always an entry that hasn't been changed yet
+   for (i=(1 << ZTABLE_BITS)-1; i >= 0; --i) {
+      uint32 entry = z->table[i];
+      int size = entry >> 16, sym = entry & 0xffff;
+      if (size == 0) {
+         // the code is longer than the table
+         z->table[i] = ZKIND_SLOW << 8;
+      } else if (distance) {
+         if (sym < 30)
+            z->table[i] = zvalue_entry(i, size, dist_base[sym], dist_extra[sym]);
+         else
+            z->table[i] = ZKIND_SLOW << 8;
+      } else if (sym < 256) {
+         uint32 next = z->table[i >> size];
+         int next_size = next >> 16, next_sym = next & 0xffff;
+         if (next_size && size + next_size <= ZTABLE_BITS && next_sym < 256)
+            z->table[i] = (size + next_size) | (ZKIND_LITERAL2 << 8) | ((uint32) sym << 16) | ((uint32) next_sym << 24);
+         else
+            z->table[i] = size | (ZKIND_LITERAL << 8) | ((uint32) sym << 16);
+      } else if (sym >= 257 && sym < 286) {
+         z->table[i] = zvalue_entry(i, size, length_base[sym-257], length_extra[sym-257]);
+      } else {
+         // end of block, or an invalid symbol
+         z->table[i] = ZKIND_SLOW << 8;
+      }
+   }
+}
+
+// decodes the value of a ZKIND_VALUE entry
+__forceinline static int zvalue(zbuf *a, uint32 entry)
+{
+   int n = entry & 255, extra = (entry >> 12) & 15;
+   int v = (entry >> 16) + ((int) (a->code_buffer >> n) & ((1 << extra) - 1));
+   a->code_buffer >>= n + extra;
+   a->num_bits -= n + extra;
+   return v;
+}
+
 static int parse_huffman_block(zbuf *a)
 {
+   // zout is kept in a local, as the output can alias anything
+   char *zout = a->zout;
    for(;;) {
-      int z = zhuffman_decode(a, &a->z_length);
-      if (z < 256) {
-         if (z < 0) return e("bad huffman code","Corrupt PNG"); // error in huffman codes
-         if (a->zout >= a->zout_end) if (!expand(a, 1)) return 0;
-         *a->zout++ = (char) z;
+      uint32 entry;
+      int len,dist,n;
+      uint8 *p;
+      // enough bits for a length and a distance with their extra bits
+      if (a->num_bits < 48) {
+         fill_bits(a);
+         // at most 7 of the zero bytes can still be in the bit buffer,
+         // so more means a truncated stream is being decoded from zeros
+         if (a->num_past_end > 7) return e("unexpected end","Corrupt PNG");
+      }
+      entry = a->z_length.table[(int) a->code_buffer & ZTABLE_MASK];
+      n = (entry >> 8) & 3;
+      if (n <= ZKIND_LITERAL2) {
+         if (a->zout_end - zout < 1 + n) {
+            a->zout = zout;
+            if (!expand(a, 1 + n)) return 0;
+            zout = a->zout;
+         }
+         *zout++ = (char) (entry >> 16);
+         if (n == ZKIND_LITERAL2) *zout++ = (char) (entry >> 24);
+         a->code_buffer >>= entry & 255;
+         a->num_bits -= entry & 255;
+         continue;
+      }
+      if (n == ZKIND_VALUE) {
+         len = zvalue(a, entry);
       } else {
-         uint8 *p;
-         int len,dist;
-         if (z == 256) return 1;
+         int z = zhuffman_decode(a, &a->z_length);
+         if (z < 256) {
+            if (z < 0) return e("bad huffman code","Corrupt PNG"); // error in huffman codes
+            if (zout >= a->zout_end) {
+               a->zout = zout;
+               if (!expand(a, 1)) return 0;
+               zout = a->zout;
+            }
+            *zout++ = (char) z;
+            continue;
+         }
+         if (z == 256) {
+            a->zout = zout;
+            return 1;
+         }
          z -= 257;
+         if (z >= 29) return e("bad huffman code","Corrupt PNG"); // 286 and 287 are never used
          len = length_base[z];
          if (length_extra[z]) len += zreceive(a, length_extra[z]);
-         z = zhuffman_decode(a, &a->z_distance);
-         if (z < 0) return e("bad huffman code","Corrupt PNG");
+      }
+      entry = a->z_distance.table[(int) a->code_buffer & ZTABLE_MASK];
+      if (((entry >> 8) & 3) == ZKIND_VALUE) {
+         dist = zvalue(a, entry);
+      } else {
+         int z = zhuffman_decode(a, &a->z_distance);
+         if (z < 0 || z >= 30) return e("bad huffman code","Corrupt PNG");
          dist = dist_base[z];
          if (dist_extra[z]) dist += zreceive(a, dist_extra[z]);
-         if (a->zout - a->zout_start < dist) return e("bad dist","Corrupt PNG");
-         if (a->zout + len > a->zout_end) if (!expand(a, len)) return 0;
-         p = (uint8 *) (a->zout - dist);
+      }
+      if (zout - a->zout_start < dist) return e("bad dist","Corrupt PNG");
+      if (zout + len > a->zout_end) {
+         a->zout = zout;
+         if (!expand(a, len)) return 0;
+         zout = a->zout;
+      }
+      p = (uint8 *) (zout - dist);
+      if (dist >= 8 && a->zout_end - zout >= len + 8) {
+         // the copies may run up to 7 bytes past the match, which is
+         // fine as there is room and those bytes get overwritten later
+         char *end = zout + len;
+         do {
+            memcpy(zout, p, 8);
+            zout += 8;
+            p += 8;
+         } while (zout < end);
+         zout = end;
+      } else if (dist == 1) {
+         memset(zout, *p, len);
+         zout += len;
+      } else {
          while (len--)
-            *a->zout++ = *p++;
+            *zout++ = *p++;
       }
    }
 }
@@ -1815,7 +2111,7 @@ static int parse_huffman_block(zbuf *a)
 static int compute_huffman_codes(zbuf *a)
 {
    static uint8 length_dezigzag[19] = { 16,17,18,0,8,7,9,6,10,5,11,4,12,3,13,2,14,1,15 };
-   static zhuffman z_codelength; // static just to save stack space
+   zhuffman z_codelength; // not static, so images can be decoded on several threads
    uint8 lencodes[286+32+137];//padding for maximum single op
    uint8 codelength_sizes[19];
    int i,n;
@@ -1834,21 +2130,21 @@ static int compute_huffman_codes(zbuf *a)
    n = 0;
    while (n < hlit + hdist) {
       int c = zhuffman_decode(a, &z_codelength);
-      assert(c >= 0 && c < 19);
+      if (c < 0 || c >= 19) return e("bad codelengths","Corrupt PNG");
       if (c < 16)
          lencodes[n++] = (uint8) c;
-      else if (c == 16) {
-         c = zreceive(a,2)+3;
-         memset(lencodes+n, lencodes[n-1], c);
-         n += c;
-      } else if (c == 17) {
-         c = zreceive(a,3)+3;
-         memset(lencodes+n, 0, c);
-         n += c;
-      } else {
-         assert(c == 18);
-         c = zreceive(a,7)+11;
-         memset(lencodes+n, 0, c);
+      else {
+         int fill = 0;
+         if (c == 16) {
+            if (n == 0) return e("bad codelengths","Corrupt PNG"); // nothing to repeat
+            c = zreceive(a,2)+3;
+            fill = lencodes[n-1];
+         } else if (c == 17)
+            c = zreceive(a,3)+3;
+         else
+            c = zreceive(a,7)+11;
+         if (c > hlit + hdist - n) return e("bad codelengths","Corrupt PNG");
+         memset(lencodes+n, fill, c);
          n += c;
       }
    }
@@ -1864,17 +2160,15 @@ static int parse_uncompressed_block(zbuf *a)
    int len,nlen,k;
    if (a->num_bits & 7)
       zreceive(a, a->num_bits & 7); // discard
-   // drain the bit-packed data into header
-   k = 0;
-   while (a->num_bits > 0) {
-      header[k++] = (uint8) (a->code_buffer & 255); // wtf this warns?
-      a->code_buffer >>= 8;
-      a->num_bits -= 8;
-   }
-   assert(a->num_bits == 0);
-   // now fill header the normal way
-   while (k < 4)
-      header[k++] = (uint8) zget8(a);
+   // give back the whole bytes still in the bit buffer, except for the
+   // zeros added past the end of the input, and read the header directly
+   k = (a->num_bits >> 3) - a->num_past_end;
+   if (k > 0) a->zbuffer -= k;
+   a->code_buffer = 0;
+   a->num_bits = 0;
+   a->num_past_end = 0;
+   for (k=0; k < 4; ++k)
+      header[k] = (uint8) zget8(a);
    len  = header[1] * 256 + header[0];
    nlen = header[3] * 256 + header[2];
    if (nlen != (len ^ 0xffff)) return e("zlib corrupt","Corrupt PNG");
@@ -1900,18 +2194,24 @@ static int parse_zlib_header(zbuf *a)
    return 1;
 }
 
-// @TODO: should statically initialize these for optimal thread safety
-static uint8 default_length[288], default_distance[32];
-static void init_defaults(void)
+// the code lengths of the fixed huffman codes, statically initialized so that they are never
+// written while another thread reads them
+static const uint8 default_length[288] =
 {
-   int i;   // use <= to match clearly with spec
-   for (i=0; i <= 143; ++i)     default_length[i]   = 8;
-   for (   ; i <= 255; ++i)     default_length[i]   = 9;
-   for (   ; i <= 279; ++i)     default_length[i]   = 7;
-   for (   ; i <= 287; ++i)     default_length[i]   = 8;
-
-   for (i=0; i <=  31; ++i)     default_distance[i] = 5;
-}
+   8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,
+   8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,
+   8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,
+   8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,
+   8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,8,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
+   9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
+   9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
+   9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,9,
+   7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,7,8,8,8,8,8,8,8,8
+};
+static const uint8 default_distance[32] =
+{
+   5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5,5
+};
 
 static int parse_zlib(zbuf *a, int parse_header)
 {
@@ -1919,6 +2219,7 @@ static int parse_zlib(zbuf *a, int parse_header)
    if (parse_header)
       if (!parse_zlib_header(a)) return 0;
    a->num_bits = 0;
+   a->num_past_end = 0;
    a->code_buffer = 0;
    do {
       final = zreceive(a,1);
@@ -1926,17 +2227,21 @@ static int parse_zlib(zbuf *a, int parse_header)
       if (type == 0) {
          if (!parse_uncompressed_block(a)) return 0;
       } else if (type == 3) {
-         return 0;
+         return e("bad block type","Corrupt PNG");
       } else {
          if (type == 1) {
             // use fixed code lengths
-            if (!default_distance[31]) init_defaults();
             if (!zbuild_huffman(&a->z_length  , default_length  , 288)) return 0;
             if (!zbuild_huffman(&a->z_distance, default_distance,  32)) return 0;
          } else {
             if (!compute_huffman_codes(a)) return 0;
          }
+         zbuild_table(&a->z_length, 0);
+         zbuild_table(&a->z_distance, 1);
          if (!parse_huffman_block(a)) return 0;
+         // a truncated stream can end early if the zeros added past the end
+         // of the input decode as valid codes, so check none were used
+         if (a->num_past_end * 8 > a->num_bits) return e("unexpected end","Corrupt PNG");
       }
    } while (!final);
    return 1;
@@ -2075,6 +2380,143 @@ static int paeth(int a, int b, int c)
    return c;
 }
 
+#ifdef STBI_SSE2
+// the filters of 3 and 4 byte pixels are done a pixel at a time, as each
+// pixel depends on the one to its left, but on all bytes of it at once
+
+static __m128i load_pixel(uint8 *p, int n)
+{
+   uint32 v;
+   if (n == 4)
+      memcpy(&v, p, 4);
+   else
+      v = p[0] | (p[1] << 8) | (p[2] << 16);
+   return _mm_cvtsi32_si128((int) v);
+}
+
+static void store_pixel(uint8 *p, __m128i v, int n)
+{
+   uint32 x = (uint32) _mm_cvtsi128_si32(v);
+   if (n == 4)
+      memcpy(p, &x, 4);
+   else {
+      p[0] = (uint8) x;
+      p[1] = (uint8) (x >> 8);
+      p[2] = (uint8) (x >> 16);
+   }
+}
+
+// paeth() on 16-bit lanes
+static __m128i paeth_sse2(__m128i a, __m128i b, __m128i c)
+{
+   __m128i zero = _mm_setzero_si128();
+   __m128i pa = _mm_sub_epi16(b, c); // p - a
+   __m128i pb = _mm_sub_epi16(a, c); // p - b
+   __m128i pc = _mm_add_epi16(pa, pb); // p - c
+   __m128i smallest, use_a, use_b;
+   pa = _mm_max_epi16(pa, _mm_sub_epi16(zero, pa));
+   pb = _mm_max_epi16(pb, _mm_sub_epi16(zero, pb));
+   pc = _mm_max_epi16(pc, _mm_sub_epi16(zero, pc));
+   smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+   // a wins ties with b and c, and b wins ties with c
+   use_a = _mm_cmpeq_epi16(pa, smallest);
+   use_b = _mm_cmpeq_epi16(pb, smallest);
+   c = _mm_or_si128(_mm_and_si128(use_b, b), _mm_andnot_si128(use_b, c));
+   return _mm_or_si128(_mm_and_si128(use_a, a), _mm_andnot_si128(use_a, c));
+}
+
+// unfilters a row of x pixels of n (3 or 4) bytes
+static void defilter_row_sse2(uint8 *cur, uint8 *prior, uint8 *raw, int filter, int n, uint32 x)
+{
+   __m128i zero = _mm_setzero_si128();
+   __m128i a = zero, b, c = zero; // left, up and up left pixels
+   uint32 i, bytes = x * n;
+   switch (filter) {
+      case F_none:
+         memcpy(cur, raw, bytes);
+         break;
+      case F_up:
+         for (i=0; i + 16 <= bytes; i += 16) {
+            __m128i r = _mm_loadu_si128((__m128i *) (raw + i));
+            __m128i p = _mm_loadu_si128((__m128i *) (prior + i));
+            _mm_storeu_si128((__m128i *) (cur + i), _mm_add_epi8(r, p));
+         }
+         for (; i < bytes; ++i)
+            cur[i] = raw[i] + prior[i];
+         break;
+      case F_sub:
+      case F_paeth_first: // paeth(a,0,0) is always a
+         for (i=0; i < x; ++i, raw += n, cur += n) {
+            a = _mm_add_epi8(a, load_pixel(raw, n));
+            store_pixel(cur, a, n);
+         }
+         break;
+      case F_avg:
+         for (i=0; i < x; ++i, raw += n, cur += n, prior += n) {
+            // _mm_avg_epu8 rounds up, the filter rounds down
+            b = load_pixel(prior, n);
+            b = _mm_sub_epi8(_mm_avg_epu8(a, b), _mm_and_si128(_mm_xor_si128(a, b), _mm_set1_epi8(1)));
+            a = _mm_add_epi8(load_pixel(raw, n), b);
+            store_pixel(cur, a, n);
+         }
+         break;
+      case F_avg_first:
+         for (i=0; i < x; ++i, raw += n, cur += n) {
+            b = _mm_and_si128(_mm_srli_epi16(a, 1), _mm_set1_epi8(0x7f));
+            a = _mm_add_epi8(load_pixel(raw, n), b);
+            store_pixel(cur, a, n);
+         }
+         break;
+      case F_paeth:
+         // a and c are kept as 16-bit lanes
+         for (i=0; i < x; ++i, raw += n, cur += n, prior += n) {
+            __m128i p;
+            b = _mm_unpacklo_epi8(load_pixel(prior, n), zero);
+            p = _mm_packus_epi16(paeth_sse2(a, b, c), zero);
+            p = _mm_add_epi8(load_pixel(raw, n), p);
+            store_pixel(cur, p, n);
+            a = _mm_unpacklo_epi8(p, zero);
+            c = b;
+         }
+         break;
+   }
+}
+
+// create_png_image for 3 and 4 byte pixels
+static int create_png_image_sse2(png *a, uint8 *raw, int out_n)
+{
+   stbi *s = &a->s;
+   uint32 j, stride = s->img_x*out_n;
+   int img_n = s->img_n;
+   uint8 *rows = NULL;
+   if (img_n != out_n) {
+      // unfilter into two rows of img_n pixels, then expand them
+      rows = (uint8 *) malloc(s->img_x * img_n * 2);
+      if (!rows) return e("outofmem", "Out of memory");
+   }
+   for (j=0; j < s->img_y; ++j) {
+      uint8 *cur = a->out + stride*j;
+      uint8 *prior = cur - stride;
+      int filter = *raw++;
+      if (filter > 4) {
+         free(rows);
+         return e("invalid filter","Corrupt PNG");
+      }
+      // if first row, use special filter that doesn't sample previous row
+      if (j == 0) filter = first_row_filter[filter];
+      if (rows) {
+         uint8 *unfiltered = rows + (j & 1) * s->img_x * img_n;
+         defilter_row_sse2(unfiltered, rows + (~j & 1) * s->img_x * img_n, raw, filter, img_n, s->img_x);
+         expand_rgb_to_rgba(cur, unfiltered, s->img_x);
+      } else
+         defilter_row_sse2(cur, prior, raw, filter, img_n, s->img_x);
+      raw += s->img_x * img_n;
+   }
+   free(rows);
+   return 1;
+}
+#endif
+
 // create the png data from post-deflated data
 static int create_png_image(png *a, uint8 *raw, uint32 raw_len, int out_n)
 {
@@ -2086,6 +2528,9 @@ static int create_png_image(png *a, uint8 *raw, uint32 raw_len, int out_n)
    a->out = (uint8 *) malloc(s->img_x * s->img_y * out_n);
    if (!a->out) return e("outofmem", "Out of memory");
    if (raw_len != (img_n * s->img_x + 1) * s->img_y) return e("not enough pixels","Corrupt PNG");
+   #ifdef STBI_SSE2
+   if (img_n >= 3) return create_png_image_sse2(a, raw, out_n);
+   #endif
    for (j=0; j < s->img_y; ++j) {
       uint8 *cur = a->out + stride*j;
       uint8 *prior = cur - stride;
@@ -2284,6 +2729,15 @@ static int parse_png_file(png *z, int scan, int req_comp)
          case PNG_TYPE('I','D','A','T'): {
             if (pal_img_n && !pal_len) return e("no PLTE","Corrupt PNG");
             if (scan == SCAN_header) { s->img_n = pal_img_n; return 1; }
+            #ifndef STBI_NO_STDIO
+            if (!s->img_file)
+            #endif
+            {
+               // a chunk that was cut short must not be copied from past the end of the buffer
+               if (s->img_buffer > s->img_buffer_end || c.length > (uint32) (s->img_buffer_end - s->img_buffer))
+                  return e("outofdata","Corrupt PNG");
+            }
+            if (c.length == 0) break;
             if (ioff + c.length > idata_limit) {
                uint8 *p;
                if (idata_limit == 0) idata_limit = c.length > 4096 ? c.length : 4096;
@@ -2311,7 +2765,10 @@ static int parse_png_file(png *z, int scan, int req_comp)
             uint32 raw_len;
             if (scan != SCAN_load) return 1;
             if (z->idata == NULL) return e("no IDAT","Corrupt PNG");
-            z->expanded = (uint8 *) stbi_zlib_decode_malloc((char *) z->idata, ioff, (int *) &raw_len);
+            // the filtered scanlines have a known size, so inflate into a
+            // buffer that size instead of growing one from 16k
+            raw_len = s->img_y * (s->img_x * s->img_n + 1);
+            z->expanded = (uint8 *) stbi_zlib_decode_malloc_guesssize((char *) z->idata, ioff, (int) raw_len, (int *) &raw_len);
             if (z->expanded == NULL) return 0; // zlib should set error
             free(z->idata); z->idata = NULL;
             if ((req_comp == s->img_n+1 && req_comp != 3 && !pal_img_n) || has_trans)
@@ -2337,8 +2794,8 @@ static int parse_png_file(png *z, int scan, int req_comp)
             // if critical, fail
             if ((c.type & (1 << 29)) == 0) {
                #ifndef STBI_NO_FAILURE_STRINGS
-               // not threadsafe
-               static char invalid_chunk[] = "XXXX chunk not known";
+               // per thread, as failure_reason points to it
+               static STBI_THREAD_LOCAL char invalid_chunk[] = "XXXX chunk not known";
                invalid_chunk[0] = (uint8) (c.type >> 24);
                invalid_chunk[1] = (uint8) (c.type >> 16);
                invalid_chunk[2] = (uint8) (c.type >>  8);
@@ -2426,12 +2883,49 @@ int stbi_png_test_memory(stbi_uc const *buffer, int len)
    return parse_png_file(&p, SCAN_type,STBI_default);
 }
 
-// TODO: load header from png
+// reads up to IHDR, or for paletted images up to the tRNS chunk or the
+// first IDAT, which tells whether the palette has alpha
+static int png_info(png *p, int *x, int *y, int *comp)
+{
+   p->expanded = NULL;
+   p->idata = NULL;
+   p->out = NULL;
+   if (!parse_png_file(p, SCAN_header, STBI_default)) return 0;
+   if (x) *x = p->s.img_x;
+   if (y) *y = p->s.img_y;
+   if (comp) *comp = p->s.img_n;
+   return 1;
+}
+
 #ifndef STBI_NO_STDIO
-extern int      stbi_png_info             (char const *filename,           int *x, int *y, int *comp);
-extern int      stbi_png_info_from_file   (FILE *f,                  int *x, int *y, int *comp);
+int stbi_png_info(char const *filename, int *x, int *y, int *comp)
+{
+   FILE *f = fopen(filename, "rb");
+   int result;
+   if (!f) return e("can't fopen", "Unable to open file");
+   result = stbi_png_info_from_file(f, x, y, comp);
+   fclose(f);
+   return result;
+}
+
+int stbi_png_info_from_file(FILE *f, int *x, int *y, int *comp)
+{
+   png p;
+   int n,r;
+   n = ftell(f);
+   start_file(&p.s, f);
+   r = png_info(&p, x, y, comp);
+   fseek(f,n,SEEK_SET);
+   return r;
+}
 #endif
-extern int      stbi_png_info_from_memory (stbi_uc const *buffer, int len, int *x, int *y, int *comp);
+
+int stbi_png_info_from_memory(stbi_uc const *buffer, int len, int *x, int *y, int *comp)
+{
+   png p;
+   start_mem(&p.s, buffer, len);
+   return png_info(&p, x, y, comp);
+}
 
 // Microsoft/Windows BMP image
 
@@ -3603,8 +4097,10 @@ static void writef(FILE *f, char *fmt, ...)
 static void write_pixels(FILE *f, int rgb_dir, int vdir, int x, int y, int comp, void *data, int write_alpha, int scanline_pad)
 {
    uint8 bg[3] = { 255, 0, 255}, px[3];
-   uint32 zero = 0;
    int i,j,k, j_end;
+   // each scanline is assembled and written at once, byte-wise writes through stdio are slow
+   uint8 *row = (uint8 *) malloc(x * (write_alpha ? 4 : 3) + scanline_pad);
+   if (!row) return;
 
    if (vdir < 0)
       j_end = -1, j = y-1;
@@ -3612,31 +4108,36 @@ static void write_pixels(FILE *f, int rgb_dir, int vdir, int x, int y, int comp,
       j_end =  y, j = 0;
 
    for (; j != j_end; j += vdir) {
+      uint8 *o = row;
       for (i=0; i < x; ++i) {
          uint8 *d = (uint8 *) data + (j*x+i)*comp;
          if (write_alpha < 0)
-            fwrite(&d[comp-1], 1, 1, f);
+            *o++ = d[comp-1];
          switch (comp) {
             case 1:
-            case 2: writef(f, "111", d[0],d[0],d[0]);
+            case 2: o[0] = o[1] = o[2] = d[0];
                     break;
             case 4:
                if (!write_alpha) {
                   for (k=0; k < 3; ++k)
                      px[k] = bg[k] + ((d[k] - bg[k]) * d[3])/255;
-                  writef(f, "111", px[1-rgb_dir],px[1],px[1+rgb_dir]);
+                  o[0] = px[1-rgb_dir]; o[1] = px[1]; o[2] = px[1+rgb_dir];
                   break;
                }
                /* FALLTHROUGH */
             case 3:
-               writef(f, "111", d[1-rgb_dir],d[1],d[1+rgb_dir]);
+               o[0] = d[1-rgb_dir]; o[1] = d[1]; o[2] = d[1+rgb_dir];
                break;
          }
+         o += 3;
          if (write_alpha > 0)
-            fwrite(&d[comp-1], 1, 1, f);
+            *o++ = d[comp-1];
       }
-      fwrite(&zero,scanline_pad,1,f);
+      for (k=0; k < scanline_pad; ++k)
+         *o++ = 0;
+      fwrite(row, 1, o - row, f);
    }
+   free(row);
 }
 
 static int outfile(char const *filename, int rgb_dir, int vdir, int x, int y, int comp, void *data, int alpha, int pad, char *fmt, ...)
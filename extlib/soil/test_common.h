@@ -0,0 +1,99 @@
+/*
+	Helpers shared by the tests that compare the optimized SOIL
+	functions with the original ones in the original directory
+
+	MIT license
+*/
+
+#ifndef HEADER_SOIL_TEST_COMMON
+#define HEADER_SOIL_TEST_COMMON
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _WIN32
+	#define WIN32_LEAN_AND_MEAN
+	#include <windows.h>
+#else
+	#include <time.h>
+#endif
+
+/*	wall clock time in seconds, for timing	*/
+static double test_seconds( void )
+{
+#ifdef _WIN32
+	LARGE_INTEGER frequency, counter;
+	QueryPerformanceFrequency( &frequency );
+	QueryPerformanceCounter( &counter );
+	return (double)counter.QuadPart / (double)frequency.QuadPart;
+#else
+	struct timespec now;
+	clock_gettime( CLOCK_MONOTONIC, &now );
+	return now.tv_sec + now.tv_nsec * 1e-9;
+#endif
+}
+
+/*	xorshift, so that every platform tests the same cases	*/
+static unsigned int test_random_state = 2463534242u;
+
+static unsigned int test_random( void )
+{
+	test_random_state ^= test_random_state << 13;
+	test_random_state ^= test_random_state >> 17;
+	test_random_state ^= test_random_state << 5;
+	return test_random_state;
+}
+
+/*	a random integer from low to high, inclusive	*/
+static int test_random_range( int low, int high )
+{
+	return low + (int)(test_random() % (unsigned int)(high - low + 1));
+}
+
+/*	fills an image with noise, a gradient or flat patches,
+	so that both typical and extreme inputs are covered	*/
+static void test_fill_image( unsigned char *data, int size )
+{
+	int i, kind = test_random_range( 0, 2 );
+	for( i = 0; i < size; ++i )
+	{
+		if( kind == 0 )
+		{
+			data[i] = (unsigned char)test_random();
+		} else if( kind == 1 )
+		{
+			data[i] = (unsigned char)(i * 7 / 3 + (test_random() & 3));
+		} else
+		{
+			data[i] = (unsigned char)(((i / 37) & 1) ? 255 : 0);
+		}
+	}
+}
+
+static unsigned char *test_malloc( int size )
+{
+	unsigned char *data = (unsigned char*)malloc( size > 0 ? size : 1 );
+	if( data == NULL )
+	{
+		printf( "out of memory\n" );
+		exit( 1 );
+	}
+	return data;
+}
+
+/*	returns the index of the first differing byte, or -1	*/
+static int test_compare( const unsigned char *a, const unsigned char *b, int size )
+{
+	int i;
+	for( i = 0; i < size; ++i )
+	{
+		if( a[i] != b[i] )
+		{
+			return i;
+		}
+	}
+	return -1;
+}
+
+#endif /* HEADER_SOIL_TEST_COMMON	*/
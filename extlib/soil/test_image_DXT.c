@@ -0,0 +1,280 @@
+/*
+	Compares the DXT1 and DXT5 encoders with the original scalar,
+	single threaded encoder in original/image_DXT.c.  The output
+	must match byte for byte.  Then both encoders are timed on a
+	2048x2048 image, and the error of the decoded result is shown.
+
+	Usage: test_image_DXT [number of random cases]
+
+	public domain
+*/
+
+#include "test_common.h"
+#include "image_DXT.h"
+#include <math.h>
+
+/*	the original functions, renamed so that they can be linked with SOIL	*/
+unsigned char* original_convert_image_to_DXT1( const unsigned char *const uncompressed,
+	int width, int height, int channels, int *out_size );
+unsigned char* original_convert_image_to_DXT5( const unsigned char *const uncompressed,
+	int width, int height, int channels, int *out_size );
+#define save_image_as_DDS original_save_image_as_DDS
+#define convert_image_to_DXT1 original_convert_image_to_DXT1
+#define convert_image_to_DXT5 original_convert_image_to_DXT5
+#define compress_DDS_color_block original_compress_DDS_color_block
+#define compress_DDS_alpha_block original_compress_DDS_alpha_block
+#define convert_bit_range original_convert_bit_range
+#define rgb_to_565 original_rgb_to_565
+#define rgb_888_from_565 original_rgb_888_from_565
+#define compute_color_line_STDEV original_compute_color_line_STDEV
+#define LSE_master_colors_max_min original_LSE_master_colors_max_min
+#include "original/image_DXT.c"
+#undef save_image_as_DDS
+#undef convert_image_to_DXT1
+#undef convert_image_to_DXT5
+#undef compress_DDS_color_block
+#undef compress_DDS_alpha_block
+#undef convert_bit_range
+#undef rgb_to_565
+#undef rgb_888_from_565
+#undef compute_color_line_STDEV
+#undef LSE_master_colors_max_min
+
+typedef unsigned char* (*DXT_function)( const unsigned char *const, int, int, int, int * );
+
+/*	called through pointers, so that the original functions, which are in this
+	file, are not specialized for the constant arguments of the benchmark	*/
+static volatile DXT_function original_DXT1 = original_convert_image_to_DXT1;
+static volatile DXT_function original_DXT5 = original_convert_image_to_DXT5;
+static volatile DXT_function optimized_DXT1 = convert_image_to_DXT1;
+static volatile DXT_function optimized_DXT5 = convert_image_to_DXT5;
+
+/*	an image pixel as RGBA, the way the encoders read it	*/
+static void get_source_pixel( const unsigned char *data, int channels, int index,
+	int rgba[4] )
+{
+	const unsigned char *pixel = data + index * channels;
+	if( channels < 3 )
+	{
+		rgba[0] = rgba[1] = rgba[2] = pixel[0];
+	} else
+	{
+		rgba[0] = pixel[0];
+		rgba[1] = pixel[1];
+		rgba[2] = pixel[2];
+	}
+	rgba[3] = ((channels & 1) == 0) ? pixel[channels - 1] : 255;
+}
+
+/*	decodes the 16 colors of a DXT1 color block as RGB	*/
+static void decode_color_block( const unsigned char *block, int colors[16][3] )
+{
+	int palette[4][3];
+	int c0 = block[0] | (block[1] << 8);
+	int c1 = block[2] | (block[3] << 8);
+	int i;
+	for( i = 0; i < 2; ++i )
+	{
+		int c = (i == 0) ? c0 : c1;
+		palette[i][0] = ((c >> 11) & 31) * 255 / 31;
+		palette[i][1] = ((c >> 5) & 63) * 255 / 63;
+		palette[i][2] = (c & 31) * 255 / 31;
+	}
+	for( i = 0; i < 3; ++i )
+	{
+		if( c0 > c1 )
+		{
+			palette[2][i] = (2 * palette[0][i] + palette[1][i]) / 3;
+			palette[3][i] = (palette[0][i] + 2 * palette[1][i]) / 3;
+		} else
+		{
+			palette[2][i] = (palette[0][i] + palette[1][i]) / 2;
+			palette[3][i] = 0;
+		}
+	}
+	for( i = 0; i < 16; ++i )
+	{
+		int index = (block[4 + i / 4] >> ((i & 3) * 2)) & 3;
+		colors[i][0] = palette[index][0];
+		colors[i][1] = palette[index][1];
+		colors[i][2] = palette[index][2];
+	}
+}
+
+/*	decodes the 16 alphas of a DXT5 alpha block	*/
+static void decode_alpha_block( const unsigned char *block, int alphas[16] )
+{
+	int palette[8];
+	int i;
+	palette[0] = block[0];
+	palette[1] = block[1];
+	if( palette[0] > palette[1] )
+	{
+		for( i = 1; i < 7; ++i )
+		{
+			palette[i + 1] = ((7 - i) * palette[0] + i * palette[1]) / 7;
+		}
+	} else
+	{
+		for( i = 1; i < 5; ++i )
+		{
+			palette[i + 1] = ((5 - i) * palette[0] + i * palette[1]) / 5;
+		}
+		palette[6] = 0;
+		palette[7] = 255;
+	}
+	for( i = 0; i < 16; ++i )
+	{
+		/*	eight 3 bit indices in each group of 3 bytes	*/
+		const unsigned char *group = block + 2 + (i / 8) * 3;
+		int bits = group[0] | (group[1] << 8) | (group[2] << 16);
+		alphas[i] = palette[(bits >> ((i & 7) * 3)) & 7];
+	}
+}
+
+/*	the root mean square error of the decoded image, over R, G, B and,
+	for DXT5, A	*/
+static double get_RMSE( const unsigned char *data, int width, int height, int channels,
+	const unsigned char *compressed, int is_DXT5 )
+{
+	int blocks_wide = (width + 3) / 4;
+	int block_size = is_DXT5 ? 16 : 8;
+	int x, y, c;
+	double error = 0.0;
+	for( y = 0; y < height; ++y )
+	{
+		for( x = 0; x < width; ++x )
+		{
+			const unsigned char *block = compressed +
+				((y / 4) * blocks_wide + (x / 4)) * block_size;
+			int colors[16][3], alphas[16], rgba[4];
+			int i = (y & 3) * 4 + (x & 3);
+			get_source_pixel( data, channels, y * width + x, rgba );
+			decode_color_block( block + (is_DXT5 ? 8 : 0), colors );
+			for( c = 0; c < 3; ++c )
+			{
+				error += (double)(colors[i][c] - rgba[c]) * (colors[i][c] - rgba[c]);
+			}
+			if( is_DXT5 )
+			{
+				decode_alpha_block( block, alphas );
+				error += (double)(alphas[i] - rgba[3]) * (alphas[i] - rgba[3]);
+			}
+		}
+	}
+	return sqrt( error / ((double)width * height * (is_DXT5 ? 4 : 3)) );
+}
+
+static int test_DXT( int num_cases )
+{
+	int i, num_failed = 0;
+	for( i = 0; i < num_cases; ++i )
+	{
+		/*	some images are large enough to be split across threads	*/
+		int max_size = (i % 50 == 0) ? 1024 : 70;
+		int width = test_random_range( 1, max_size );
+		int height = test_random_range( 1, max_size );
+		int channels = test_random_range( 1, 4 );
+		int is_DXT5 = test_random_range( 0, 1 );
+		int size = width * height * channels;
+		int expected_size, actual_size, difference;
+		unsigned char *data = test_malloc( size );
+		unsigned char *expected, *actual;
+		test_fill_image( data, size );
+		if( is_DXT5 )
+		{
+			expected = original_convert_image_to_DXT5( data, width, height, channels, &expected_size );
+			actual = convert_image_to_DXT5( data, width, height, channels, &actual_size );
+		} else
+		{
+			expected = original_convert_image_to_DXT1( data, width, height, channels, &expected_size );
+			actual = convert_image_to_DXT1( data, width, height, channels, &actual_size );
+		}
+		if( expected_size != actual_size )
+		{
+			printf( "DXT%d %dx%dx%d is %d bytes instead of %d\n", is_DXT5 ? 5 : 1,
+				width, height, channels, actual_size, expected_size );
+			++num_failed;
+		} else
+		{
+			difference = test_compare( expected, actual, expected_size );
+			if( difference >= 0 )
+			{
+				printf( "DXT%d %dx%dx%d differs at byte %d\n", is_DXT5 ? 5 : 1,
+					width, height, channels, difference );
+				++num_failed;
+			}
+		}
+		free( data );
+		free( expected );
+		free( actual );
+	}
+	return num_failed;
+}
+
+/*	times the best of several runs and shows the throughput and error	*/
+static void benchmark_DXT( const char *name, DXT_function convert, const unsigned char *data,
+	int size, int channels, int is_DXT5 )
+{
+	int run, compressed_size;
+	double best = 1e9, RMSE = 0.0;
+	for( run = 0; run < 5; ++run )
+	{
+		double start = test_seconds();
+		unsigned char *compressed = convert( data, size, size, channels, &compressed_size );
+		start = (test_seconds() - start) * 1000.0;
+		if( start < best )
+		{
+			best = start;
+		}
+		if( run == 0 )
+		{
+			RMSE = get_RMSE( data, size, size, channels, compressed, is_DXT5 );
+		}
+		free( compressed );
+	}
+	printf( "%s: %.2f ms, %.1f Mpixels/s, RMSE %.4f\n", name, best,
+		(double)size * size / (best * 1000.0), RMSE );
+}
+
+static void benchmark( void )
+{
+	const int size = 2048;
+	unsigned char *data = test_malloc( size * size * 4 );
+	int x, y;
+
+	/*	smooth gradients with a little noise, more like a real texture than noise	*/
+	for( y = 0; y < size; ++y )
+	{
+		for( x = 0; x < size; ++x )
+		{
+			unsigned char *pixel = data + (y * size + x) * 4;
+			pixel[0] = (unsigned char)(x / 8 + (test_random() & 7));
+			pixel[1] = (unsigned char)(y / 8 + (test_random() & 7));
+			pixel[2] = (unsigned char)((x + y) / 16 + (test_random() & 7));
+			pixel[3] = (unsigned char)(((x / 64 + y / 64) & 1) ? 255 : x / 8);
+		}
+	}
+
+	printf( "%dx%d RGBA\n", size, size );
+	benchmark_DXT( "  DXT1 original ", original_DXT1, data, size, 4, 0 );
+	benchmark_DXT( "  DXT1 optimized", optimized_DXT1, data, size, 4, 0 );
+	benchmark_DXT( "  DXT5 original ", original_DXT5, data, size, 4, 1 );
+	benchmark_DXT( "  DXT5 optimized", optimized_DXT5, data, size, 4, 1 );
+	free( data );
+}
+
+int main( int argc, char *argv[] )
+{
+	int num_cases = (argc > 1) ? atoi( argv[1] ) : 600;
+
+	if( test_DXT( num_cases ) > 0 )
+	{
+		printf( "Some images differ from the original encoder\n" );
+		return 1;
+	}
+	printf( "All images match the original encoder\n" );
+
+	benchmark();
+	return 0;
+}
@@ -0,0 +1,327 @@
+/*
+	Compares the resampling, color space conversions and premultiplied
+	alpha with the original scalar versions in original/image_helper.c
+	and SOIL.c, which they must match byte for byte, then times both
+	versions on large images.
+
+	Usage: test_image_helper [number of random cases per function]
+
+	MIT license
+*/
+
+#include "test_common.h"
+#include "image_helper.h"
+
+/*	the original functions, renamed so that they can be linked with SOIL	*/
+#define up_scale_image original_up_scale_image
+#define mipmap_image original_mipmap_image
+#define scale_image_RGB_to_NTSC_safe original_scale_image_RGB_to_NTSC_safe
+#define clamp_byte original_clamp_byte
+#define convert_RGB_to_YCoCg original_convert_RGB_to_YCoCg
+#define convert_YCoCg_to_RGB original_convert_YCoCg_to_RGB
+#define find_max_RGBE original_find_max_RGBE
+#define RGBE_to_RGBdivA original_RGBE_to_RGBdivA
+#define RGBE_to_RGBdivA2 original_RGBE_to_RGBdivA2
+#include "original/image_helper.c"
+#undef up_scale_image
+#undef mipmap_image
+#undef scale_image_RGB_to_NTSC_safe
+#undef clamp_byte
+#undef convert_RGB_to_YCoCg
+#undef convert_YCoCg_to_RGB
+#undef find_max_RGBE
+#undef RGBE_to_RGBdivA
+#undef RGBE_to_RGBdivA2
+
+static int test_up_scale_image( int num_cases )
+{
+	int i, num_failed = 0;
+	for( i = 0; i < num_cases; ++i )
+	{
+		/*	favor RGBA, which is vectorized	*/
+		int channels = test_random_range( 1, 8 );
+		int width = test_random_range( 2, 40 );
+		int height = test_random_range( 2, 40 );
+		int resampled_width = test_random_range( 2, 90 );
+		int resampled_height = test_random_range( 2, 90 );
+		int size, resampled_size, difference;
+		unsigned char *orig, *expected, *actual;
+		if( channels > 4 )
+		{
+			channels = 4;
+		}
+		size = width * height * channels;
+		resampled_size = resampled_width * resampled_height * channels;
+		orig = test_malloc( size );
+		expected = test_malloc( resampled_size );
+		actual = test_malloc( resampled_size );
+		test_fill_image( orig, size );
+		original_up_scale_image( orig, width, height, channels, expected, resampled_width, resampled_height );
+		up_scale_image( orig, width, height, channels, actual, resampled_width, resampled_height );
+		difference = test_compare( expected, actual, resampled_size );
+		if( difference >= 0 )
+		{
+			printf( "up_scale_image %dx%dx%d to %dx%d differs at byte %d\n",
+				width, height, channels, resampled_width, resampled_height, difference );
+			++num_failed;
+		}
+		free( orig );
+		free( expected );
+		free( actual );
+	}
+	return num_failed;
+}
+
+static int test_mipmap_image( int num_cases )
+{
+	int i, num_failed = 0;
+	for( i = 0; i < num_cases; ++i )
+	{
+		int channels = test_random_range( 1, 4 );
+		int width = test_random_range( 1, 70 );
+		int height = test_random_range( 1, 70 );
+		int block_size_x = test_random_range( 1, 4 );
+		int block_size_y = test_random_range( 1, 4 );
+		int mip_width = width / block_size_x;
+		int mip_height = height / block_size_y;
+		int size, mip_size, difference;
+		unsigned char *orig, *expected, *actual;
+		if( mip_width < 1 )
+		{
+			mip_width = 1;
+		}
+		if( mip_height < 1 )
+		{
+			mip_height = 1;
+		}
+		size = width * height * channels;
+		mip_size = mip_width * mip_height * channels;
+		orig = test_malloc( size );
+		expected = test_malloc( mip_size );
+		actual = test_malloc( mip_size );
+		test_fill_image( orig, size );
+		original_mipmap_image( orig, width, height, channels, expected, block_size_x, block_size_y );
+		mipmap_image( orig, width, height, channels, actual, block_size_x, block_size_y );
+		difference = test_compare( expected, actual, mip_size );
+		if( difference >= 0 )
+		{
+			printf( "mipmap_image %dx%dx%d by %dx%d differs at byte %d\n",
+				width, height, channels, block_size_x, block_size_y, difference );
+			++num_failed;
+		}
+		free( orig );
+		free( expected );
+		free( actual );
+	}
+	return num_failed;
+}
+
+typedef int (*resample_function)( const unsigned char *const, int, int, int,
+	unsigned char *, int, int );
+
+/*	called through pointers, so that the original functions, which are in this
+	file, are not specialized for the constant arguments of the benchmark	*/
+static volatile resample_function original_mipmap = original_mipmap_image;
+static volatile resample_function optimized_mipmap = mipmap_image;
+static volatile resample_function original_up_scale = original_up_scale_image;
+static volatile resample_function optimized_up_scale = up_scale_image;
+
+/*	the color space conversions, which work in place	*/
+typedef int (*convert_function)( unsigned char *, int, int, int );
+
+/*	the premultiply loop that SOIL.c had before multiply_alpha	*/
+static int original_multiply_alpha( unsigned char *img, int width, int height, int channels )
+{
+	int i;
+	switch( channels )
+	{
+	case 2:
+		for( i = 0; i < 2*width*height; i += 2 )
+		{
+			img[i] = (img[i] * img[i+1] + 128) >> 8;
+		}
+		break;
+	case 4:
+		for( i = 0; i < 4*width*height; i += 4 )
+		{
+			img[i+0] = (img[i+0] * img[i+3] + 128) >> 8;
+			img[i+1] = (img[i+1] * img[i+3] + 128) >> 8;
+			img[i+2] = (img[i+2] * img[i+3] + 128) >> 8;
+		}
+		break;
+	default:
+		/*	no other number of channels contains alpha data	*/
+		break;
+	}
+	return 1;
+}
+
+/*	premultiplies every color by every alpha, as gray and alpha and as RGBA	*/
+static int test_multiply_alpha_pairs( void )
+{
+	int i, channels, num_failed = 0;
+	unsigned char *expected = test_malloc( 65536 * 4 );
+	unsigned char *actual = test_malloc( 65536 * 4 );
+	for( channels = 2; channels <= 4; channels += 2 )
+	{
+		int difference;
+		for( i = 0; i < 65536; ++i )
+		{
+			unsigned char *pixel = expected + i * channels;
+			pixel[0] = pixel[1] = pixel[2] = (unsigned char)(i >> 8);
+			pixel[channels - 1] = (unsigned char)i;
+		}
+		memcpy( actual, expected, 65536 * channels );
+		original_multiply_alpha( expected, 256, 256, channels );
+		multiply_alpha( actual, 256, 256, channels );
+		difference = test_compare( expected, actual, 65536 * channels );
+		if( difference >= 0 )
+		{
+			printf( "multiply_alpha with %d channels differs for color %d and alpha %d\n",
+				channels, difference / channels >> 8, difference / channels & 255 );
+			++num_failed;
+		}
+	}
+	free( expected );
+	free( actual );
+	return num_failed;
+}
+
+/*	compares two conversions on random images, passing channels from 1 to 4
+	as the last argument, or for RGBE images, which always have 4 channels,
+	rescale_to_max as 0 or 1	*/
+static int test_conversion( const char *name, convert_function original,
+	convert_function optimized, int is_RGBE, int num_cases )
+{
+	int i, num_failed = 0;
+	for( i = 0; i < num_cases; ++i )
+	{
+		int width = test_random_range( 1, 70 );
+		int height = test_random_range( 1, 70 );
+		int parameter = is_RGBE ? test_random_range( 0, 1 ) : test_random_range( 1, 4 );
+		int size = width * height * (is_RGBE ? 4 : parameter);
+		int difference;
+		unsigned char *expected = test_malloc( size );
+		unsigned char *actual = test_malloc( size );
+		test_fill_image( expected, size );
+		memcpy( actual, expected, size );
+		original( expected, width, height, parameter );
+		optimized( actual, width, height, parameter );
+		difference = test_compare( expected, actual, size );
+		if( difference >= 0 )
+		{
+			printf( "%s %dx%d with %s %d differs at byte %d\n", name, width, height,
+				is_RGBE ? "rescale_to_max" : "channels", parameter, difference );
+			++num_failed;
+		}
+		free( expected );
+		free( actual );
+	}
+	return num_failed;
+}
+
+/*	the best of several conversions of the same image, in milliseconds	*/
+static double time_conversion( convert_function convert, const unsigned char *image,
+	unsigned char *work, int width, int height, int parameter, int channels )
+{
+	int run;
+	double result = 1e9;
+	for( run = 0; run < 5; ++run )
+	{
+		double start;
+		memcpy( work, image, width * height * channels );
+		start = test_seconds();
+		convert( work, width, height, parameter );
+		start = (test_seconds() - start) * 1000.0;
+		if( start < result )
+		{
+			result = start;
+		}
+	}
+	return result;
+}
+
+/*	the best of several runs, in milliseconds	*/
+#define TIME_BEST( result, statement ) \
+	{ \
+		int run; \
+		result = 1e9; \
+		for( run = 0; run < 5; ++run ) \
+		{ \
+			double start = test_seconds(); \
+			statement; \
+			start = (test_seconds() - start) * 1000.0; \
+			if( start < result ) \
+			{ \
+				result = start; \
+			} \
+		} \
+	}
+
+static void benchmark( void )
+{
+	const int size = 2048;
+	const int upscale_from = 1500;
+	unsigned char *orig = test_malloc( size * size * 4 );
+	unsigned char *resampled = test_malloc( size * size * 4 );
+	double original_time, time;
+
+	test_fill_image( orig, size * size * 4 );
+
+	TIME_BEST( original_time, original_mipmap( orig, size, size, 4, resampled, 2, 2 ) );
+	TIME_BEST( time, optimized_mipmap( orig, size, size, 4, resampled, 2, 2 ) );
+	printf( "mipmap_image %dx%d RGBA: %.2f ms -> %.2f ms\n", size, size, original_time, time );
+
+	TIME_BEST( original_time, original_up_scale( orig, upscale_from, upscale_from, 4, resampled, size, size ) );
+	TIME_BEST( time, optimized_up_scale( orig, upscale_from, upscale_from, 4, resampled, size, size ) );
+	printf( "up_scale_image %dx%d to %dx%d RGBA: %.2f ms -> %.2f ms\n",
+		upscale_from, upscale_from, size, size, original_time, time );
+
+	printf( "convert_RGB_to_YCoCg %dx%d RGBA: %.2f ms -> %.2f ms\n", size, size,
+		time_conversion( original_convert_RGB_to_YCoCg, orig, resampled, size, size, 4, 4 ),
+		time_conversion( convert_RGB_to_YCoCg, orig, resampled, size, size, 4, 4 ) );
+	printf( "convert_YCoCg_to_RGB %dx%d RGBA: %.2f ms -> %.2f ms\n", size, size,
+		time_conversion( original_convert_YCoCg_to_RGB, orig, resampled, size, size, 4, 4 ),
+		time_conversion( convert_YCoCg_to_RGB, orig, resampled, size, size, 4, 4 ) );
+	printf( "RGBE_to_RGBdivA %dx%d: %.2f ms -> %.2f ms\n", size, size,
+		time_conversion( original_RGBE_to_RGBdivA, orig, resampled, size, size, 1, 4 ),
+		time_conversion( RGBE_to_RGBdivA, orig, resampled, size, size, 1, 4 ) );
+	printf( "RGBE_to_RGBdivA2 %dx%d: %.2f ms -> %.2f ms\n", size, size,
+		time_conversion( original_RGBE_to_RGBdivA2, orig, resampled, size, size, 1, 4 ),
+		time_conversion( RGBE_to_RGBdivA2, orig, resampled, size, size, 1, 4 ) );
+	printf( "multiply_alpha %dx%d RGBA: %.2f ms -> %.2f ms\n", size, size,
+		time_conversion( original_multiply_alpha, orig, resampled, size, size, 4, 4 ),
+		time_conversion( multiply_alpha, orig, resampled, size, size, 4, 4 ) );
+
+	free( orig );
+	free( resampled );
+}
+
+int main( int argc, char *argv[] )
+{
+	int num_cases = (argc > 1) ? atoi( argv[1] ) : 3000;
+	int num_failed = 0;
+
+	num_failed += test_up_scale_image( num_cases );
+	num_failed += test_mipmap_image( num_cases );
+	num_failed += test_conversion( "convert_RGB_to_YCoCg",
+		original_convert_RGB_to_YCoCg, convert_RGB_to_YCoCg, 0, num_cases );
+	num_failed += test_conversion( "convert_YCoCg_to_RGB",
+		original_convert_YCoCg_to_RGB, convert_YCoCg_to_RGB, 0, num_cases );
+	num_failed += test_conversion( "RGBE_to_RGBdivA",
+		original_RGBE_to_RGBdivA, RGBE_to_RGBdivA, 1, num_cases );
+	num_failed += test_conversion( "RGBE_to_RGBdivA2",
+		original_RGBE_to_RGBdivA2, RGBE_to_RGBdivA2, 1, num_cases );
+	num_failed += test_conversion( "multiply_alpha",
+		original_multiply_alpha, multiply_alpha, 0, num_cases );
+	num_failed += test_multiply_alpha_pairs();
+	if( num_failed > 0 )
+	{
+		printf( "%d cases differ from the original functions\n", num_failed );
+		return 1;
+	}
+	printf( "All cases match the original functions\n" );
+
+	benchmark();
+	return 0;
+}
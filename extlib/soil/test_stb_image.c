@@ -0,0 +1,737 @@
+/*
+	Checks the inflate and PNG loading of stb_image_aug against zlib:
+	streams that zlib compressed with every level, strategy and window
+	size must inflate to the original data, and generated PNGs of every
+	color type and filter must load to the pixels they were made from,
+	with any number of channels requested.  Truncated and corrupted
+	inputs must fail cleanly, so also run this under ASan and UBSan.
+	Then inflate is timed against zlib's, and PNG loading per filter.
+
+	Usage: test_stb_image [number of random cases]
+
+	public domain
+*/
+
+#include "test_common.h"
+#include "stb_image_aug.h"
+#include <zlib.h>
+
+static const char *const words[] =
+{
+	"the", "image", "texture", "of", "and", "pixel", "static", "int",
+	"return", "{", "}", "(", ");", "\n", "\t", "width"
+};
+
+/*	fills the data with an image like pattern or with text	*/
+static void fill_data( unsigned char *data, int size )
+{
+	int i = 0;
+	if( test_random_range( 0, 3 ) > 0 )
+	{
+		test_fill_image( data, size );
+		return;
+	}
+	while( i < size )
+	{
+		const char *word = words[test_random() % (sizeof( words ) / sizeof( words[0] ))];
+		while( (*word != 0) && (i < size) )
+		{
+			data[i++] = *word++;
+		}
+		if( i < size )
+		{
+			data[i++] = ' ';
+		}
+	}
+}
+
+static const int strategies[] =
+{
+	Z_DEFAULT_STRATEGY, Z_FILTERED, Z_HUFFMAN_ONLY, Z_RLE, Z_FIXED
+};
+
+/*	compresses the data with zlib, flushing every flush_size bytes if that
+	is not 0, which ends the current block.  A negative window_bits makes
+	a raw deflate stream without the zlib header.	*/
+static unsigned char *compress_data( const unsigned char *data, int size, int level,
+	int window_bits, int strategy, int flush_size, int *compressed_size )
+{
+	z_stream stream;
+	int capacity, position = 0, flush_count = 0;
+	unsigned char *compressed;
+	memset( &stream, 0, sizeof( stream ) );
+	if( deflateInit2( &stream, level, Z_DEFLATED, window_bits, 8, strategy ) != Z_OK )
+	{
+		printf( "deflateInit2 failed\n" );
+		exit( 1 );
+	}
+	/*	each flush adds at most a few bytes	*/
+	capacity = (int)deflateBound( &stream, size ) + 64;
+	if( flush_size > 0 )
+	{
+		capacity += (size / flush_size + 1) * 16;
+	}
+	compressed = test_malloc( capacity );
+	stream.next_out = compressed;
+	stream.avail_out = capacity;
+	do
+	{
+		int chunk = size - position;
+		int flush = Z_FINISH;
+		int expected = Z_STREAM_END;
+		if( (flush_size > 0) && (chunk > flush_size) )
+		{
+			chunk = flush_size;
+			flush = ((++flush_count & 1) != 0) ? Z_SYNC_FLUSH : Z_FULL_FLUSH;
+			expected = Z_OK;
+		}
+		stream.next_in = (Bytef*)(data + position);
+		stream.avail_in = chunk;
+		position += chunk;
+		if( deflate( &stream, flush ) != expected )
+		{
+			printf( "deflate failed\n" );
+			exit( 1 );
+		}
+	} while( position < size );
+	*compressed_size = capacity - (int)stream.avail_out;
+	deflateEnd( &stream );
+	return compressed;
+}
+
+static char *inflate_malloc( const unsigned char *compressed, int compressed_size,
+	int has_header, int *size )
+{
+	return has_header ?
+		stbi_zlib_decode_malloc( (const char*)compressed, compressed_size, size ) :
+		stbi_zlib_decode_noheader_malloc( (const char*)compressed, compressed_size, size );
+}
+
+static int inflate_buffer( char *buffer, int buffer_size,
+	const unsigned char *compressed, int compressed_size, int has_header )
+{
+	return has_header ?
+		stbi_zlib_decode_buffer( buffer, buffer_size, (const char*)compressed, compressed_size ) :
+		stbi_zlib_decode_noheader_buffer( buffer, buffer_size, (const char*)compressed, compressed_size );
+}
+
+/*	whether the inflated data, which may be NULL, is the original data	*/
+static int is_inflated( const unsigned char *data, int size, const char *inflated, int inflated_size )
+{
+	return (inflated != NULL) && (inflated_size == size) &&
+		(test_compare( data, (const unsigned char*)inflated, size ) < 0);
+}
+
+/*	inflates the stream to a new buffer, to a buffer of the exact size and to
+	one that is a byte too small, which must fail.  Returns 0 if any is wrong.	*/
+static int check_inflate( const unsigned char *data, int size,
+	const unsigned char *compressed, int compressed_size, int has_header )
+{
+	int inflated_size = -1, is_correct = 1;
+	char *buffer = (char*)test_malloc( size );
+	char *inflated = inflate_malloc( compressed, compressed_size, has_header, &inflated_size );
+	if( !is_inflated( data, size, inflated, inflated_size ) )
+	{
+		printf( "  inflating to a new buffer gave %d bytes\n", inflated ? inflated_size : -1 );
+		is_correct = 0;
+	}
+	free( inflated );
+	inflated_size = inflate_buffer( buffer, size, compressed, compressed_size, has_header );
+	if( !is_inflated( data, size, buffer, inflated_size ) )
+	{
+		printf( "  inflating to a buffer of the exact size gave %d bytes\n", inflated_size );
+		is_correct = 0;
+	}
+	if( size > 0 )
+	{
+		inflated_size = inflate_buffer( buffer, size - 1, compressed, compressed_size, has_header );
+		if( inflated_size != -1 )
+		{
+			printf( "  inflating to a buffer that is too small gave %d bytes\n", inflated_size );
+			is_correct = 0;
+		}
+	}
+	free( buffer );
+	return is_correct;
+}
+
+/*	a copy of the first size bytes, in a buffer of exactly that size so that
+	ASan catches any read past the end	*/
+static unsigned char *copy_prefix( const unsigned char *data, int size )
+{
+	unsigned char *copy = test_malloc( size );
+	memcpy( copy, data, size );
+	return copy;
+}
+
+/*	a truncated stream must fail, unless only the checksum at its end was cut,
+	which stb_image does not read.  Returns 0 if it inflated to anything else.	*/
+static int check_truncated_inflate( const unsigned char *data, int size,
+	const unsigned char *compressed, int compressed_size, int has_header )
+{
+	int cut = test_random_range( 0, compressed_size - 1 );
+	int inflated_size = -1, is_correct;
+	unsigned char *truncated = copy_prefix( compressed, cut );
+	char *inflated = inflate_malloc( truncated, cut, has_header, &inflated_size );
+	is_correct = (inflated == NULL) || is_inflated( data, size, inflated, inflated_size );
+	if( !is_correct )
+	{
+		printf( "  the stream cut to %d of %d bytes inflated to %d bytes\n",
+			cut, compressed_size, inflated_size );
+	}
+	free( inflated );
+	free( truncated );
+	return is_correct;
+}
+
+/*	a corrupted stream may inflate to anything, but must not crash	*/
+static void check_corrupt_inflate( const unsigned char *compressed, int compressed_size,
+	int has_header )
+{
+	int i, inflated_size;
+	unsigned char *corrupt = copy_prefix( compressed, compressed_size );
+	for( i = test_random_range( 1, 3 ); i > 0; --i )
+	{
+		corrupt[test_random() % compressed_size] ^= (unsigned char)(1 << (test_random() & 7));
+	}
+	free( inflate_malloc( corrupt, compressed_size, has_header, &inflated_size ) );
+	free( corrupt );
+}
+
+static int test_inflate( int num_cases )
+{
+	int i, num_failed = 0;
+	for( i = 0; i < num_cases; ++i )
+	{
+		int size = test_random_range( 0, (i % 20 == 0) ? 300000 : 20000 );
+		int level = test_random_range( -1, 9 );
+		int window_bits = test_random_range( 9, 15 );
+		int strategy = strategies[test_random() % (sizeof( strategies ) / sizeof( strategies[0] ))];
+		int flush_size = (test_random_range( 0, 3 ) == 0) ? test_random_range( 1, size + 1 ) : 0;
+		int has_header = (test_random_range( 0, 3 ) > 0);
+		int compressed_size, is_correct;
+		unsigned char *data = test_malloc( size );
+		unsigned char *compressed;
+		fill_data( data, size );
+		compressed = compress_data( data, size, level, has_header ? window_bits : -window_bits,
+			strategy, flush_size, &compressed_size );
+		is_correct = check_inflate( data, size, compressed, compressed_size, has_header );
+		if( (i & 3) == 0 )
+		{
+			is_correct &= check_truncated_inflate( data, size, compressed, compressed_size, has_header );
+			check_corrupt_inflate( compressed, compressed_size, has_header );
+		}
+		if( !is_correct )
+		{
+			printf( "inflate failed on %d bytes compressed to %d, level %d, window bits %d, "
+				"strategy %d, flushed every %d bytes, %s\n", size, compressed_size, level,
+				window_bits, strategy, flush_size, has_header ? "zlib header" : "no header" );
+			++num_failed;
+		}
+		free( data );
+		free( compressed );
+	}
+	return num_failed;
+}
+
+/*	an image to be written as a PNG	*/
+typedef struct
+{
+	int width, height;
+	int color_type;	/*	0 gray, 2 RGB, 3 palette, 4 gray and alpha, 6 RGBA	*/
+	int channels;	/*	bytes per pixel in the file	*/
+	unsigned char *pixels;	/*	palette indices for color type 3	*/
+	unsigned char palette[256 * 3];
+	int palette_size;
+	/*	the alphas of the first palette entries, or a transparent gray or RGB
+		color, which is 1 entry	*/
+	unsigned char transparency[256];
+	int transparency_size;
+	int filter;	/*	the filter type of every row, or -1 for random ones	*/
+}
+png_image;
+
+typedef struct
+{
+	unsigned char *data;
+	int size, capacity;
+}
+png_buffer;
+
+static void append( png_buffer *buffer, const void *data, int size )
+{
+	if( buffer->size + size > buffer->capacity )
+	{
+		buffer->capacity = (buffer->size + size) * 2;
+		buffer->data = (unsigned char*)realloc( buffer->data, buffer->capacity );
+		if( buffer->data == NULL )
+		{
+			printf( "out of memory\n" );
+			exit( 1 );
+		}
+	}
+	if( size > 0 )
+	{
+		memcpy( buffer->data + buffer->size, data, size );
+		buffer->size += size;
+	}
+}
+
+static void append_32( png_buffer *buffer, unsigned int value )
+{
+	unsigned char bytes[4];
+	bytes[0] = (unsigned char)(value >> 24);
+	bytes[1] = (unsigned char)(value >> 16);
+	bytes[2] = (unsigned char)(value >> 8);
+	bytes[3] = (unsigned char)value;
+	append( buffer, bytes, 4 );
+}
+
+static void append_chunk( png_buffer *buffer, const char *type, const unsigned char *data, int size )
+{
+	unsigned long crc = crc32( 0, (const Bytef*)type, 4 );
+	if( size > 0 )
+	{
+		crc = crc32( crc, data, size );
+	}
+	append_32( buffer, size );
+	append( buffer, type, 4 );
+	append( buffer, data, size );
+	append_32( buffer, (unsigned int)crc );
+}
+
+static int paeth( int a, int b, int c )
+{
+	int p = a + b - c;
+	int pa = abs( p - a ), pb = abs( p - b ), pc = abs( p - c );
+	if( (pa <= pb) && (pa <= pc) )
+	{
+		return a;
+	} else if( pb <= pc )
+	{
+		return b;
+	}
+	return c;
+}
+
+/*	filters the rows, compresses them at a random level and splits them across
+	several IDAT chunks	*/
+static unsigned char *encode_png( const png_image *image, int *png_size )
+{
+	static const unsigned char signature[8] = { 137, 80, 78, 71, 13, 10, 26, 10 };
+	int stride = image->width * image->channels;
+	int bpp = image->channels;
+	int raw_size = (stride + 1) * image->height;
+	int x, y, compressed_size, position;
+	unsigned char header[13];
+	unsigned char *raw = test_malloc( raw_size );
+	unsigned char *compressed;
+	png_buffer buffer = { NULL, 0, 0 };
+
+	for( y = 0; y < image->height; ++y )
+	{
+		const unsigned char *row = image->pixels + y * stride;
+		const unsigned char *prior = row - stride;
+		unsigned char *filtered = raw + y * (stride + 1);
+		int filter = (image->filter >= 0) ? image->filter : test_random_range( 0, 4 );
+		*filtered++ = (unsigned char)filter;
+		for( x = 0; x < stride; ++x )
+		{
+			int a = (x >= bpp) ? row[x - bpp] : 0;
+			int b = (y > 0) ? prior[x] : 0;
+			int c = ((x >= bpp) && (y > 0)) ? prior[x - bpp] : 0;
+			int predicted = 0;
+			switch( filter )
+			{
+			case 1: predicted = a; break;
+			case 2: predicted = b; break;
+			case 3: predicted = (a + b) >> 1; break;
+			case 4: predicted = paeth( a, b, c ); break;
+			}
+			filtered[x] = (unsigned char)(row[x] - predicted);
+		}
+	}
+	compressed = compress_data( raw, raw_size, test_random_range( 0, 9 ), 15,
+		Z_DEFAULT_STRATEGY, 0, &compressed_size );
+
+	append( &buffer, signature, 8 );
+	header[0] = (unsigned char)(image->width >> 24);
+	header[1] = (unsigned char)(image->width >> 16);
+	header[2] = (unsigned char)(image->width >> 8);
+	header[3] = (unsigned char)image->width;
+	header[4] = (unsigned char)(image->height >> 24);
+	header[5] = (unsigned char)(image->height >> 16);
+	header[6] = (unsigned char)(image->height >> 8);
+	header[7] = (unsigned char)image->height;
+	header[8] = 8;
+	header[9] = (unsigned char)image->color_type;
+	header[10] = header[11] = header[12] = 0;
+	append_chunk( &buffer, "IHDR", header, 13 );
+	if( image->color_type == 3 )
+	{
+		append_chunk( &buffer, "PLTE", image->palette, image->palette_size * 3 );
+	}
+	if( image->transparency_size > 0 )
+	{
+		if( image->color_type == 3 )
+		{
+			append_chunk( &buffer, "tRNS", image->transparency, image->transparency_size );
+		} else
+		{
+			/*	16 bit samples	*/
+			unsigned char color[6];
+			for( x = 0; x < image->channels; ++x )
+			{
+				color[x * 2] = 0;
+				color[x * 2 + 1] = image->transparency[x];
+			}
+			append_chunk( &buffer, "tRNS", color, image->channels * 2 );
+		}
+	}
+	for( position = 0; position < compressed_size; )
+	{
+		int chunk = test_random_range( 1, compressed_size - position );
+		append_chunk( &buffer, "IDAT", compressed + position, chunk );
+		position += chunk;
+	}
+	append_chunk( &buffer, "IEND", NULL, 0 );
+
+	free( raw );
+	free( compressed );
+	*png_size = buffer.size;
+	return buffer.data;
+}
+
+static void create_png_image( png_image *image, int max_size )
+{
+	static const int color_types[5] = { 0, 2, 3, 4, 6 };
+	static const int channels[5] = { 1, 3, 1, 2, 4 };
+	int i, type = test_random_range( 0, 4 );
+	int size;
+	image->width = test_random_range( 1, max_size );
+	image->height = test_random_range( 1, max_size );
+	image->color_type = color_types[type];
+	image->channels = channels[type];
+	size = image->width * image->height * image->channels;
+	image->pixels = test_malloc( size );
+	test_fill_image( image->pixels, size );
+	image->palette_size = 0;
+	image->transparency_size = 0;
+	image->filter = test_random_range( -1, 4 );
+	if( image->color_type == 3 )
+	{
+		image->palette_size = test_random_range( 1, 256 );
+		for( i = 0; i < image->palette_size * 3; ++i )
+		{
+			image->palette[i] = (unsigned char)test_random();
+		}
+		for( i = 0; i < size; ++i )
+		{
+			image->pixels[i] = (unsigned char)(image->pixels[i] % image->palette_size);
+		}
+		if( test_random_range( 0, 1 ) )
+		{
+			image->transparency_size = test_random_range( 1, image->palette_size );
+			for( i = 0; i < image->transparency_size; ++i )
+			{
+				image->transparency[i] = (unsigned char)test_random();
+			}
+		}
+	} else if( ((image->channels & 1) == 1) && test_random_range( 0, 1 ) )
+	{
+		/*	the color of the first pixel, so that some pixels match	*/
+		image->transparency_size = 1;
+		memcpy( image->transparency, image->pixels, image->channels );
+	}
+}
+
+/*	the pixels that stb_image should load with req_comp 0, and their number of
+	channels, which includes the alpha made from a tRNS chunk	*/
+static unsigned char *get_expected_pixels( const png_image *image, int *channels )
+{
+	int i, c, count = image->width * image->height;
+	unsigned char *pixels;
+	if( image->color_type == 3 )
+	{
+		*channels = (image->transparency_size > 0) ? 4 : 3;
+		pixels = test_malloc( count * *channels );
+		for( i = 0; i < count; ++i )
+		{
+			int index = image->pixels[i];
+			unsigned char *pixel = pixels + i * *channels;
+			memcpy( pixel, image->palette + index * 3, 3 );
+			if( *channels == 4 )
+			{
+				pixel[3] = (unsigned char)((index < image->transparency_size) ?
+					image->transparency[index] : 255);
+			}
+		}
+		return pixels;
+	}
+	if( image->transparency_size == 0 )
+	{
+		*channels = image->channels;
+		return copy_prefix( image->pixels, count * image->channels );
+	}
+	*channels = image->channels + 1;
+	pixels = test_malloc( count * *channels );
+	for( i = 0; i < count; ++i )
+	{
+		const unsigned char *source = image->pixels + i * image->channels;
+		unsigned char *pixel = pixels + i * *channels;
+		int is_transparent = 1;
+		for( c = 0; c < image->channels; ++c )
+		{
+			pixel[c] = source[c];
+			is_transparent &= (source[c] == image->transparency[c]);
+		}
+		pixel[image->channels] = (unsigned char)(is_transparent ? 0 : 255);
+	}
+	return pixels;
+}
+
+/*	converts pixels to another number of channels the way stb_image does	*/
+static unsigned char *convert_pixels( const unsigned char *pixels, int count,
+	int channels, int new_channels )
+{
+	int i;
+	unsigned char *converted = test_malloc( count * new_channels );
+	for( i = 0; i < count; ++i )
+	{
+		const unsigned char *source = pixels + i * channels;
+		unsigned char *dest = converted + i * new_channels;
+		int r = source[0], g = source[0], b = source[0], a = 255, y = source[0];
+		if( channels >= 3 )
+		{
+			g = source[1];
+			b = source[2];
+			y = (r * 77 + g * 150 + b * 29) >> 8;
+		}
+		if( (channels & 1) == 0 )
+		{
+			a = source[channels - 1];
+		}
+		if( new_channels < 3 )
+		{
+			dest[0] = (unsigned char)y;
+		} else
+		{
+			dest[0] = (unsigned char)r;
+			dest[1] = (unsigned char)g;
+			dest[2] = (unsigned char)b;
+		}
+		if( (new_channels & 1) == 0 )
+		{
+			dest[new_channels - 1] = (unsigned char)a;
+		}
+	}
+	return converted;
+}
+
+/*	whether the loaded image, which may be NULL, is the expected one	*/
+static int is_loaded( const png_image *image, const unsigned char *expected, int channels,
+	int expected_comp, const unsigned char *loaded, int width, int height, int comp )
+{
+	return (loaded != NULL) && (width == image->width) && (height == image->height) &&
+		(comp == expected_comp) &&
+		(test_compare( expected, loaded, width * height * channels ) < 0);
+}
+
+static int test_png( int num_cases )
+{
+	int i, num_failed = 0;
+	for( i = 0; i < num_cases; ++i )
+	{
+		png_image image;
+		int png_size, channels, expected_comp, req_comp;
+		int width = 0, height = 0, comp = 0, is_correct = 1;
+		unsigned char *png, *expected, *loaded;
+		create_png_image( &image, (i % 30 == 0) ? 600 : 70 );
+		png = encode_png( &image, &png_size );
+		expected = get_expected_pixels( &image, &channels );
+		/*	stb_image leaves the alpha from a color key out of comp	*/
+		expected_comp = (image.color_type == 3) ? channels : image.channels;
+
+		for( req_comp = 0; req_comp <= 4; ++req_comp )
+		{
+			int new_channels = (req_comp > 0) ? req_comp : channels;
+			unsigned char *converted = convert_pixels( expected,
+				image.width * image.height, channels, new_channels );
+			loaded = stbi_load_from_memory( png, png_size, &width, &height, &comp, req_comp );
+			if( !is_loaded( &image, converted, new_channels, expected_comp,
+				loaded, width, height, comp ) )
+			{
+				printf( "PNG %dx%d of color type %d, %s, filter %d, loaded wrong with "
+					"req_comp %d: %s\n", image.width, image.height, image.color_type,
+					(image.transparency_size > 0) ? "tRNS" : "no tRNS", image.filter,
+					req_comp, loaded ? "different pixels" : stbi_failure_reason() );
+				is_correct = 0;
+			}
+			free( converted );
+			free( loaded );
+		}
+
+		if( (i & 3) == 0 )
+		{
+			/*	a truncated PNG must fail, unless only the CRC of IEND was cut	*/
+			int cut = test_random_range( 0, png_size - 1 );
+			unsigned char *corrupt = copy_prefix( png, cut );
+			loaded = stbi_load_from_memory( corrupt, cut, &width, &height, &comp, 0 );
+			if( (loaded != NULL) &&
+				!is_loaded( &image, expected, channels, expected_comp, loaded, width, height, comp ) )
+			{
+				printf( "PNG %dx%d of color type %d cut to %d of %d bytes loaded wrong\n",
+					image.width, image.height, image.color_type, cut, png_size );
+				is_correct = 0;
+			}
+			free( loaded );
+			free( corrupt );
+
+			/*	corrupting anything after the header may load anything, but must not
+				crash.  The header is left alone, so the image size stays sane.	*/
+			corrupt = copy_prefix( png, png_size );
+			corrupt[test_random_range( 33, png_size - 1 )] ^= (unsigned char)(1 << (test_random() & 7));
+			free( stbi_load_from_memory( corrupt, png_size, &width, &height, &comp, 0 ) );
+			free( corrupt );
+		}
+
+		if( !is_correct )
+		{
+			++num_failed;
+		}
+		free( image.pixels );
+		free( png );
+		free( expected );
+	}
+	return num_failed;
+}
+
+/*	the output megabytes per second of the best of several runs of
+	stb_image's and of zlib's inflate	*/
+static void benchmark_inflate( const char *name, const unsigned char *data, int size )
+{
+	int run, compressed_size, inflated_size;
+	double stb_best = 1e9, zlib_best = 1e9;
+	unsigned char *compressed = compress_data( data, size, Z_DEFAULT_COMPRESSION, 15,
+		Z_DEFAULT_STRATEGY, 0, &compressed_size );
+	unsigned char *inflated = test_malloc( size );
+	for( run = 0; run < 5; ++run )
+	{
+		uLongf zlib_size = size;
+		double start = test_seconds();
+		free( stbi_zlib_decode_malloc( (const char*)compressed, compressed_size, &inflated_size ) );
+		start = test_seconds() - start;
+		if( start < stb_best )
+		{
+			stb_best = start;
+		}
+		start = test_seconds();
+		uncompress( inflated, &zlib_size, compressed, compressed_size );
+		start = test_seconds() - start;
+		if( start < zlib_best )
+		{
+			zlib_best = start;
+		}
+	}
+	printf( "%s, %d to %d bytes: stb_image %.0f MB/s, zlib %.0f MB/s\n", name, size,
+		compressed_size, size / stb_best / 1e6, size / zlib_best / 1e6 );
+	free( compressed );
+	free( inflated );
+}
+
+/*	the milliseconds to load a PNG with every row filtered the same way,
+	including the inflate	*/
+static void benchmark_png( int color_type, int channels, const unsigned char *pixels, int size )
+{
+	static const char *const filter_names[5] = { "None", "Sub", "Up", "Avg", "Paeth" };
+	int filter, run, png_size, width, height, comp;
+	png_image image;
+	memset( &image, 0, sizeof( image ) );
+	image.width = image.height = size;
+	image.color_type = color_type;
+	image.channels = channels;
+	image.pixels = (unsigned char*)pixels;
+	printf( "%dx%d %s PNG:", size, size, (channels == 4) ? "RGBA" : "RGB" );
+	for( filter = 0; filter < 5; ++filter )
+	{
+		unsigned char *png;
+		double best = 1e9;
+		image.filter = filter;
+		png = encode_png( &image, &png_size );
+		for( run = 0; run < 5; ++run )
+		{
+			double start = test_seconds();
+			free( stbi_load_from_memory( png, png_size, &width, &height, &comp, 0 ) );
+			start = (test_seconds() - start) * 1000.0;
+			if( start < best )
+			{
+				best = start;
+			}
+		}
+		printf( " %s %.1f ms%s", filter_names[filter], best, (filter < 4) ? "," : "\n" );
+		free( png );
+	}
+}
+
+static void benchmark( void )
+{
+	const int size = 2048;
+	int x, y, i;
+	unsigned char *data = test_malloc( size * size * 4 );
+
+	/*	a sprite sheet: gradients in tiles, with transparent gaps	*/
+	for( y = 0; y < size; ++y )
+	{
+		for( x = 0; x < size; ++x )
+		{
+			unsigned char *pixel = data + (y * size + x) * 4;
+			int is_gap = ((x & 127) < 8) || ((y & 127) < 8);
+			pixel[0] = (unsigned char)(is_gap ? 0 : x * 3 + (y >> 7));
+			pixel[1] = (unsigned char)(is_gap ? 0 : y * 5 + (x >> 7));
+			pixel[2] = (unsigned char)(is_gap ? 0 : (x ^ y) & 0xF0);
+			pixel[3] = (unsigned char)(is_gap ? 0 : 255);
+		}
+	}
+	benchmark_inflate( "Sprite sheet", data, size * size * 4 );
+	benchmark_png( 6, 4, data, 1024 );
+	for( i = 0; i < 1024 * 1024; ++i )
+	{
+		memmove( data + i * 3, data + i * 4, 3 );
+	}
+	benchmark_png( 2, 3, data, 1024 );
+
+	for( i = 0; i < 4 * 1024 * 1024; )
+	{
+		const char *word = words[test_random() % (sizeof( words ) / sizeof( words[0] ))];
+		while( *word != 0 )
+		{
+			data[i++] = *word++;
+		}
+		data[i++] = ' ';
+	}
+	benchmark_inflate( "Text", data, 4 * 1024 * 1024 );
+	free( data );
+}
+
+int main( int argc, char *argv[] )
+{
+	int num_cases = (argc > 1) ? atoi( argv[1] ) : 2000;
+	int num_failed = test_inflate( num_cases );
+	if( num_failed > 0 )
+	{
+		printf( "%d zlib streams did not inflate correctly\n", num_failed );
+		return 1;
+	}
+	printf( "All zlib streams inflate correctly\n" );
+
+	num_failed = test_png( num_cases * 9 / 20 );
+	if( num_failed > 0 )
+	{
+		printf( "%d PNGs did not load correctly\n", num_failed );
+		return 1;
+	}
+	printf( "All PNGs load correctly\n" );
+
+	benchmark();
+	return 0;
+}
@@ -0,0 +1,271 @@
+#include "AssetArchive.h"
+
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <memory>
+
+using namespace std;
+
+AssetArchive gArchive;
+
+static const unsigned int kMagic = 'I' | ('P' << 8) | ('A' << 16) | ('K' << 24);
+static const unsigned int kVersion = 1;
+
+// The fields are in the byte order of the machine that built the archive, which is assumed to
+// be little endian like the ones that read it
+struct AssetArchive::Header {
+	unsigned int magic;
+	unsigned int version;
+	unsigned int numSlots; // A power of two, at least twice the number of assets
+	unsigned int numAssets;
+};
+
+/** A directory slot, which is empty if nameLength is 0. Offsets are from the start of the file. */
+struct AssetArchive::Slot {
+	unsigned int hash;
+	unsigned int nameOffset;
+	unsigned int nameLength;
+	unsigned int dataOffset;
+	unsigned int dataSize;
+	unsigned int reserved;
+};
+
+/** FNV-1a */
+static unsigned int hashPath(const char* path, size_t length) {
+	unsigned int hash = 2166136261u;
+	for (size_t i = 0; i < length; ++i) {
+		hash = (hash ^ (unsigned char)path[i]) * 16777619u;
+	}
+
+	return hash;
+}
+
+static size_t align(size_t offset) {
+	return (offset + AssetArchive::kAlignment - 1) & ~(AssetArchive::kAlignment - 1);
+}
+
+AssetArchive::AssetArchive() :
+	mSlots(nullptr),
+	mNumSlots(0),
+	mModifiedTime(-1)
+{
+}
+
+bool AssetArchive::open(const char* path) {
+	close();
+	if (!mFile.open(path)) {
+		return false;
+	}
+
+	auto size = mFile.getSize();
+	Header header;
+	if (size < sizeof(header)) {
+		close();
+		return false;
+	}
+
+	memcpy(&header, mFile.getData(), sizeof(header));
+	if (header.magic != kMagic || header.version != kVersion ||
+		header.numSlots == 0 || (header.numSlots & (header.numSlots - 1)) != 0 ||
+		header.numSlots > (size - sizeof(header)) / sizeof(Slot))
+	{
+		close();
+		return false;
+	}
+
+	// Check every asset up front so that lookups can trust the directory
+	mSlots = (const Slot*)(mFile.getData() + sizeof(header));
+	unsigned int numAssets = 0;
+	for (unsigned int i = 0; i < header.numSlots; ++i) {
+		auto& slot = mSlots[i];
+		if (slot.nameLength == 0) {
+			continue;
+		}
+
+		if ((size_t)slot.nameOffset + slot.nameLength > size || (size_t)slot.dataOffset + slot.dataSize > size) {
+			close();
+			return false;
+		}
+
+		++numAssets;
+	}
+
+	// Lookups stop at the first empty slot
+	if (numAssets != header.numAssets || numAssets == header.numSlots) {
+		close();
+		return false;
+	}
+
+	mNumSlots = header.numSlots;
+	mModifiedTime = MappedFile::getModifiedTime(path);
+	return true;
+}
+
+void AssetArchive::close() {
+	mFile.close();
+	mSlots = nullptr;
+	mNumSlots = 0;
+	mModifiedTime = -1;
+}
+
+const char* AssetArchive::getName(const Slot& slot) const {
+	return (const char*)mFile.getData() + slot.nameOffset;
+}
+
+bool AssetArchive::find(const char* path, const unsigned char*& data, size_t& size) const {
+	if (!isOpen()) {
+		return false;
+	}
+
+	size_t length = strlen(path);
+	unsigned int hash = hashPath(path, length);
+	for (unsigned int i = hash & (mNumSlots - 1);; i = (i + 1) & (mNumSlots - 1)) {
+		auto& slot = mSlots[i];
+		if (slot.nameLength == 0) {
+			return false;
+		}
+
+		if (slot.hash == hash && slot.nameLength == length && memcmp(getName(slot), path, length) == 0) {
+			data = mFile.getData() + slot.dataOffset;
+			size = slot.dataSize;
+			return true;
+		}
+	}
+}
+
+vector<string> AssetArchive::list(const char* directory) const {
+	vector<string> paths;
+	string prefix = string(directory) + "/";
+	for (unsigned int i = 0; i < mNumSlots; ++i) {
+		auto& slot = mSlots[i];
+		if (slot.nameLength <= prefix.size()) {
+			continue;
+		}
+
+		string path(getName(slot), slot.nameLength);
+		if (path.compare(0, prefix.size(), prefix) == 0 && path.find('/', prefix.size()) == string::npos) {
+			paths.push_back(path);
+		}
+	}
+
+	return paths;
+}
+
+bool AssetArchive::build(const char* archivePath, const vector<string>& paths, string& error) {
+	Header header;
+	header.magic = kMagic;
+	header.version = kVersion;
+	header.numSlots = 1;
+	header.numAssets = (unsigned int)paths.size();
+	while (header.numSlots < paths.size() * 2) {
+		header.numSlots <<= 1;
+	}
+
+	// Place the names after the directory, then the contents of each file after the names
+	vector<Slot> slots(header.numSlots);
+	vector<unsigned int> slotIndices;
+	size_t offset = sizeof(header) + slots.size() * sizeof(Slot);
+	for (auto& path : paths) {
+		auto placed = paths.begin() + slotIndices.size();
+		if (std::find(paths.begin(), placed, path) != placed) {
+			error = "Duplicate asset " + path;
+			return false;
+		}
+
+		unsigned int hash = hashPath(path.c_str(), path.size());
+		unsigned int i = hash & (header.numSlots - 1);
+		while (slots[i].nameLength != 0) {
+			i = (i + 1) & (header.numSlots - 1);
+		}
+
+		slots[i].hash = hash;
+		slots[i].nameOffset = (unsigned int)offset;
+		slots[i].nameLength = (unsigned int)path.size();
+		slotIndices.push_back(i);
+		offset += path.size();
+	}
+
+	vector<unique_ptr<MappedFile>> files;
+	for (size_t i = 0; i < paths.size(); ++i) {
+		files.emplace_back(new MappedFile);
+		if (!files.back()->open(paths[i].c_str())) {
+			error = "Unable to read " + paths[i];
+			return false;
+		}
+
+		offset = align(offset);
+		if (offset + files.back()->getSize() > 0xffffffffu) {
+			error = "Archive too large";
+			return false;
+		}
+
+		auto& slot = slots[slotIndices[i]];
+		slot.dataOffset = (unsigned int)offset;
+		slot.dataSize = (unsigned int)files.back()->getSize();
+		offset += slot.dataSize;
+	}
+
+	ofstream out(archivePath, ios::binary);
+	out.write((const char*)&header, sizeof(header));
+	out.write((const char*)slots.data(), slots.size() * sizeof(Slot));
+	offset = sizeof(header) + slots.size() * sizeof(Slot);
+	for (auto& path : paths) {
+		out.write(path.data(), path.size());
+		offset += path.size();
+	}
+
+	static const char padding[kAlignment] = {};
+	for (size_t i = 0; i < paths.size(); ++i) {
+		auto& slot = slots[slotIndices[i]];
+		out.write(padding, slot.dataOffset - offset);
+		out.write((const char*)files[i]->getData(), slot.dataSize);
+		offset = slot.dataOffset + slot.dataSize;
+	}
+
+	if (!out) {
+		error = "Unable to write file";
+		return false;
+	}
+
+	return true;
+}
+
+AssetFile::AssetFile() :
+	mData(nullptr),
+	mSize(0)
+{
+}
+
+bool AssetFile::findInArchive(const char* path, long long looseTime, const unsigned char*& data, size_t& size) {
+	return gArchive.find(path, data, size) && looseTime <= gArchive.getModifiedTime();
+}
+
+bool AssetFile::open(const char* path) {
+	mFile.close();
+	mData = nullptr;
+	mSize = 0;
+
+	// Only a stat of the loose file, which is much cheaper than mapping it
+	if (gArchive.isOpen() && findInArchive(path, MappedFile::getModifiedTime(path), mData, mSize)) {
+		return true;
+	}
+
+	mData = nullptr;
+	mSize = 0;
+
+	if (!mFile.open(path)) {
+		return false;
+	}
+
+	mData = mFile.getData();
+	mSize = mFile.getSize();
+	return true;
+}
+
+long long AssetFile::getModifiedTime(const char* path) {
+	auto looseTime = MappedFile::getModifiedTime(path);
+	const unsigned char* data;
+	size_t size;
+	return findInArchive(path, looseTime, data, size) ? gArchive.getModifiedTime() : looseTime;
+}
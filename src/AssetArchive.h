@@ -0,0 +1,89 @@
+#ifndef ASSET_ARCHIVE_H
+#define ASSET_ARCHIVE_H
+
+#include "MappedFile.h"
+#include <cstddef>
+#include <string>
+#include <vector>
+
+/**
+ * A single file holding the assets, built by isolated_pack
+ *
+ * The archive is mapped once and the assets in it are used in place: a hashed directory at the
+ * start of the file maps each asset's path, e.g. "data/settings.ini", to where its contents
+ * are, aligned to kAlignment bytes. While an archive is open, AssetFile reads the assets in it
+ * from there instead of from the loose files, unless a loose file has been written since the
+ * archive was, so edits show up before the pack target is run again.
+ */
+class AssetArchive {
+public:
+	static const size_t kAlignment = 16;
+
+private:
+	struct Header;
+	struct Slot;
+
+	MappedFile mFile;
+	const Slot* mSlots;
+	unsigned int mNumSlots;
+	long long mModifiedTime;
+
+	AssetArchive(const AssetArchive&) = delete;
+	AssetArchive(AssetArchive&&) = delete;
+
+	const char* getName(const Slot& slot) const;
+
+public:
+	AssetArchive();
+
+	/** Maps an archive, closing any archive opened before. Returns false if it can't be mapped or is corrupt. */
+	bool open(const char* path);
+	void close();
+	bool isOpen() const { return mFile.isOpen(); }
+
+	/** When the archive file was last written, as returned by MappedFile::getModifiedTime() */
+	long long getModifiedTime() const { return mModifiedTime; }
+
+	/** Finds an asset by its path, returning a pointer into the mapping */
+	bool find(const char* path, const unsigned char*& data, size_t& size) const;
+
+	/** Returns the paths of the assets in a directory, e.g. "data", without those in its subdirectories */
+	std::vector<std::string> list(const char* directory) const;
+
+	/** Writes the files to a new archive, each under the path given for it */
+	static bool build(const char* archivePath, const std::vector<std::string>& paths, std::string& error);
+};
+
+extern AssetArchive gArchive;
+
+/**
+ * The contents of an asset, read in place from gArchive if the asset is in it and mapped from
+ * the loose file otherwise
+ */
+class AssetFile {
+private:
+	MappedFile mFile;
+	const unsigned char* mData;
+	size_t mSize;
+
+	AssetFile(const AssetFile&) = delete;
+	AssetFile(AssetFile&&) = delete;
+
+	/** Finds the asset in gArchive, unless the loose file, written at looseTime, is newer than the archive */
+	static bool findInArchive(const char* path, long long looseTime, const unsigned char*& data, size_t& size);
+
+public:
+	AssetFile();
+
+	/** Returns false if the asset doesn't exist or is empty */
+	bool open(const char* path);
+
+	/** Returns when the asset that open() would read was last written, which is when gArchive was for those in it, or -1 if it doesn't exist */
+	static long long getModifiedTime(const char* path);
+
+	bool isOpen() const { return mData != nullptr; }
+	const unsigned char* getData() const { return mData; }
+	size_t getSize() const { return mSize; }
+};
+
+#endif
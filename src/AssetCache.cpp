@@ -0,0 +1,210 @@
+#include "AssetCache.h"
+
+#include "BakedImage.h"
+#include "Log.h"
+#include "WorkerPool.h"
+#include <soil/SOIL.h>
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+
+using namespace std;
+
+shared_ptr<AssetCache> gAssets;
+
+static const int kAtlasSize = 1024;
+static const int kPadding = 1; // Transparent texels between images so filtering doesn't bleed
+static const size_t kUploadBudget = 8 << 20; // Bytes uploaded per update() before the rest wait for the next frame
+
+static int nextPowerOfTwo(int n) {
+	int result = 1;
+	while (result < n) {
+		result <<= 1;
+	}
+
+	return result;
+}
+
+AtlasImage AssetCache::pack(const unsigned char* pixels, int width, int height) {
+	int paddedWidth = width + kPadding * 2;
+	int paddedHeight = height + kPadding * 2;
+	TextureAtlas* atlas = nullptr;
+	int x, y;
+
+	for (auto& candidate : mAtlases) {
+		if (candidate->allocate(paddedWidth, paddedHeight, x, y)) {
+			atlas = candidate.get();
+			break;
+		}
+	}
+
+	if (!atlas) {
+		int atlasWidth = max(kAtlasSize, nextPowerOfTwo(paddedWidth));
+		int atlasHeight = max(kAtlasSize, nextPowerOfTwo(paddedHeight));
+		mAtlases.emplace_back(new TextureAtlas(atlasWidth, atlasHeight));
+		atlas = mAtlases.back().get();
+		atlas->allocate(paddedWidth, paddedHeight, x, y);
+	}
+
+	x += kPadding;
+	y += kPadding;
+	atlas->upload(mUploader, x, y, width, height, pixels);
+
+	AtlasImage image;
+	image.texture = atlas->getTexture();
+	image.width = width;
+	image.height = height;
+	image.s1 = (float)x / atlas->getWidth();
+	image.t1 = (float)y / atlas->getHeight();
+	image.s2 = (float)(x + width) / atlas->getWidth();
+	image.t2 = (float)(y + height) / atlas->getHeight();
+	return image;
+}
+
+AtlasImage AssetCache::uploadBaked(const DecodedImage& decoded) {
+	// Without DXT support SOIL decodes the file instead, and needs to generate the mipmaps itself
+	unsigned int flags = SOIL_FLAG_DDS_LOAD_DIRECT | (decoded.numLevels > 1 ? SOIL_FLAG_MIPMAPS : 0);
+	GLuint texture = SOIL_load_OGL_texture_from_memory(decoded.baked->getData(), (int)decoded.baked->getSize(), SOIL_LOAD_RGBA, SOIL_CREATE_NEW_ID, flags);
+
+	AtlasImage image = {texture, decoded.width, decoded.height, 0.f, 0.f, 1.f, 1.f};
+	if (!texture) {
+		return image;
+	}
+
+	// Filter like the atlases do
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, decoded.numLevels > 1 ? GL_NEAREST_MIPMAP_NEAREST : GL_NEAREST);
+	mTextures.push_back(texture);
+	return image;
+}
+
+AssetCache::~AssetCache() {
+	// The workers may still be decoding images that were never packed
+	for (auto entry : mLoading) {
+		if (!entry->asset->loaded) {
+			SOIL_free_image_data(entry->decoding.get().pixels);
+		}
+	}
+
+	if (!mTextures.empty()) {
+		glDeleteTextures((GLsizei)mTextures.size(), mTextures.data());
+	}
+}
+
+AssetCache::DecodedImage AssetCache::decode(const string& path) {
+	DecodedImage decoded = {nullptr, nullptr, 0, 0, 1, ""};
+
+	BakedImageInfo info;
+	unique_ptr<AssetFile> baked(new AssetFile);
+	if (hasCurrentBakedImage(path) && baked->open(getBakedPath(path).c_str()) && readBakedImageInfo(baked->getData(), baked->getSize(), info)) {
+		decoded.baked = move(baked);
+		decoded.width = info.width;
+		decoded.height = info.height;
+		decoded.numLevels = info.numLevels;
+		return decoded;
+	}
+
+	AssetFile file;
+	if (!file.open(path.c_str())) {
+		decoded.error = "Unable to read file";
+		return decoded;
+	}
+
+	int channels;
+	decoded.pixels = SOIL_load_image_from_memory(file.getData(), (int)file.getSize(), &decoded.width, &decoded.height, &channels, SOIL_LOAD_RGBA);
+	if (!decoded.pixels) {
+		decoded.error = SOIL_last_result();
+		return decoded;
+	}
+
+	prepareImage(decoded.pixels, decoded.width, decoded.height);
+	return decoded;
+}
+
+AssetCache::Entry& AssetCache::startLoading(const char* path) {
+	auto& entry = mImages[path];
+	if (entry.asset) {
+		return entry;
+	}
+
+	entry.path = path;
+	entry.asset = make_shared<ImageAsset>();
+	memset(&entry.asset->image, 0, sizeof(entry.asset->image));
+	entry.asset->loaded = false;
+	if (auto info = mIndex.find(entry.path)) {
+		entry.asset->image.width = info->width;
+		entry.asset->image.height = info->height;
+	}
+
+	string pathCopy = path;
+	if (gWorkers) {
+		entry.decoding = gWorkers->async([pathCopy]() { return decode(pathCopy); });
+	} else {
+		entry.decoding = async(launch::deferred, [pathCopy]() { return decode(pathCopy); });
+	}
+
+	mLoading.push_back(&entry);
+	return entry;
+}
+
+size_t AssetCache::finish(Entry& entry) {
+	if (entry.asset->loaded) {
+		return 0;
+	}
+
+	// Failures are kept too so that each file is only ever read once
+	auto decoded = entry.decoding.get();
+	entry.asset->loaded = true;
+	if (decoded.baked) {
+		entry.asset->image = uploadBaked(decoded);
+		if (!entry.asset->image.texture) {
+			LOG_ERROR("Failed to upload baked image %s: %s", entry.path.c_str(), SOIL_last_result());
+		}
+		return decoded.baked->getSize();
+	}
+
+	if (!decoded.pixels) {
+		LOG_ERROR("Failed to load image %s: %s", entry.path.c_str(), decoded.error.c_str());
+		return 0;
+	}
+
+	entry.asset->image = pack(decoded.pixels, decoded.width, decoded.height);
+	SOIL_free_image_data(decoded.pixels);
+	return (size_t)decoded.width * decoded.height * 4;
+}
+
+ImageHandle AssetCache::load(const char* path) {
+	return startLoading(path).asset;
+}
+
+const AtlasImage* AssetCache::getImage(const char* path) {
+	auto& entry = startLoading(path);
+	finish(entry);
+	return entry.asset->image.texture ? &entry.asset->image : nullptr;
+}
+
+void AssetCache::update() {
+	size_t uploaded = 0;
+	for (size_t i = 0; i < mLoading.size();) {
+		auto entry = mLoading[i];
+		// Without workers, decoding is deferred until finish() asks for the result
+		if (!entry->asset->loaded && uploaded < kUploadBudget && entry->decoding.wait_for(chrono::seconds(0)) != future_status::timeout) {
+			uploaded += finish(*entry);
+		}
+
+		if (entry->asset->loaded) {
+			mLoading[i] = mLoading.back();
+			mLoading.pop_back();
+		} else {
+			++i;
+		}
+	}
+}
+
+void AssetCache::finishLoading() {
+	for (auto entry : mLoading) {
+		finish(*entry);
+	}
+
+	mLoading.clear();
+}
@@ -0,0 +1,111 @@
+#ifndef ASSET_CACHE_H
+#define ASSET_CACHE_H
+
+#include "AssetArchive.h"
+#include "ImageIndex.h"
+#include "TextureAtlas.h"
+#include "TextureUploader.h"
+#include <GLFW/glfw3.h>
+#include <future>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/** Where an image ended up in an atlas, or its own texture if it was baked */
+struct AtlasImage {
+	GLuint texture; // 0 if the image failed to load
+	int width, height;
+	float s1, t1; // Texture coordinates of the bottom left corner
+	float s2, t2; // Texture coordinates of the top right corner
+};
+
+/** An image that may still be loading */
+struct ImageAsset {
+	bool loaded; // Set once the image is uploaded, or failed to load
+	AtlasImage image; // Until loaded, only the size is set, and only if the image is indexed
+};
+
+typedef std::shared_ptr<const ImageAsset> ImageHandle;
+
+/**
+ * Loads each image file once and packs it into a shared texture atlas
+ *
+ * Files are mapped, or read in place from gArchive, and decoded on gWorkers, and only packed into an atlas and uploaded by the
+ * rendering thread, either in update() or when a caller needs the image right away.
+ * Images are flipped so that their bottom row is at t1 and their alpha is premultiplied, for
+ * (GL_ONE, GL_ONE_MINUS_SRC_ALPHA) blending. A new atlas is started whenever the current ones
+ * are full, and images too large for an atlas get a texture of their own.
+ *
+ * If an image has been baked (see BakedImage.h), the workers only map the baked file and the
+ * compressed levels are uploaded straight from the mapping into a texture of their own. A baked
+ * file older than its image is ignored until the bake target is run again.
+ *
+ * Pixels are streamed into the atlases through pixel buffers when the driver supports them, and
+ * update() only uploads a few megabytes each frame so that loading many images doesn't stall it.
+ *
+ * Only to be used by the rendering thread.
+ * Note: The rendering context must be initialized before instantiating the cache
+ */
+class AssetCache {
+private:
+	struct DecodedImage {
+		unsigned char* pixels; // Freed with SOIL_free_image_data, null on failure or if baked
+		std::unique_ptr<AssetFile> baked; // The baked file, uploaded as is
+		int width, height;
+		int numLevels;
+		std::string error;
+	};
+
+	struct Entry {
+		std::string path;
+		std::shared_ptr<ImageAsset> asset;
+		std::future<DecodedImage> decoding;
+	};
+
+	std::vector<std::unique_ptr<TextureAtlas>> mAtlases;
+	std::vector<GLuint> mTextures; // Textures of baked images
+	TextureUploader mUploader;
+	std::unordered_map<std::string, Entry> mImages;
+	std::vector<Entry*> mLoading;
+	ImageIndex mIndex;
+
+	AssetCache(const AssetCache&) = delete;
+	AssetCache(AssetCache&&) = delete;
+
+	static DecodedImage decode(const std::string& path);
+
+	AtlasImage pack(const unsigned char* pixels, int width, int height);
+	AtlasImage uploadBaked(const DecodedImage& decoded);
+
+	/** Waits for an entry to finish decoding, then packs it. Returns how many bytes were uploaded. */
+	size_t finish(Entry& entry);
+
+	Entry& startLoading(const char* path);
+
+public:
+	AssetCache() {}
+	~AssetCache();
+
+	/** Indexes the images in a directory, so that their size is known before they are loaded. Returns how many were indexed. */
+	int indexDirectory(const char* directory) { return mIndex.scan(directory); }
+
+	/** Starts loading an image in the background if it isn't cached yet */
+	ImageHandle load(const char* path);
+
+	/** Returns the image loaded from path, waiting for it to load if necessary. Returns nullptr on failure. */
+	const AtlasImage* getImage(const char* path);
+
+	/** Packs the images that finished decoding, up to an upload budget. Call once per frame. */
+	void update();
+
+	/** Waits for every image being loaded */
+	void finishLoading();
+
+	bool isLoading() const { return !mLoading.empty(); }
+	int getNumTextures() const { return (int)(mAtlases.size() + mTextures.size()); }
+};
+
+extern std::shared_ptr<AssetCache> gAssets;
+
+#endif
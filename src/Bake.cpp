@@ -0,0 +1,30 @@
+#include "BakedImage.h"
+#include <cstdio>
+#include <string>
+
+using namespace std;
+
+/**
+ * isolated_bake: converts images into baked DDS files next to them
+ * Usage: isolated_bake image...
+ */
+int main(int argc, char* argv[]) {
+	if (argc < 2) {
+		fprintf(stderr, "Usage: %s image...\n", argv[0]);
+		return 1;
+	}
+
+	int numFailed = 0;
+	for (int i = 1; i < argc; ++i) {
+		string bakedPath = getBakedPath(argv[i]);
+		string error;
+		if (bakeImage(argv[i], bakedPath.c_str(), error)) {
+			printf("%s -> %s\n", argv[i], bakedPath.c_str());
+		} else {
+			fprintf(stderr, "Failed to bake %s: %s\n", argv[i], error.c_str());
+			++numFailed;
+		}
+	}
+
+	return numFailed > 0 ? 1 : 0;
+}
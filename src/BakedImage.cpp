@@ -0,0 +1,257 @@
+#include "BakedImage.h"
+
+#include <soil/image_DXT.h>
+#include <soil/image_helper.h>
+#include <soil/SOIL.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <vector>
+
+using namespace std;
+
+static const unsigned int kMagic = 'D' | ('D' << 8) | ('S' << 16) | (' ' << 24);
+static const unsigned int kFourCCDXT1 = 'D' | ('X' << 8) | ('T' << 16) | ('1' << 24);
+static const unsigned int kFourCCDXT5 = 'D' | ('X' << 8) | ('T' << 16) | ('5' << 24);
+
+// Images that compress worse than this are baked uncompressed
+static const double kMaxCompressionError = 6.0; // Root mean square error per channel
+
+enum BakedFormat {
+	BAKED_DXT1,
+	BAKED_DXT5,
+	BAKED_BGRA
+};
+
+static bool isPowerOfTwo(int n) {
+	return (n & (n - 1)) == 0;
+}
+
+/** Returns the size of one level */
+static size_t getLevelSize(int width, int height, BakedFormat format) {
+	switch (format) {
+	case BAKED_DXT1: return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 8;
+	case BAKED_DXT5: return (size_t)((width + 3) / 4) * ((height + 3) / 4) * 16;
+	default: return (size_t)width * height * 4;
+	}
+}
+
+static DDS_header makeHeader(int width, int height, int numLevels, BakedFormat format) {
+	DDS_header header;
+	memset(&header, 0, sizeof(header));
+	header.dwMagic = kMagic;
+	header.dwSize = 124;
+	header.dwFlags = DDSD_CAPS | DDSD_HEIGHT | DDSD_WIDTH | DDSD_PIXELFORMAT;
+	header.dwWidth = width;
+	header.dwHeight = height;
+	header.sPixelFormat.dwSize = 32;
+	header.sCaps.dwCaps1 = DDSCAPS_TEXTURE;
+
+	if (format == BAKED_BGRA) {
+		header.dwFlags |= DDSD_PITCH;
+		header.dwPitchOrLinearSize = width * 4;
+		header.sPixelFormat.dwFlags = DDPF_RGB | DDPF_ALPHAPIXELS;
+		header.sPixelFormat.dwRGBBitCount = 32;
+		header.sPixelFormat.dwRBitMask = 0x00ff0000;
+		header.sPixelFormat.dwGBitMask = 0x0000ff00;
+		header.sPixelFormat.dwBBitMask = 0x000000ff;
+		header.sPixelFormat.dwAlphaBitMask = 0xff000000;
+	} else {
+		header.dwFlags |= DDSD_LINEARSIZE;
+		header.dwPitchOrLinearSize = (unsigned int)getLevelSize(width, height, format);
+		header.sPixelFormat.dwFlags = DDPF_FOURCC;
+		header.sPixelFormat.dwFourCC = format == BAKED_DXT1 ? kFourCCDXT1 : kFourCCDXT5;
+	}
+
+	if (numLevels > 1) {
+		header.dwFlags |= DDSD_MIPMAPCOUNT;
+		header.dwMipMapCount = numLevels;
+		header.sCaps.dwCaps1 |= DDSCAPS_COMPLEX | DDSCAPS_MIPMAP;
+	}
+
+	return header;
+}
+
+/** Appends one level of RGBA pixels to a DDS file */
+static bool appendLevel(vector<unsigned char>& file, const unsigned char* pixels, int width, int height, BakedFormat format) {
+	if (format == BAKED_BGRA) {
+		size_t start = file.size();
+		file.insert(file.end(), pixels, pixels + width * height * 4);
+		for (size_t i = start; i < file.size(); i += 4) {
+			swap(file[i], file[i + 2]);
+		}
+		return true;
+	}
+
+	int size;
+	auto compressed = format == BAKED_DXT1 ?
+		convert_image_to_DXT1(pixels, width, height, 4, &size) :
+		convert_image_to_DXT5(pixels, width, height, 4, &size);
+	if (!compressed) {
+		return false;
+	}
+
+	file.insert(file.end(), compressed, compressed + size);
+	free(compressed);
+	return true;
+}
+
+/** Returns the contents of a DDS file holding the image and its mipmaps, or nothing on failure */
+static vector<unsigned char> bakeLevels(const vector<unsigned char>& pixels, int width, int height, int numLevels, BakedFormat format) {
+	vector<unsigned char> file(sizeof(DDS_header));
+	auto header = makeHeader(width, height, numLevels, format);
+	memcpy(file.data(), &header, sizeof(header));
+
+	vector<unsigned char> level = pixels;
+	vector<unsigned char> nextLevel;
+	int levelWidth = width;
+	int levelHeight = height;
+	for (int i = 0; i < numLevels; ++i) {
+		if (!appendLevel(file, level.data(), levelWidth, levelHeight, format)) {
+			return vector<unsigned char>();
+		}
+
+		if (i + 1 < numLevels) {
+			int nextWidth = max(levelWidth / 2, 1);
+			int nextHeight = max(levelHeight / 2, 1);
+			nextLevel.resize(nextWidth * nextHeight * 4);
+			mipmap_image(level.data(), levelWidth, levelHeight, 4, nextLevel.data(), levelWidth > 1 ? 2 : 1, levelHeight > 1 ? 2 : 1);
+			level.swap(nextLevel);
+			levelWidth = nextWidth;
+			levelHeight = nextHeight;
+		}
+	}
+
+	return file;
+}
+
+/** Decodes the full size image of a baked file and compares it with the original pixels */
+static double getCompressionError(const vector<unsigned char>& file, const vector<unsigned char>& pixels) {
+	int width, height, channels;
+	auto decoded = SOIL_load_image_from_memory(file.data(), (int)file.size(), &width, &height, &channels, SOIL_LOAD_RGBA);
+	if (!decoded) {
+		return HUGE_VAL;
+	}
+
+	double sum = 0.0;
+	for (size_t i = 0; i < pixels.size(); ++i) {
+		double difference = (double)decoded[i] - pixels[i];
+		sum += difference * difference;
+	}
+
+	SOIL_free_image_data(decoded);
+	return sqrt(sum / pixels.size());
+}
+
+void prepareImage(unsigned char* pixels, int width, int height) {
+	int rowSize = width * 4;
+	vector<unsigned char> row(rowSize);
+	for (int y = 0; y < height / 2; ++y) {
+		auto top = pixels + y * rowSize;
+		auto bottom = pixels + (height - 1 - y) * rowSize;
+		memcpy(row.data(), top, rowSize);
+		memcpy(top, bottom, rowSize);
+		memcpy(bottom, row.data(), rowSize);
+	}
+
+	for (auto pixel = pixels, end = pixels + rowSize * height; pixel != end; pixel += 4) {
+		unsigned int alpha = pixel[3];
+		pixel[0] = (unsigned char)((pixel[0] * alpha + 128) >> 8);
+		pixel[1] = (unsigned char)((pixel[1] * alpha + 128) >> 8);
+		pixel[2] = (unsigned char)((pixel[2] * alpha + 128) >> 8);
+	}
+}
+
+string getBakedPath(const string& path) {
+	auto dot = path.find_last_of('.');
+	auto slash = path.find_last_of("/\\");
+	if (dot == string::npos || (slash != string::npos && dot < slash)) {
+		return path + ".dds";
+	}
+
+	return path.substr(0, dot) + ".dds";
+}
+
+bool readBakedImageInfo(const unsigned char* data, size_t size, BakedImageInfo& info) {
+	DDS_header header;
+	if (size < sizeof(header)) {
+		return false;
+	}
+
+	memcpy(&header, data, sizeof(header));
+	if (header.dwMagic != kMagic || header.dwSize != 124) {
+		return false;
+	}
+
+	BakedFormat format;
+	auto& pixelFormat = header.sPixelFormat;
+	if ((pixelFormat.dwFlags & DDPF_FOURCC) && pixelFormat.dwFourCC == kFourCCDXT1) {
+		format = BAKED_DXT1;
+	} else if ((pixelFormat.dwFlags & DDPF_FOURCC) && pixelFormat.dwFourCC == kFourCCDXT5) {
+		format = BAKED_DXT5;
+	} else if ((pixelFormat.dwFlags & DDPF_RGB) && (pixelFormat.dwFlags & DDPF_ALPHAPIXELS) && pixelFormat.dwRGBBitCount == 32) {
+		format = BAKED_BGRA;
+	} else {
+		return false;
+	}
+
+	info.width = (int)header.dwWidth;
+	info.height = (int)header.dwHeight;
+	info.numLevels = (header.sCaps.dwCaps1 & DDSCAPS_MIPMAP) ? max((int)header.dwMipMapCount, 1) : 1;
+	if (info.width < 1 || info.height < 1 || info.numLevels > 32) {
+		return false;
+	}
+
+	size_t expectedSize = sizeof(header);
+	for (int level = 0; level < info.numLevels; ++level) {
+		expectedSize += getLevelSize(max(info.width >> level, 1), max(info.height >> level, 1), format);
+	}
+
+	return size >= expectedSize;
+}
+
+bool bakeImage(const char* sourcePath, const char* bakedPath, string& error) {
+	int width, height, channels;
+	auto pixels = SOIL_load_image(sourcePath, &width, &height, &channels, SOIL_LOAD_RGBA);
+	if (!pixels) {
+		error = SOIL_last_result();
+		return false;
+	}
+
+	prepareImage(pixels, width, height);
+	vector<unsigned char> image(pixels, pixels + width * height * 4);
+	SOIL_free_image_data(pixels);
+
+	bool opaque = true;
+	for (size_t i = 3; i < image.size(); i += 4) {
+		if (image[i] != 255) {
+			opaque = false;
+			break;
+		}
+	}
+
+	// Mipmaps of other sizes can't be used without ARB_texture_non_power_of_two anyway
+	int numLevels = 1;
+	if (isPowerOfTwo(width) && isPowerOfTwo(height)) {
+		while ((max(width, height) >> (numLevels - 1)) > 1) {
+			++numLevels;
+		}
+	}
+
+	// DXT only has 4 colors per block, which ruins images like fonts with a few flat colors
+	auto file = bakeLevels(image, width, height, numLevels, opaque ? BAKED_DXT1 : BAKED_DXT5);
+	if (file.empty() || getCompressionError(file, image) > kMaxCompressionError) {
+		file = bakeLevels(image, width, height, numLevels, BAKED_BGRA);
+	}
+
+	ofstream out(bakedPath, ios::binary);
+	out.write((const char*)file.data(), file.size());
+	if (!out) {
+		error = "Unable to write file";
+		return false;
+	}
+
+	return true;
+}
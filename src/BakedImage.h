@@ -0,0 +1,35 @@
+#ifndef BAKED_IMAGE_H
+#define BAKED_IMAGE_H
+
+#include <cstddef>
+#include <string>
+
+/**
+ * Images baked ahead of time by isolated_bake
+ *
+ * A baked image is a DDS file next to the source image, with the same name and a .dds
+ * extension. Its pixels are already prepared the way AssetCache prepares decoded images, then
+ * mipmapped if the image is a power of two and DXT compressed: DXT1 if the image is opaque,
+ * DXT5 otherwise. Images that DXT would visibly damage are stored as uncompressed BGRA instead.
+ * Either way the renderer can upload the levels as they are without decoding anything.
+ * Baked images are not rebuilt automatically, so rerun the bake target after editing an image.
+ */
+
+struct BakedImageInfo {
+	int width, height;
+	int numLevels; // Including the full size image
+};
+
+/** Flips RGBA pixels vertically and premultiplies their alpha, as SOIL_FLAG_INVERT_Y | SOIL_FLAG_MULTIPLY_ALPHA would */
+void prepareImage(unsigned char* pixels, int width, int height);
+
+/** Returns the path of the baked version of an image */
+std::string getBakedPath(const std::string& path);
+
+/** Checks that data holds a baked DDS file with every level it claims to have */
+bool readBakedImageInfo(const unsigned char* data, size_t size, BakedImageInfo& info);
+
+/** Loads, prepares, mipmaps and compresses an image, writing it to bakedPath */
+bool bakeImage(const char* sourcePath, const char* bakedPath, std::string& error);
+
+#endif
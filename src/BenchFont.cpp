@@ -0,0 +1,100 @@
+#include "AssetCache.h"
+#include "DebugFont.h"
+#include "GLExtensions.h"
+#include "WorkerPool.h"
+#include <GLFW/glfw3.h>
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+static const int kNumLines = 200;
+static const int kLineLength = 50; // So that each frame renders 10000 glyphs
+
+/** Renders the lines as the console would, returning the average milliseconds per frame */
+static double renderFrames(GLFWwindow* window, const vector<string>& lines, int numFrames, bool changing) {
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(0., 1280., 0., 720., -1., 1.);
+	glMatrixMode(GL_MODELVIEW);
+	glLoadIdentity();
+
+	string line;
+	double start = glfwGetTime();
+	for (int frame = 0; frame < numFrames; ++frame) {
+		glClear(GL_COLOR_BUFFER_BIT);
+		for (int i = 0; i < kNumLines; ++i) {
+			glPushMatrix();
+			glTranslatef(0.f, (float)(i * DebugFont::kGlyphHeight), 0.f);
+			if (changing) {
+				// Text that differs every frame, like a frame counter, is never found in the cache
+				char number[16];
+				snprintf(number, sizeof(number), "%08d", frame * kNumLines + i);
+				line.assign(lines[i], 0, kLineLength - 8);
+				line += number;
+				gDebugFont->renderString(line.c_str());
+			} else {
+				gDebugFont->renderString(lines[i].c_str());
+			}
+
+			glPopMatrix();
+		}
+
+		gDebugFont->flush();
+		glFinish();
+		glfwSwapBuffers(window);
+	}
+
+	return (glfwGetTime() - start) * 1000. / numFrames;
+}
+
+/**
+ * isolated_bench_font: times rendering 10000 glyphs of debug text per frame, first with text that
+ * stays the same between frames and then with text that changes every frame
+ * Usage: isolated_bench_font [frames], from the directory with the data directory
+ */
+int main(int argc, char* argv[]) {
+	int numFrames = argc > 1 ? atoi(argv[1]) : 500;
+	if (numFrames <= 0 || !glfwInit()) {
+		fprintf(stderr, "Usage: %s [frames]\n", argv[0]);
+		return 1;
+	}
+
+	glfwWindowHint(GLFW_VISIBLE, GL_FALSE);
+	GLFWwindow* window = glfwCreateWindow(1280, 720, "isolated_bench_font", nullptr, nullptr);
+	if (!window) {
+		fprintf(stderr, "Unable to create a window\n");
+		glfwTerminate();
+		return 1;
+	}
+
+	glfwMakeContextCurrent(window);
+	glfwSwapInterval(0);
+	gGLExtensions.load();
+
+	gWorkers.reset(new WorkerPool());
+	gAssets.reset(new AssetCache());
+	gDebugFont.reset(new DebugFont());
+
+	vector<string> lines(kNumLines);
+	for (int i = 0; i < kNumLines; ++i) {
+		for (int j = 0; j < kLineLength; ++j) {
+			lines[i] += (char)('!' + (i * 7 + j * 13) % ('~' - '!' + 1));
+		}
+	}
+
+	// Warm up the cache and the driver before timing
+	renderFrames(window, lines, 10, false);
+	printf("%d glyphs per frame\n", kNumLines * kLineLength);
+	printf("Unchanging text: %.3f ms per frame\n", renderFrames(window, lines, numFrames, false));
+	printf("Changing text:   %.3f ms per frame\n", renderFrames(window, lines, numFrames, true));
+
+	gDebugFont.reset();
+	gAssets.reset();
+	gWorkers.reset();
+	glfwDestroyWindow(window);
+	glfwTerminate();
+	return 0;
+}
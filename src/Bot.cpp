@@ -0,0 +1,35 @@
+#include "Bot.h"
+
+#include "Game.h"
+#include <cstdlib>
+
+static const float kMinDecisionTime = 0.2f;
+static const float kMaxDecisionTime = 1.5f;
+
+Bot::Bot(const Game& game, int playerId) :
+	mPlayerId(playerId),
+	mMovement(INPUT_COUNT),
+	mBuilding(false),
+	mDecisionTimer(game.getClock())
+{
+}
+
+void Bot::update() {
+	if (mDecisionTimer.isExpired()) {
+		// Pick a direction to move in, or stand still, and whether to build along the way
+		mMovement = (PlayerInput)(rand() % (INPUT_RIGHT + 2));
+		if (mMovement > INPUT_RIGHT) {
+			mMovement = INPUT_COUNT;
+		}
+		mBuilding = rand() % 4 == 0;
+
+		float t = (float)rand() / RAND_MAX;
+		mDecisionTimer.setDuration(kMinDecisionTime + t * (kMaxDecisionTime - kMinDecisionTime));
+	}
+
+	for (int input = INPUT_UP; input <= INPUT_RIGHT; ++input) {
+		gInput.setActive(mPlayerId, (PlayerInput)input, input == mMovement);
+	}
+
+	gInput.setActive(mPlayerId, INPUT_WALL, mBuilding);
+}
@@ -0,0 +1,30 @@
+#ifndef BOT_H
+#define BOT_H
+
+#include "Input.h"
+#include "Time.h"
+
+class Game;
+
+/**
+ * Controls a player by setting its inputs in gInput
+ * Wanders in random directions and sometimes holds the wall button, which is enough to keep
+ * the board busy for testing and profiling.
+ */
+class Bot {
+private:
+	int mPlayerId;
+	PlayerInput mMovement; // INPUT_COUNT when standing still
+	bool mBuilding;
+	Timer mDecisionTimer;
+
+public:
+	Bot(const Game& game, int playerId);
+
+	int getPlayerId() const { return mPlayerId; }
+
+	/** Called before the players are updated */
+	void update();
+};
+
+#endif
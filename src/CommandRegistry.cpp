@@ -0,0 +1,189 @@
+#include "CommandRegistry.h"
+
+#include "Config.h"
+#include "DebugConsole.h"
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <sstream>
+
+using namespace std;
+
+CommandRegistry gCommands;
+
+CommandRegistry::CommandRegistry() {
+	addCommand("help", "", "Lists the commands and variables", [this](const Arguments& args) { help(args); });
+	addCommand("get", "name", "Prints a variable or section.key config property", [this](const Arguments& args) { get(args); });
+	addCommand("set", "name value", "Sets a variable or section.key config property", [this](const Arguments& args) { set(args); });
+}
+
+void CommandRegistry::addCommand(const char* name, const char* usage, const char* help, Function function) {
+	auto& command = mCommands[name];
+	command.usage = usage;
+	command.help = help;
+	command.function = move(function);
+}
+
+void CommandRegistry::removeCommand(const char* name) {
+	mCommands.erase(name);
+}
+
+void CommandRegistry::addVariable(const char* name, CVarType type, void* value, const char* section, const char* help) {
+	auto& variable = mVariables[name];
+	variable.type = type;
+	variable.value = value;
+	variable.section = section ? section : "";
+	variable.help = help;
+}
+
+void CommandRegistry::addVariable(const char* name, int* value, const char* section, const char* help) {
+	addVariable(name, CVAR_INT, value, section, help);
+}
+
+void CommandRegistry::addVariable(const char* name, float* value, const char* section, const char* help) {
+	addVariable(name, CVAR_FLOAT, value, section, help);
+}
+
+void CommandRegistry::addVariable(const char* name, bool* value, const char* section, const char* help) {
+	addVariable(name, CVAR_BOOL, value, section, help);
+}
+
+void CommandRegistry::removeVariable(const char* name) {
+	mVariables.erase(name);
+}
+
+bool CommandRegistry::post(const char* line) {
+	PostedLine posted;
+	strncpy(posted.text, line, kMaxLineLength - 1);
+	posted.text[kMaxLineLength - 1] = 0;
+	return mPosted.push(posted);
+}
+
+void CommandRegistry::runPosted() {
+	while (auto posted = mPosted.front()) {
+		PostedLine line = *posted;
+		mPosted.pop();
+		execute(line.text);
+	}
+}
+
+void CommandRegistry::execute(const char* line) {
+	Arguments args;
+	istringstream reader(line);
+	string arg;
+	while (reader >> arg) {
+		args.push_back(arg);
+	}
+
+	if (args.empty()) {
+		return;
+	}
+
+	auto command = mCommands.find(args[0]);
+	if (command == mCommands.end()) {
+		print("Unknown command '%s', enter help for a list of commands", args[0].c_str());
+		return;
+	}
+
+	command->second.function(args);
+}
+
+void CommandRegistry::print(const char* format, ...) {
+	if (!gConsole) {
+		return;
+	}
+
+	va_list args;
+	va_start(args, format);
+	gConsole->vprint(format, args);
+	va_end(args);
+}
+
+/** Splits a section.key name, returning false if there is no section */
+static bool splitConfigName(const string& name, string& section, string& key) {
+	auto dot = name.find('.');
+	if (dot == string::npos) {
+		return false;
+	}
+
+	section = name.substr(0, dot);
+	key = name.substr(dot + 1);
+	return true;
+}
+
+void CommandRegistry::get(const Arguments& args) {
+	if (args.size() != 2) {
+		print("Usage: get name");
+		return;
+	}
+
+	string section, key;
+	auto variable = mVariables.find(args[1]);
+	if (variable != mVariables.end()) {
+		auto value = variable->second.value;
+		switch (variable->second.type) {
+		case CVAR_INT:
+			print("%s = %d", args[1].c_str(), *(int*)value);
+			break;
+		case CVAR_FLOAT:
+			print("%s = %g", args[1].c_str(), *(float*)value);
+			break;
+		case CVAR_BOOL:
+			print("%s = %d", args[1].c_str(), *(bool*)value ? 1 : 0);
+			break;
+		}
+	} else if (splitConfigName(args[1], section, key) && gConfig[section].keyExists(key.c_str())) {
+		print("%s = %s", args[1].c_str(), gConfig[section].getString(key.c_str()));
+	} else {
+		print("Unknown variable '%s'", args[1].c_str());
+	}
+}
+
+void CommandRegistry::set(const Arguments& args) {
+	if (args.size() != 3) {
+		print("Usage: set name value");
+		return;
+	}
+
+	auto& valueStr = args[2];
+	string section, key;
+	auto variable = mVariables.find(args[1]);
+	if (variable != mVariables.end()) {
+		auto value = variable->second.value;
+		switch (variable->second.type) {
+		case CVAR_INT:
+			*(int*)value = atoi(valueStr.c_str());
+			break;
+		case CVAR_FLOAT:
+			*(float*)value = (float)atof(valueStr.c_str());
+			break;
+		case CVAR_BOOL:
+			*(bool*)value = atoi(valueStr.c_str()) != 0;
+			break;
+		}
+
+		if (!variable->second.section.empty()) {
+			gConfig[variable->second.section].setProperty(args[1].c_str(), valueStr.c_str());
+		}
+	} else if (splitConfigName(args[1], section, key)) {
+		gConfig[section].setProperty(key.c_str(), valueStr.c_str());
+	} else {
+		print("Unknown variable '%s'", args[1].c_str());
+		return;
+	}
+
+	get(Arguments { "get", args[1] });
+}
+
+void CommandRegistry::help(const Arguments& args) {
+	print("Commands:");
+	for (auto& command : mCommands) {
+		print("  %s %s - %s", command.first.c_str(), command.second.usage.c_str(), command.second.help.c_str());
+	}
+
+	print("Variables:");
+	for (auto& variable : mVariables) {
+		print("  %s - %s", variable.first.c_str(), variable.second.help.c_str());
+	}
+}
@@ -0,0 +1,100 @@
+#ifndef COMMAND_REGISTRY_H
+#define COMMAND_REGISTRY_H
+
+#include "SpscQueue.h"
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+
+enum CVarType {
+	CVAR_INT,
+	CVAR_FLOAT,
+	CVAR_BOOL
+};
+
+/**
+ * Registry of console commands and variables
+ *
+ * Command lines entered in the console are posted by the render thread and executed by the
+ * simulation thread before its next step, so commands can safely change the scenes and the
+ * game. Apart from post(), the registry must only be used by the simulation thread once the
+ * simulation has started.
+ *
+ * Built in commands:
+ *   help => Lists the commands and variables
+ *   get name => Prints a variable, or a config property given as section.key
+ *   set name value => Sets a variable, or a config property given as section.key
+ */
+class CommandRegistry {
+public:
+	typedef std::vector<std::string> Arguments; // The command name followed by its arguments
+	typedef std::function<void(const Arguments& args)> Function;
+
+private:
+	static const int kMaxLineLength = 128;
+
+	struct Command {
+		std::string usage;
+		std::string help;
+		Function function;
+	};
+
+	struct Variable {
+		CVarType type;
+		void* value;
+		std::string section; // Config section the variable is mirrored to, if any
+		std::string help;
+	};
+
+	struct PostedLine {
+		char text[kMaxLineLength];
+	};
+
+	std::map<std::string, Command> mCommands;
+	std::map<std::string, Variable> mVariables;
+	SpscQueue<PostedLine, 64> mPosted;
+
+	CommandRegistry(const CommandRegistry&) = delete;
+	CommandRegistry(CommandRegistry&&) = delete;
+
+	void addVariable(const char* name, CVarType type, void* value, const char* section, const char* help);
+	void get(const Arguments& args);
+	void set(const Arguments& args);
+	void help(const Arguments& args);
+
+public:
+	CommandRegistry();
+
+	/**
+	 * Registers a command, replacing any command with the same name
+	 * @param usage the arguments of the command, e.g. "[count]"
+	 */
+	void addCommand(const char* name, const char* usage, const char* help, Function function);
+	void removeCommand(const char* name);
+
+	/**
+	 * Registers a variable that can be changed with get and set
+	 * @param section if not null, set also writes the value to this config section so that
+	 *     code which reads the variable from the config picks up the change
+	 */
+	void addVariable(const char* name, int* value, const char* section, const char* help);
+	void addVariable(const char* name, float* value, const char* section, const char* help);
+	void addVariable(const char* name, bool* value, const char* section, const char* help);
+	void removeVariable(const char* name);
+
+	/** Queues a command line to be executed by runPosted(). Called by a single producer thread. */
+	bool post(const char* line);
+
+	/** Executes the posted command lines in order. Called by the simulation thread. */
+	void runPosted();
+
+	void execute(const char* line);
+
+	/** Prints command output to the debug console */
+	static void print(const char* format, ...);
+};
+
+extern CommandRegistry gCommands;
+
+#endif
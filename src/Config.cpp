@@ -1,9 +1,9 @@
 #include "Config.h"
 
+#include "AssetArchive.h"
 #include <algorithm>
 #include <cstdlib>
 #include <iostream>
-#include <fstream>
 #include <map>
 #include <string>
 #include <sstream>
@@ -72,6 +72,14 @@ bool ConfigSection::keyExists(const char* key) {
 	return getProperty(key) != nullptr;
 }
 
+/** Reads an asset in place */
+struct AssetBuffer : streambuf {
+	AssetBuffer(const AssetFile& file) {
+		auto data = (char*)file.getData();
+		setg(data, data, data + file.getSize());
+	}
+};
+
 void Config::addFile(const char* path) {
 	addFile(path, cerr);
 }
@@ -79,7 +87,7 @@ void Config::addFile(const char* path) {
 void Config::addFile(const char* path, ostream& errorStream) {
 	static const char* whitespace = " \t";
 
-	ifstream in(path);
+	AssetFile file;
 	string inputLine;
 	string sectionName;
 	ConfigSection* section = nullptr;
@@ -87,13 +95,19 @@ void Config::addFile(const char* path, ostream& errorStream) {
 	string value;
 	stringstream trimmer;
 
-	if (!in.is_open()) {
+	if (!file.open(path)) {
 		errorStream << "failed to open configuration file '" << path << '\'' << endl;
 		return;
 	}
 
+	AssetBuffer buffer(file);
+	istream in(&buffer);
+
 	for (int lineNumber = 0; in.good(); ++lineNumber) {
 		getline(in, inputLine);
+		if (!inputLine.empty() && *inputLine.rbegin() == '\r') {
+			inputLine.pop_back();
+		}
 
 		// Remove trailing comments
 		inputLine = inputLine.substr(0, inputLine.find_first_of(';'));
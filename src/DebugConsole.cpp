@@ -1,13 +1,20 @@
 #include "DebugConsole.h"
+#include "CommandRegistry.h"
 #include "DebugFont.h"
-#include <iostream>
+#include "GLExtensions.h"
+#include "Log.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
 
 using namespace std;
 
 shared_ptr<AbstractDebugConsole> gConsole;
 
 static const int kHistoryNumLines = 100;
+static const int kScrollbackNumLines = 1000;
 static const int kMaxLineLength = 128;
+static const int kMaxPrintLength = 1024;
 
 AbstractDebugConsole::AbstractDebugConsole(int width, int height, int screenWidth, int screenHeight, int fontScale) :
 	mWidth(width), mHeight(height),
@@ -18,10 +25,14 @@ AbstractDebugConsole::AbstractDebugConsole(int width, int height, int screenWidt
 	mNumLines(mHeight / mGlyphHeight),
 	mSelectionStart(0), mSelectionEnd(0),
 	mInputPosition(0), mInputLength(0),
-	mOpen(false)
+	mOpen(false),
+	mTextVersion(0), mInputVersion(0),
+	mScrollback(kScrollbackNumLines * kMaxLineLength),
+	mScrollbackLengths(kScrollbackNumLines),
+	mScrollbackStart(0), mScrollbackCount(0), mScrollOffset(0),
+	mHistory(kHistoryNumLines),
+	mHistoryStart(0), mHistoryCount(0), mHistoryPosition(0)
 {
-	mTextBuffer = new char[(mGlyphsPerLine + 1) * mNumLines + 1]; // Add 1 per line for \n characters + 1 for null-terminator
-	mTextBuffer[0] = 0;
 	mInputBuffer = new char[kMaxLineLength+1];
 	mInputBuffer[0] = 0;
 
@@ -31,37 +42,170 @@ AbstractDebugConsole::AbstractDebugConsole(int width, int height, int screenWidt
 }
 
 AbstractDebugConsole::~AbstractDebugConsole() {
-	delete[] mTextBuffer;
 	delete[] mInputBuffer;
 }
 
 void AbstractDebugConsole::onCharacter(char ch) {
+	++mInputVersion;
+
 	if (ch == '\n') {
+		print("> %s", mInputBuffer);
+		addToHistory(mInputBuffer);
+		scroll(-kScrollbackNumLines);
 		onCommand(mInputBuffer);
 
 		// Clear the input buffer
 		mInputBuffer[0] = 0;
 		mInputPosition = 0;
+		mInputLength = 0;
+		mHistoryPosition = 0;
 	} else if (ch == 8) {
 		// Backspace
 		if (mInputPosition > 0) {
-			for (int i = mInputPosition - 1; i < kMaxLineLength; ++i) {
-				mInputBuffer[i] = mInputBuffer[i + 1];
-			}
+			memmove(mInputBuffer + mInputPosition - 1, mInputBuffer + mInputPosition, mInputLength - mInputPosition + 1);
 			--mInputPosition;
+			--mInputLength;
 		}
-	} else if (mInputPosition < kMaxLineLength - 1) {
-		// Printable ASCII character
+	} else if (mInputLength < kMaxLineLength - 1) {
+		// Printable ASCII character, inserted at the cursor
+		memmove(mInputBuffer + mInputPosition + 1, mInputBuffer + mInputPosition, mInputLength - mInputPosition + 1);
 		mInputBuffer[mInputPosition++] = ch;
-		mInputBuffer[mInputPosition] = 0;
+		++mInputLength;
+	}
+}
+
+void AbstractDebugConsole::onCommand(const char* command) {
+	if (!gCommands.post(command)) {
+		print("Too many commands are waiting to run, '%s' was ignored", command);
 	}
 }
 
 void AbstractDebugConsole::onNavigationCharacter(int ch) {
+	++mInputVersion;
+
+	switch (ch) {
+	case DEBUG_CONSOLE_HISTORY_PREVIOUS:
+		if (mHistoryPosition < mHistoryCount) {
+			++mHistoryPosition;
+			setInput(mHistory[(mHistoryStart + mHistoryCount - mHistoryPosition) % kHistoryNumLines].c_str());
+		}
+		break;
+	case DEBUG_CONSOLE_HISTORY_NEXT:
+		if (mHistoryPosition > 0) {
+			--mHistoryPosition;
+			setInput(mHistoryPosition == 0 ? "" : mHistory[(mHistoryStart + mHistoryCount - mHistoryPosition) % kHistoryNumLines].c_str());
+		}
+		break;
+	case DEBUG_CONSOLE_CURSOR_PREVIOUS:
+		mInputPosition = max(mInputPosition - 1, 0);
+		break;
+	case DEBUG_CONSOLE_CURSOR_NEXT:
+		mInputPosition = min(mInputPosition + 1, mInputLength);
+		break;
+	case DEBUG_CONSOLE_PAGE_UP:
+		scroll(mNumLines - 1);
+		break;
+	case DEBUG_CONSOLE_PAGE_DOWN:
+		scroll(-(mNumLines - 1));
+		break;
+	}
+}
+
+void AbstractDebugConsole::addToHistory(const char* command) {
+	// Don't fill the history with blank lines or repeats of the last command
+	if (!*command || (mHistoryCount > 0 && mHistory[(mHistoryStart + mHistoryCount - 1) % kHistoryNumLines] == command)) {
+		return;
+	}
+
+	if (mHistoryCount < kHistoryNumLines) {
+		mHistory[(mHistoryStart + mHistoryCount++) % kHistoryNumLines] = command;
+	} else {
+		mHistory[mHistoryStart] = command;
+		mHistoryStart = (mHistoryStart + 1) % kHistoryNumLines;
+	}
+}
+
+void AbstractDebugConsole::setInput(const char* text) {
+	mInputLength = min((int)strlen(text), kMaxLineLength - 1);
+	memcpy(mInputBuffer, text, mInputLength);
+	mInputBuffer[mInputLength] = 0;
+	mInputPosition = mInputLength;
+}
+
+void AbstractDebugConsole::scroll(int numLines) {
+	lock_guard<mutex> lock(mTextMutex);
+
+	int maxScrollOffset = max(mScrollbackCount - (mNumLines - 1), 0);
+	int scrollOffset = min(max(mScrollOffset + numLines, 0), maxScrollOffset);
+	if (scrollOffset != mScrollOffset) {
+		mScrollOffset = scrollOffset;
+		++mTextVersion;
+	}
+}
+
+void AbstractDebugConsole::appendLine(const char* text, int length) {
+	int index;
+	if (mScrollbackCount < kScrollbackNumLines) {
+		index = (mScrollbackStart + mScrollbackCount++) % kScrollbackNumLines;
+	} else {
+		index = mScrollbackStart;
+		mScrollbackStart = (mScrollbackStart + 1) % kScrollbackNumLines;
+	}
+
+	memcpy(&mScrollback[index * kMaxLineLength], text, length);
+	mScrollbackLengths[index] = length;
+
+	// Keep the same lines in view while scrolled up
+	if (mScrollOffset > 0) {
+		mScrollOffset = min(mScrollOffset + 1, max(mScrollbackCount - (mNumLines - 1), 0));
+	}
+
+	++mTextVersion;
 }
 
 void AbstractDebugConsole::print(const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	vprint(format, args);
+	va_end(args);
+}
+
+void AbstractDebugConsole::vprint(const char* format, va_list args) {
+	char buffer[kMaxPrintLength];
+	int length = vsnprintf(buffer, sizeof(buffer), format, args);
+	if (length < 0) {
+		return;
+	}
+	length = min(length, kMaxPrintLength - 1);
+
+	lock_guard<mutex> lock(mTextMutex);
 
+	// Split the text into lines at newlines and wherever it would run past the edge of the console
+	int maxColumns = max(min(mGlyphsPerLine, kMaxLineLength), 1);
+	int columns = 0;
+	const char* lineStart = buffer;
+	const char* end = buffer + length;
+
+	for (const char* ch = buffer; ch != end; ++ch) {
+		if (*ch == '\n') {
+			appendLine(lineStart, (int)(ch - lineStart));
+			lineStart = ch + 1;
+			columns = 0;
+			continue;
+		}
+
+		int width = *ch == '\t' ? DebugFont::kSpacesPerTab : 1;
+		if (columns + width > maxColumns && ch != lineStart) {
+			appendLine(lineStart, (int)(ch - lineStart));
+			lineStart = ch;
+			columns = 0;
+		}
+		columns += width;
+	}
+
+	if (lineStart != end) {
+		appendLine(lineStart, (int)(end - lineStart));
+	}
 }
 
 void AbstractDebugConsole::selectText(float x1, float y1, float x2, float y2) {
@@ -72,24 +216,20 @@ void AbstractDebugConsole::copySelectionToClipboard() {
 
 }
 
-#if defined(DEBUG_CONSOLE_RENDER_METHOD_QUADS)
+int AbstractDebugConsole::getVisibleLines(string* lines, int maxLines) const {
+	lock_guard<mutex> lock(mTextMutex);
 
-void DebugConsole::render() {
-	if (!mOpen) {
-		return;
+	int numLines = min(maxLines, mScrollbackCount - mScrollOffset);
+	int newest = mScrollbackStart + mScrollbackCount - 1 - mScrollOffset;
+	for (int i = 0; i < numLines; ++i) {
+		int index = (newest - i) % kScrollbackNumLines;
+		lines[i].assign(&mScrollback[index * kMaxLineLength], mScrollbackLengths[index]);
 	}
 
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-
-	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
-	glOrtho(0., mScreenWidth, 0., mScreenHeight, -1., 1.);
-	glMatrixMode(GL_MODELVIEW);
-	glPushMatrix();
-	glTranslatef(0.f, (float)(mScreenHeight - mHeight), 0.f);
+	return numLines;
+}
 
-	// Render the background
+void AbstractDebugConsole::renderBackground() const {
 	glBegin(GL_QUADS);
 	glColor4fv((GLfloat*)&mBackgroundColor);
 	glVertex2i(0, 0);
@@ -112,19 +252,244 @@ void DebugConsole::render() {
 	glVertex2i(x2, mGlyphHeight);
 	glVertex2i(x1, mGlyphHeight);
 	glEnd();
+}
+
+#if defined(DEBUG_CONSOLE_RENDER_METHOD_VERTEX_ARRAYS) || defined(DEBUG_CONSOLE_RENDER_METHOD_RENDER_TO_TEXTURE)
+
+VertexArrayDebugConsole::VertexArrayDebugConsole(int width, int height, int screenWidth, int screenHeight, int fontScale) :
+	AbstractDebugConsole(width, height, screenWidth, screenHeight, fontScale),
+	mLines(mNumLines),
+	mVisibleLines(mNumLines),
+	mNumVisibleLines(0),
+	mBuiltTextVersion(0),
+	mBuiltInputVersion(0)
+{
+}
+
+void VertexArrayDebugConsole::buildLine(int index, const char* text, int length) {
+	auto& line = mLines[index];
+	if (line.text.compare(0, string::npos, text, length) == 0) {
+		return;
+	}
+
+	// Lines are stacked upwards from the input line in font coordinates
+	line.text.assign(text, length);
+	line.vertices.clear();
+	gDebugFont->layoutString(text, length, 0.f, (float)(index * DebugFont::kGlyphHeight), line.vertices);
+}
 
-	// TODO: Render the text buffer
+bool VertexArrayDebugConsole::updateLines() {
+	bool changed = false;
+
+	if (mBuiltInputVersion != mInputVersion) {
+		mBuiltInputVersion = mInputVersion;
+		buildLine(0, mInputBuffer, (int)strlen(mInputBuffer));
+		changed = true;
+	}
+
+	// The text may be printed to from other threads while this runs, which just rebuilds it again next time
+	unsigned int textVersion = mTextVersion;
+	if (mBuiltTextVersion != textVersion) {
+		mBuiltTextVersion = textVersion;
+		mNumVisibleLines = getVisibleLines(mVisibleLines.data(), mNumLines - 1);
+		for (int i = 0; i < mNumVisibleLines; ++i) {
+			buildLine(i + 1, mVisibleLines[i].data(), (int)mVisibleLines[i].size());
+		}
+		changed = true;
+	}
+
+	return changed;
+}
+
+void VertexArrayDebugConsole::renderConsole() const {
+	renderBackground();
 
-	// Render the input line
+	glColor4fv((GLfloat*)&mTextColor);
+	glPushMatrix();
+	glScalef((float)mFontScale, (float)mFontScale, 1.f);
+	for (int i = 0; i <= mNumVisibleLines; ++i) {
+		auto& vertices = mLines[i].vertices;
+		gDebugFont->renderVertices(vertices.data(), (int)vertices.size());
+	}
+	glPopMatrix();
+}
+
+void VertexArrayDebugConsole::render() {
+	if (!mOpen) {
+		return;
+	}
+
+	updateLines();
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(0., mScreenWidth, 0., mScreenHeight, -1., 1.);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glTranslatef(0.f, (float)(mScreenHeight - mHeight), 0.f);
+
+	renderConsole();
+	gDebugFont->flush();
+
+	glPopMatrix();
+	glDisable(GL_BLEND);
+}
+
+#endif
+
+#if defined(DEBUG_CONSOLE_RENDER_METHOD_QUADS)
+
+void DebugConsole::render() {
+	if (!mOpen) {
+		return;
+	}
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(0., mScreenWidth, 0., mScreenHeight, -1., 1.);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glTranslatef(0.f, (float)(mScreenHeight - mHeight), 0.f);
+
+	renderBackground();
+
+	// Render the input line followed by the text buffer
 	glColor4fv((GLfloat*)&mTextColor);
 	glScalef((float)mFontScale, (float)mFontScale, 1.f);
 	// TODO: Give the debug font a size state?
 	gDebugFont->renderString(mInputBuffer);
 
+	int numVisibleLines = getVisibleLines(mVisibleLines.data(), mNumLines - 1);
+	for (int i = 0; i < numVisibleLines; ++i) {
+		glTranslatef(0.f, (float)DebugFont::kGlyphHeight, 0.f);
+		gDebugFont->renderString(mVisibleLines[i].c_str());
+	}
+	gDebugFont->flush();
+
 	glPopMatrix();
 	glDisable(GL_BLEND);
 }
 
+#elif defined(DEBUG_CONSOLE_RENDER_METHOD_VERTEX_ARRAYS)
+
+// DebugConsole renders exactly like VertexArrayDebugConsole
+
+#elif defined(DEBUG_CONSOLE_RENDER_METHOD_RENDER_TO_TEXTURE)
+
+static int nextPowerOfTwo(int n) {
+	int result = 1;
+	while (result < n) {
+		result <<= 1;
+	}
+
+	return result;
+}
+
+DebugConsole::DebugConsole(int width, int height, int screenWidth, int screenHeight, int fontScale) :
+	VertexArrayDebugConsole(width, height, screenWidth, screenHeight, fontScale),
+	mFramebuffer(0), mTexture(0),
+	mTextureWidth(nextPowerOfTwo(width)), mTextureHeight(nextPowerOfTwo(height)),
+	mTextureValid(false)
+{
+	if (!gGLExtensions.framebufferObjects) {
+		return;
+	}
+
+	glGenTextures(1, &mTexture);
+	glBindTexture(GL_TEXTURE_2D, mTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, mTextureWidth, mTextureHeight, 0, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glBindTexture(GL_TEXTURE_2D, 0);
+
+	gGLExtensions.genFramebuffers(1, &mFramebuffer);
+	gGLExtensions.bindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+	gGLExtensions.framebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, mTexture, 0);
+	if (gGLExtensions.checkFramebufferStatus(GL_FRAMEBUFFER) != GL_FRAMEBUFFER_COMPLETE) {
+		LOG_WARNING("Debug console framebuffer is incomplete, rendering directly instead");
+		gGLExtensions.deleteFramebuffers(1, &mFramebuffer);
+		glDeleteTextures(1, &mTexture);
+		mFramebuffer = 0;
+		mTexture = 0;
+	}
+	gGLExtensions.bindFramebuffer(GL_FRAMEBUFFER, 0);
+}
+
+DebugConsole::~DebugConsole() {
+	if (mFramebuffer) {
+		gGLExtensions.deleteFramebuffers(1, &mFramebuffer);
+		glDeleteTextures(1, &mTexture);
+	}
+}
+
+void DebugConsole::render() {
+	if (!mFramebuffer) {
+		VertexArrayDebugConsole::render();
+		return;
+	}
+
+	if (!mOpen) {
+		return;
+	}
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+
+	// Redraw the console into its texture only when the text changed
+	if (updateLines() || !mTextureValid) {
+		GLint viewport[4];
+		GLfloat clearColor[4];
+		glGetIntegerv(GL_VIEWPORT, viewport);
+		glGetFloatv(GL_COLOR_CLEAR_VALUE, clearColor);
+
+		gGLExtensions.bindFramebuffer(GL_FRAMEBUFFER, mFramebuffer);
+		glViewport(0, 0, mWidth, mHeight);
+		glClearColor(0.f, 0.f, 0.f, 0.f);
+		glClear(GL_COLOR_BUFFER_BIT);
+
+		glMatrixMode(GL_PROJECTION);
+		glLoadIdentity();
+		glOrtho(0., mWidth, 0., mHeight, -1., 1.);
+		glMatrixMode(GL_MODELVIEW);
+		renderConsole();
+		gDebugFont->flush();
+
+		gGLExtensions.bindFramebuffer(GL_FRAMEBUFFER, 0);
+		glViewport(viewport[0], viewport[1], viewport[2], viewport[3]);
+		glClearColor(clearColor[0], clearColor[1], clearColor[2], clearColor[3]);
+		mTextureValid = true;
+	}
+
+	// Render the console texture as one quad at the top of the screen
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(0., mScreenWidth, 0., mScreenHeight, -1., 1.);
+	glMatrixMode(GL_MODELVIEW);
+
+	float s = (float)mWidth / mTextureWidth;
+	float t = (float)mHeight / mTextureHeight;
+	int y = mScreenHeight - mHeight;
+
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, mTexture);
+	glColor4f(1.f, 1.f, 1.f, 1.f);
+	glBegin(GL_QUADS);
+	glTexCoord2f(0.f, 0.f); glVertex2i(0, y);
+	glTexCoord2f(s, 0.f); glVertex2i(mWidth, y);
+	glTexCoord2f(s, t); glVertex2i(mWidth, y + mHeight);
+	glTexCoord2f(0.f, t); glVertex2i(0, y + mHeight);
+	glEnd();
+	glDisable(GL_TEXTURE_2D);
+
+	glDisable(GL_BLEND);
+}
+
 #else
 #error No render method defined for DebugConsole
 #endif
\ No newline at end of file
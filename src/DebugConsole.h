@@ -2,13 +2,16 @@
 #define DEBUG_CONSOLE_H
 
 #include "Color.h"
+#include "DebugFont.h"
 #include <GLFW/glfw3.h>
+#include <atomic>
+#include <cstdarg>
 #include <memory>
+#include <mutex>
 #include <string>
+#include <vector>
 
-#define DEBUG_CONSOLE_RENDER_METHOD_QUADS
-
-class DebugFont;
+#define DEBUG_CONSOLE_RENDER_METHOD_RENDER_TO_TEXTURE
 
 enum DebugConsoleNavigationCharacters {
 	DEBUG_CONSOLE_HISTORY_PREVIOUS = -1,
@@ -34,13 +37,37 @@ protected:
 	int mSelectionEnd;
 	int mInputPosition;
 	int mInputLength;
-	char *mTextBuffer;
 	char *mInputBuffer;
 	Color mTextColor;
 	Color mBackgroundColor;
 	Color mCursorColor;
-	// TODO: History
 	bool mOpen;
+	std::atomic<unsigned int> mTextVersion; // Incremented whenever the scrollback or scroll position changes
+	unsigned int mInputVersion;             // Incremented whenever the input line or cursor changes
+
+	// Ring buffer of fixed length lines, guarded by mTextMutex since any thread may print
+	mutable std::mutex mTextMutex;
+	std::vector<char> mScrollback;
+	std::vector<int> mScrollbackLengths;
+	int mScrollbackStart; // Index of the oldest line
+	int mScrollbackCount;
+	int mScrollOffset;    // Number of lines scrolled up from the most recent line
+
+	// Ring buffer of entered commands
+	std::vector<std::string> mHistory;
+	int mHistoryStart;
+	int mHistoryCount;
+	int mHistoryPosition; // Number of commands back from the input line being edited
+
+	/** Renders the background and cursor in console coordinates */
+	void renderBackground() const;
+
+	/** Appends a line to the scrollback, overwriting the oldest line if full. mTextMutex must be held. */
+	void appendLine(const char* text, int length);
+
+	void addToHistory(const char* command);
+	void setInput(const char* text);
+	void scroll(int numLines);
 
 public:
 	AbstractDebugConsole(const AbstractDebugConsole&) = delete;
@@ -59,8 +86,11 @@ public:
 	/** Renders the console if it is open */
 	virtual void render() = 0;
 
-	/** Overload this method to handle commands entered into the console */
-	virtual void onCommand(const char* command) {}
+	/**
+	 * Called with each command entered into the console. By default the command is posted to
+	 * gCommands to run on the simulation thread. Overload this method to handle commands differently.
+	 */
+	virtual void onCommand(const char* command);
 
 	/** Input the specified character into the text buffer */
 	void onCharacter(char ch);
@@ -70,20 +100,32 @@ public:
 	 * Navigation characters:
 	 *   DEBUG_CONSOLE_HISTORY_PREVIOUS => Go to previous line in history
 	 *   DEBUG_CONSOLE_HISTORY_NEXT => Go to next line in history
-	 *   DEBUG_CONSOLE_CURSOR_PREVIOUS => Increment cursor
-	 *   DEBUG_CONSOLE_CURSOR_NEXT => Decrement cursor
-	 *   DEBUG_CONSOLE_PAGE_UP => Scroll the window
+	 *   DEBUG_CONSOLE_CURSOR_PREVIOUS => Decrement cursor
+	 *   DEBUG_CONSOLE_CURSOR_NEXT => Increment cursor
+	 *   DEBUG_CONSOLE_PAGE_UP => Scroll the window up a page
+	 *   DEBUG_CONSOLE_PAGE_DOWN => Scroll the window down a page
 	 */
 	void onNavigationCharacter(int ch);
 
-	/** Prints text to the console using printf syntax */
+	/**
+	 * Prints text to the console using printf syntax
+	 * Text is formatted into a fixed size buffer on the stack, split at newlines and wrapped
+	 * at the width of the console. Doesn't allocate and may be called from any thread.
+	 */
 	void print(const char* format, ...);
+	void vprint(const char* format, va_list args);
 
 	/** Selects the region of text described by a mouse click and drag start and end position */
 	void selectText(float x1, float y1, float x2, float y2);
 
 	/** Copies the selected text to the operating system's clipboard */
 	void copySelectionToClipboard();
+
+	/**
+	 * Copies the lines of the scrollback that fit above the input line, most recent first
+	 * @return the number of lines, at most maxLines
+	 */
+	int getVisibleLines(std::string* lines, int maxLines) const;
 };
 
 // TODO: C++ stream-like interface for logging
@@ -91,47 +133,87 @@ public:
 
 extern std::shared_ptr<AbstractDebugConsole> gConsole;
 
-#if defined(DEBUG_CONSOLE_RENDER_METHOD_QUADS)
+#if defined(DEBUG_CONSOLE_RENDER_METHOD_VERTEX_ARRAYS) || defined(DEBUG_CONSOLE_RENDER_METHOD_RENDER_TO_TEXTURE)
 
 /**
- * Uses immediate mode rendering
+ * Uses vertex arrays for keeping track of text
+ * Each line's vertices are only rebuilt when the text on that line changes.
  */
-class DebugConsole : public AbstractDebugConsole {
+class VertexArrayDebugConsole : public AbstractDebugConsole {
+private:
+	struct TextLine {
+		std::string text;
+		std::vector<DebugFont::Vertex> vertices;
+	};
+
+	std::vector<TextLine> mLines; // The input line followed by the visible text lines
+	std::vector<std::string> mVisibleLines;
+	int mNumVisibleLines;
+	unsigned int mBuiltTextVersion;
+	unsigned int mBuiltInputVersion;
+
+	void buildLine(int index, const char* text, int length);
+
+protected:
+	/** Rebuilds the vertices of lines that changed. Returns true if anything changed. */
+	bool updateLines();
+
+	/** Renders the whole console in console coordinates */
+	void renderConsole() const;
+
 public:
-	DebugConsole(int width, int height, int screenWidth, int screenHeight, int fontScale = 1) :
-		AbstractDebugConsole(width, height, screenWidth, screenHeight, fontScale) {}
+	VertexArrayDebugConsole(int width, int height, int screenWidth, int screenHeight, int fontScale);
 
 	void render() override;
 };
 
-#elif defined(DEBUG_CONSOLE_RENDER_METHOD_VERTEX_ARRAYS)
+#endif
+
+#if defined(DEBUG_CONSOLE_RENDER_METHOD_QUADS)
 
 /**
- * Uses vertex arrays for keeping track of text
+ * Uses immediate mode rendering
  */
 class DebugConsole : public AbstractDebugConsole {
 private:
-	struct Vertex {
-		float x, y;
-		float s, t;
-	};
+	std::vector<std::string> mVisibleLines;
 
-	struct TextLine {
-		U32 length;
-		const char* text;
-		Vertex* vertices;
-	};
+public:
+	DebugConsole(int width, int height, int screenWidth, int screenHeight, int fontScale = 1) :
+		AbstractDebugConsole(width, height, screenWidth, screenHeight, fontScale),
+		mVisibleLines(mNumLines) {}
+
+	void render() override;
+};
+
+#elif defined(DEBUG_CONSOLE_RENDER_METHOD_VERTEX_ARRAYS)
 
-	TextLine* mLines;
-	Vertex* mVertices;
+class DebugConsole : public VertexArrayDebugConsole {
+public:
+	DebugConsole(int width, int height, int screenWidth, int screenHeight, int fontScale = 1) :
+		VertexArrayDebugConsole(width, height, screenWidth, screenHeight, fontScale) {}
 };
 
 #elif defined(DEBUG_CONSOLE_RENDER_METHOD_RENDER_TO_TEXTURE)
 
 /**
-* Renders text to a texture to render entire console by using one quad
-*/
-class DebugConsole : public AbstractDebugConsole {
+ * Renders text to a texture to render entire console by using one quad
+ * The texture is only redrawn when the text changes. Falls back to rendering the vertex
+ * arrays directly if framebuffer objects are unsupported.
+ */
+class DebugConsole : public VertexArrayDebugConsole {
+private:
+	GLuint mFramebuffer;
+	GLuint mTexture;
+	int mTextureWidth;
+	int mTextureHeight;
+	bool mTextureValid;
+
+public:
+	DebugConsole(int width, int height, int screenWidth, int screenHeight, int fontScale = 1);
+	~DebugConsole();
+
+	void render() override;
 };
 
 #endif // DEBUG_CONSOLE_RENDER_METHOD
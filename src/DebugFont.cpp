@@ -1,25 +1,27 @@
 #include "DebugFont.h"
+#include "Log.h"
 #include "Vector.h"
 #include <soil/SOIL.h>
-#include <iostream>
+#include <cstddef>
 
 using namespace std;
 
 shared_ptr<DebugFont> gDebugFont;
 
+static const size_t kMaxCachedLayouts = 1024;
+
 DebugFont::DebugFont() {
-	mTexture = SOIL_load_OGL_texture("data/DebugFont7x9.png", SOIL_LOAD_AUTO, SOIL_CREATE_NEW_ID, SOIL_FLAG_INVERT_Y | SOIL_FLAG_MULTIPLY_ALPHA);
-	if (!mTexture) {
-		cout << "Failed to load debug font" << endl;
+	auto image = gAssets->getImage("data/DebugFont7x9.png");
+	if (image) {
+		mImage = *image;
+	} else {
+		LOG_ERROR("Failed to load debug font");
+		AtlasImage missing = {0, kTextureWidth, kTextureHeight, 0.f, 0.f, 1.f, 1.f};
+		mImage = missing;
 	}
-
-	glBindTexture(GL_TEXTURE_2D, mTexture);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_NEAREST);
-	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_NEAREST);
 }
 
 DebugFont::~DebugFont() {
-	glDeleteTextures(1, &mTexture);
 }
 
 Vec2 getStringDimensions(const char* str) {
@@ -39,60 +41,160 @@ Vec2 getStringDimensions(const char* str) {
 	return Vec2((float)glyphsX * DebugFont::kGlyphWidth, (float)glyphsY * DebugFont::kGlyphHeight);
 }
 
-void DebugFont::renderString(const char* str, bool centerHorizontal) {
-	glEnable(GL_TEXTURE_2D);
-	glBindTexture(GL_TEXTURE_2D, mTexture);
+void DebugFont::renderString(const char* str, bool centerHorizontal, float scale) {
+	// Reuse the lookup key's storage so that finding a cached layout doesn't allocate
+	mLookupKey.text.assign(str);
+	mLookupKey.scale = scale;
+	mLookupKey.centerHorizontal = centerHorizontal;
+
+	auto layout = mLayouts.find(mLookupKey);
+	if (layout != mLayouts.end()) {
+		mLayoutUses.splice(mLayoutUses.begin(), mLayoutUses, layout->second.use);
+	} else {
+		// Strings that change every frame would grow the cache forever, so forget the layout
+		// that was used least recently
+		if (mLayouts.size() >= kMaxCachedLayouts) {
+			mLayouts.erase(mLayouts.find(*mLayoutUses.back()));
+			mLayoutUses.pop_back();
+		}
+
+		float x = centerHorizontal ? -getStringDimensions(str).x / 2.f : 0.f;
+
+		Layout newLayout;
+		layoutString(str, (int)mLookupKey.text.size(), x, 0.f, newLayout.vertices);
+		for (auto& vertex : newLayout.vertices) {
+			vertex.x *= scale;
+			vertex.y *= scale;
+		}
 
-	if (centerHorizontal) {
-		auto dimensions = getStringDimensions(str);
-		glPushMatrix();
-		glTranslatef(-dimensions.x / 2.f, 0.f, 0.f);
+		layout = mLayouts.emplace(mLookupKey, move(newLayout)).first;
+		mLayoutUses.push_front(&layout->first);
+		layout->second.use = mLayoutUses.begin();
 	}
 
-	// Render each character as a quad
-	glBegin(GL_QUADS);
+	auto& vertices = layout->second.vertices;
+	renderVertices(vertices.data(), (int)vertices.size());
+}
 
-	float currentX = 0.f;
-	float currentY = 0.f; // TODO: make this a parameter
+void DebugFont::layoutString(const char* str, int length, float x, float y, vector<Vertex>& vertices) const {
+	float currentX = x;
+	float currentY = y;
 
-	for (; *str; ++str) {
+	for (auto end = str + length; str != end; ++str) {
 		if (*str == '\t') {
-			// Render as 4 spaces
 			currentX += kGlyphWidth * kSpacesPerTab;
 			continue;
 		} else if (*str == '\n') {
-			// Move to beginning of next line
-			currentX = 0.f;
+			currentX = x;
 			currentY -= kGlyphHeight;
 			continue;
 		} else if (*str > '~' || *str < '!') {
-			// Render as space
 			currentX += kGlyphWidth;
 			continue;
 		}
 
 		int glyphIndex = *str - '!';
-		
+
 		int glyphX = glyphIndex % kGlyphsX;
 		int glyphY = glyphIndex / kGlyphsX;
-		float s1 = (float)(glyphX * kGlyphWidth) / kTextureWidth;
-		float s2 = (float)((glyphX + 1) * kGlyphWidth) / kTextureWidth;
-		float t1 = (float)(glyphY * kGlyphHeight) / kTextureHeight;
-		float t2 = (float)((glyphY + 1) * kGlyphHeight) / kTextureHeight;
-
-		glTexCoord2f(s1, t1); glVertex2f(currentX, currentY);
-		glTexCoord2f(s2, t1); glVertex2f(currentX + kGlyphWidth, currentY);
-		glTexCoord2f(s2, t2); glVertex2f(currentX + kGlyphWidth, currentY + kGlyphHeight);
-		glTexCoord2f(s1, t2); glVertex2f(currentX, currentY + kGlyphHeight);
+		// Map from texels of the font image to its place in the atlas
+		float texelS = (mImage.s2 - mImage.s1) / kTextureWidth;
+		float texelT = (mImage.t2 - mImage.t1) / kTextureHeight;
+		float s1 = mImage.s1 + glyphX * kGlyphWidth * texelS;
+		float s2 = mImage.s1 + (glyphX + 1) * kGlyphWidth * texelS;
+		float t1 = mImage.t1 + glyphY * kGlyphHeight * texelT;
+		float t2 = mImage.t1 + (glyphY + 1) * kGlyphHeight * texelT;
+
+		Vertex quad[] = {
+			{currentX, currentY, s1, t1},
+			{currentX + kGlyphWidth, currentY, s2, t1},
+			{currentX + kGlyphWidth, currentY + kGlyphHeight, s2, t2},
+			{currentX, currentY + kGlyphHeight, s1, t2}
+		};
+		vertices.insert(vertices.end(), quad, quad + 4);
 
 		currentX += kGlyphWidth;
 	}
-	
-	glEnd();
-	
-	if (centerHorizontal) {
-		glPopMatrix();
+}
+
+void DebugFont::renderVertices(const Vertex* vertices, int numVertices) {
+	if (numVertices == 0) {
+		return;
 	}
 
+	// Transform to clip coordinates now, so the batch doesn't depend on later matrix changes
+	GLfloat modelView[16];
+	GLfloat projection[16];
+	Color color;
+	glGetFloatv(GL_MODELVIEW_MATRIX, modelView);
+	glGetFloatv(GL_PROJECTION_MATRIX, projection);
+	glGetFloatv(GL_CURRENT_COLOR, (GLfloat*)&color);
+
+	// Column major: transform = projection * modelView
+	GLfloat transform[16];
+	for (int column = 0; column < 4; ++column) {
+		for (int row = 0; row < 4; ++row) {
+			float sum = 0.f;
+			for (int i = 0; i < 4; ++i) {
+				sum += projection[i * 4 + row] * modelView[column * 4 + i];
+			}
+			transform[column * 4 + row] = sum;
+		}
+	}
+
+	size_t first = mBatch.size();
+	mBatch.resize(first + numVertices);
+	auto batchVertex = &mBatch[first];
+
+	for (auto end = vertices + numVertices; vertices != end; ++vertices, ++batchVertex) {
+		float x = vertices->x;
+		float y = vertices->y;
+		batchVertex->x = transform[0] * x + transform[4] * y + transform[12];
+		batchVertex->y = transform[1] * x + transform[5] * y + transform[13];
+		batchVertex->z = transform[2] * x + transform[6] * y + transform[14];
+		batchVertex->w = transform[3] * x + transform[7] * y + transform[15];
+		batchVertex->s = vertices->s;
+		batchVertex->t = vertices->t;
+		batchVertex->color = color;
+	}
+}
+
+void DebugFont::flush() {
+	if (mBatch.empty()) {
+		return;
+	}
+
+	glMatrixMode(GL_PROJECTION);
+	glPushMatrix();
+	glLoadIdentity();
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	glEnable(GL_TEXTURE_2D);
+	glBindTexture(GL_TEXTURE_2D, mImage.texture);
+
+	const char* vertices = (const char*)mBatch.data();
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(4, GL_FLOAT, sizeof(BatchVertex), vertices + offsetof(BatchVertex, x));
+	glTexCoordPointer(2, GL_FLOAT, sizeof(BatchVertex), vertices + offsetof(BatchVertex, s));
+	glColorPointer(4, GL_FLOAT, sizeof(BatchVertex), vertices + offsetof(BatchVertex, color));
+	glDrawArrays(GL_QUADS, 0, (GLsizei)mBatch.size());
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
 	glDisable(GL_TEXTURE_2D);
-}
\ No newline at end of file
+	glDisable(GL_BLEND);
+
+	glMatrixMode(GL_PROJECTION);
+	glPopMatrix();
+	glMatrixMode(GL_MODELVIEW);
+	glPopMatrix();
+
+	mBatch.clear();
+}
@@ -1,15 +1,25 @@
 #ifndef DEBUG_FONT_H
 #define DEBUG_FONT_H
 
+#include "AssetCache.h"
+#include "Color.h"
 #include <GLFW/glfw3.h>
+#include <list>
 #include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
 
+/**
+ * Renders text from a fixed size bitmap font.
+ *
+ * Text is not drawn immediately. Each string is transformed by the current matrices and
+ * color and appended to a batch that flush() draws with a single draw call, so flush()
+ * must be called before anything that should appear on top of the text and at the end
+ * of each frame. The glyph layouts of the most recently rendered strings are cached between frames.
+ * The font image is loaded through gAssets, which must outlive the font.
+ */
 class DebugFont {
-private:
-	GLuint mTexture;
-	int mScreenWidth;
-	int mScreenHeight;
-
 public:
 	static const int kTextureWidth = 128;
 	static const int kTextureHeight = 64;
@@ -19,13 +29,62 @@ public:
 	static const int kGlyphsY = 6;
 	static const int kSpacesPerTab = 4;
 
+	struct Vertex {
+		float x, y;
+		float s, t;
+	};
+
+private:
+	struct LayoutKey {
+		std::string text;
+		float scale;
+		bool centerHorizontal;
+
+		bool operator==(const LayoutKey& other) const {
+			return scale == other.scale && centerHorizontal == other.centerHorizontal && text == other.text;
+		}
+	};
+
+	struct LayoutKeyHash {
+		size_t operator()(const LayoutKey& key) const {
+			return std::hash<std::string>()(key.text) ^ std::hash<float>()(key.scale) ^ key.centerHorizontal;
+		}
+	};
+
+	struct BatchVertex {
+		float x, y, z, w; // Clip coordinates
+		float s, t;
+		Color color;
+	};
+
+	struct Layout {
+		std::vector<Vertex> vertices;
+		std::list<const LayoutKey*>::iterator use; // Where the layout is in mLayoutUses
+	};
+
+	AtlasImage mImage;
+	std::unordered_map<LayoutKey, Layout, LayoutKeyHash> mLayouts;
+	std::list<const LayoutKey*> mLayoutUses; // The keys of mLayouts, most recently used first
+	LayoutKey mLookupKey;
+	std::vector<BatchVertex> mBatch;
+
+public:
 	DebugFont();
 
 	~DebugFont();
 
-	void renderString(const char* str, bool centerHorizontal = false);
+	void renderString(const char* str, bool centerHorizontal = false, float scale = 1.f);
+
+	/** Appends a quad for each glyph of the first length characters of str, starting at (x, y) */
+	void layoutString(const char* str, int length, float x, float y, std::vector<Vertex>& vertices) const;
+
+	/** Renders quads from layoutString using the current color and transform */
+	void renderVertices(const Vertex* vertices, int numVertices);
+
+	/** Draws all the text rendered since the last flush */
+	void flush();
 };
 
 extern std::shared_ptr<DebugFont> gDebugFont;
 
-#endif
\ No newline at end of file
+#endif
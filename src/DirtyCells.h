@@ -0,0 +1,49 @@
+#ifndef DIRTY_CELLS_H
+#define DIRTY_CELLS_H
+
+#include <cstdint>
+#include <vector>
+
+/**
+ * Set of grid cell indices that changed, in the order they were first marked.
+ * A bitset makes marking idempotent and clearing only touches the marked cells,
+ * so the cost of both is independent of the size of the grid.
+ */
+class DirtyCells {
+private:
+	std::vector<uint64_t> mBits;
+	std::vector<int> mIndices;
+
+public:
+	void resize(int numCells) {
+		clear();
+		mBits.assign((numCells + 63) / 64, 0);
+	}
+
+	bool isEmpty() const { return mIndices.empty(); }
+
+	bool isDirty(int index) const {
+		return (mBits[index / 64] >> (index % 64) & 1) != 0;
+	}
+
+	void mark(int index) {
+		auto& word = mBits[index / 64];
+		uint64_t bit = 1ULL << (index % 64);
+		if (!(word & bit)) {
+			word |= bit;
+			mIndices.push_back(index);
+		}
+	}
+
+	const std::vector<int>& getIndices() const { return mIndices; }
+
+	void clear() {
+		for (auto index : mIndices) {
+			mBits[index / 64] = 0;
+		}
+
+		mIndices.clear();
+	}
+};
+
+#endif
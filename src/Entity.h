@@ -1,6 +1,7 @@
 #ifndef ENTITY_H
 #define ENTITY_H
 
+#include "SlotMap.h"
 #include "Vector.h"
 #include <memory>
 
@@ -16,9 +17,12 @@ enum EntityType {
 	ENTITY_WALL
 };
 
+/** Stays invalid once its entity is destroyed, so it's safe to hold on to or send over the network */
+typedef SlotHandle EntityHandle;
+
 class Entity {
 private:
-	int mEntityId;
+	EntityHandle mHandle;
 	EntityType mEntityType;
 
 public:
@@ -33,10 +37,10 @@ private:
 	Entity(Entity&&) = delete;
 
 public:
-	Entity(int id, EntityType type) :
-		mEntityId(id), mEntityType(type), active(true) {}
+	Entity(EntityHandle handle, EntityType type) :
+		mHandle(handle), mEntityType(type), active(true) {}
 
-	int getEntityId() const { return mEntityId; }
+	EntityHandle getHandle() const { return mHandle; }
 	EntityType getType() const { return mEntityType; }
 };
 
@@ -1,5 +1,9 @@
 #include "FillRules.h"
 
+#include <algorithm>
+
+using namespace std;
+
 static const struct DirectionInfo {
 	int dxNext, dyNext;
 	int dxWall, dyWall;
@@ -116,11 +120,7 @@ void EmptyRectanglesFillRule::fillEmptyRegions(int x, int y, int playerId) {
 			// The region in this direction is a rectangle
 			if (isRegionEmpty(left, bottom, right, top)) {
 				// The region in this direction is empty, so fill it
-				for (int i = left; i <= right; ++i) {
-					for (int j = bottom; j <= top; ++j) {
-						mGame.createWall(i, j, playerId);
-					}
-				}
+				mGame.fillRect(left, bottom, right, top, playerId);
 			}
 		}
 	}
@@ -141,8 +141,7 @@ void EmptyRectanglesFillRule::onInit() {
 	}
 }
 
-void EmptyRectanglesFillRule::onWallCreated(int x, int y) {
-	// Update the cells to the left
+void EmptyRectanglesFillRule::updateCellsLeftOf(int x, int y) {
 	for (int i = x - 1; i >= 0; --i) {
 		auto& cell = getCellAt(i, y);
 		cell.nextWallX = x - i;
@@ -151,8 +150,9 @@ void EmptyRectanglesFillRule::onWallCreated(int x, int y) {
 			break;
 		}
 	}
+}
 
-	// Update the cells below
+void EmptyRectanglesFillRule::updateCellsBelow(int x, int y) {
 	for (int j = y - 1; j >= 0; --j) {
 		auto& cell = getCellAt(x, j);
 		cell.nextWallY = y - j;
@@ -163,11 +163,50 @@ void EmptyRectanglesFillRule::onWallCreated(int x, int y) {
 	}
 }
 
+void EmptyRectanglesFillRule::onWallCreated(int x, int y) {
+	updateCellsLeftOf(x, y);
+	updateCellsBelow(x, y);
+}
+
+void EmptyRectanglesFillRule::onRectFilled(int left, int bottom, int right, int top) {
+	// Inside the rectangle the next wall is now the neighbouring cell, except from the right and
+	// top edges, whose distances to the walls beyond the rectangle haven't changed
+	for (int j = bottom; j <= top; ++j) {
+		for (int i = left; i <= right; ++i) {
+			auto& cell = getCellAt(i, j);
+			if (i < right) {
+				cell.nextWallX = 1;
+			}
+
+			if (j < top) {
+				cell.nextWallY = 1;
+			}
+		}
+	}
+
+	// Outside it, only the cells up to the next wall to the left of and below the rectangle change
+	for (int j = bottom; j <= top; ++j) {
+		updateCellsLeftOf(left, j);
+	}
+
+	for (int i = left; i <= right; ++i) {
+		updateCellsBelow(i, bottom);
+	}
+}
+
 void EmptyRectanglesFillRule::onWallCompleted(int x, int y) {
 	auto playerId = mGame.getWallAt(x, y)->getPlayerId();
 	fillEmptyRegions(x, y, playerId);
 }
 
+void EmptyRectanglesFillRule::onWallMoved(int fromX, int fromY, int toX, int toY) {
+	// A wall that is still rising fills the regions it closes once it completes
+	auto wall = mGame.getWallAt(toX, toY);
+	if (wall && wall->isComplete()) {
+		fillEmptyRegions(toX, toY, wall->getPlayerId());
+	}
+}
+
 void EmptyRectanglesFillRule::onWallDestroyed(int x, int y) {
 	auto& cell = getCellAt(x, y);
 
@@ -190,4 +229,57 @@ void EmptyRectanglesFillRule::onWallDestroyed(int x, int y) {
 			break;
 		}
 	}
-}
\ No newline at end of file
+}
+
+void EmptyRectanglesFillRule::onCellsChanged(const vector<int>& indices) {
+	int width = mGame.getWidth();
+	int height = mGame.getHeight();
+
+	// Each row is recomputed from its rightmost changed cell leftwards, until the first wall to the
+	// left of its leftmost changed cell. The indices are sorted, so each row's cells are adjacent.
+	for (size_t first = 0; first < indices.size();) {
+		int y = indices[first] / width;
+		size_t last = first;
+		while (last + 1 < indices.size() && indices[last + 1] / width == y) {
+			++last;
+		}
+
+		int minX = indices[first] % width;
+		for (int i = indices[last] % width; i >= 0; --i) {
+			auto& cell = getCellAt(i, y);
+			cell.nextWallX = (i + 1 == width || mGame.getWallAt(i + 1, y)) ? 1 : getCellAt(i + 1, y).nextWallX + 1;
+			if (i < minX && mGame.getWallAt(i, y)) {
+				break;
+			}
+		}
+
+		first = last + 1;
+	}
+
+	// Likewise for each column, from its topmost changed cell downwards
+	vector<int> columns(indices.size());
+	for (size_t k = 0; k < indices.size(); ++k) {
+		int index = indices[k];
+		columns[k] = index % width * height + index / width;
+	}
+
+	sort(columns.begin(), columns.end());
+	for (size_t first = 0; first < columns.size();) {
+		int x = columns[first] / height;
+		size_t last = first;
+		while (last + 1 < columns.size() && columns[last + 1] / height == x) {
+			++last;
+		}
+
+		int minY = columns[first] % height;
+		for (int j = columns[last] % height; j >= 0; --j) {
+			auto& cell = getCellAt(x, j);
+			cell.nextWallY = (j + 1 == height || mGame.getWallAt(x, j + 1)) ? 1 : getCellAt(x, j + 1).nextWallY + 1;
+			if (j < minY && mGame.getWallAt(x, j)) {
+				break;
+			}
+		}
+
+		first = last + 1;
+	}
+}
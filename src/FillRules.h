@@ -9,11 +9,18 @@ public:
 
 	virtual void onWallCreated(int x, int y) = 0;
 
+	/** Called once every cell in the rectangle is a wall, instead of onWallCreated for each new one */
+	virtual void onRectFilled(int left, int bottom, int right, int top) = 0;
+
 	virtual void onWallCompleted(int x, int y) = 0;
 
 	virtual void onWallDestroyed(int x, int y) = 0;
 
+	/** Called by Game::apply() after onCellsChanged(), for each wall the transaction moved */
 	virtual void onWallMoved(int fromX, int fromY, int toX, int toY) = 0;
+
+	/** Called once for a transaction applied by Game::apply(), with the sorted indices of the cells it changed */
+	virtual void onCellsChanged(const std::vector<int>& indices) = 0;
 };
 
 class EmptyRectanglesFillRule : public IFillRule {
@@ -31,6 +38,9 @@ private:
 		return mCells[x + y * mGame.getWidth()];
 	}
 
+	void updateCellsLeftOf(int x, int y);
+	void updateCellsBelow(int x, int y);
+
 	bool isEdgeContiguous(int& x, int& y, int directionIndex);
 	bool getRectangularRegion(int x, int y, int initialDirectionIndex, int& left, int& bottom, int& right, int& top);
 	bool isRegionEmpty(int left, int bottom, int right, int top);
@@ -43,11 +53,15 @@ public:
 
 	void onWallCreated(int x, int y) override;
 
+	void onRectFilled(int left, int bottom, int right, int top) override;
+
 	void onWallCompleted(int x, int y) override;
 
 	void onWallDestroyed(int x, int y) override;
 
-	void onWallMoved(int fromX, int fromY, int toX, int toY) override {}
+	void onWallMoved(int fromX, int fromY, int toX, int toY) override;
+
+	void onCellsChanged(const std::vector<int>& indices) override;
 };
 
 #endif
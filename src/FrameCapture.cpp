@@ -0,0 +1,234 @@
+#include "FrameCapture.h"
+
+#include "GLExtensions.h"
+#include "Log.h"
+#include "WorkerPool.h"
+#include <soil/SOIL.h>
+#include <cstdio>
+#include <cstring>
+
+#ifndef GL_SYNC_FLUSH_COMMANDS_BIT
+#define GL_SYNC_FLUSH_COMMANDS_BIT 0x00000001
+#endif
+
+using namespace std;
+
+shared_ptr<FrameCapture> gFrameCapture;
+
+static const unsigned long long kWaitTimeout = 1000000000ull; // Nanoseconds
+
+static bool hasExtension(const string& path, const char* extension) {
+	size_t length = strlen(extension);
+	return path.size() >= length && path.compare(path.size() - length, length, extension) == 0;
+}
+
+/** Flips the rows, which are read bottom up, drops the alpha of the back buffer and saves the frame */
+static void save(const vector<unsigned char>& pixels, int width, int height, const string& path) {
+	vector<unsigned char> rgb((size_t)width * height * 3);
+	for (int y = 0; y < height; ++y) {
+		auto source = &pixels[(size_t)(height - 1 - y) * width * 4];
+		auto destination = &rgb[(size_t)y * width * 3];
+		for (int x = 0; x < width; ++x) {
+			destination[x * 3] = source[x * 4];
+			destination[x * 3 + 1] = source[x * 4 + 1];
+			destination[x * 3 + 2] = source[x * 4 + 2];
+		}
+	}
+
+	int type = SOIL_SAVE_TYPE_TGA;
+	if (hasExtension(path, ".bmp")) {
+		type = SOIL_SAVE_TYPE_BMP;
+	} else if (hasExtension(path, ".dds")) {
+		type = SOIL_SAVE_TYPE_DDS;
+	}
+
+	if (!SOIL_save_image(path.c_str(), type, width, height, 3, rgb.data())) {
+		LOG_ERROR("Failed to save %s: %s", path.c_str(), SOIL_last_result());
+	}
+}
+
+FrameCapture::FrameCapture() :
+	mNextReadback(0),
+	mAsync(gGLExtensions.pixelBufferObjects && gGLExtensions.syncObjects),
+	mNumRecorded(0),
+	mNumDropped(0),
+	mPendingEncodes(make_shared<atomic<int>>(0))
+{
+	for (auto& readback : mReadbacks) {
+		readback.buffer = 0;
+		readback.fence = nullptr;
+		readback.width = 0;
+		readback.height = 0;
+		if (mAsync) {
+			gGLExtensions.genBuffers(1, &readback.buffer);
+		}
+	}
+}
+
+FrameCapture::~FrameCapture() {
+	finishReadbacks(true);
+	for (auto& readback : mReadbacks) {
+		if (mAsync) {
+			gGLExtensions.deleteBuffers(1, &readback.buffer);
+		}
+	}
+}
+
+void FrameCapture::requestScreenshot(const string& path) {
+	lock_guard<mutex> lock(mMutex);
+	mScreenshotPath = path;
+}
+
+void FrameCapture::startRecording(const string& prefix) {
+	lock_guard<mutex> lock(mMutex);
+	mRecordingPrefix = prefix;
+	mNumRecorded = 0;
+	mNumDropped = 0;
+}
+
+void FrameCapture::stopRecording(int& numRecorded, int& numDropped) {
+	lock_guard<mutex> lock(mMutex);
+	mRecordingPrefix.clear();
+	numRecorded = mNumRecorded;
+	numDropped = mNumDropped;
+}
+
+bool FrameCapture::isRecording() {
+	lock_guard<mutex> lock(mMutex);
+	return !mRecordingPrefix.empty();
+}
+
+string FrameCapture::takeRequest(bool& recording) {
+	lock_guard<mutex> lock(mMutex);
+	recording = false;
+	if (!mScreenshotPath.empty()) {
+		string path = move(mScreenshotPath);
+		mScreenshotPath.clear();
+		return path;
+	}
+
+	if (!mRecordingPrefix.empty()) {
+		char number[16];
+		snprintf(number, sizeof(number), "-%05d.tga", mNumRecorded);
+		recording = true;
+		return mRecordingPrefix + number;
+	}
+
+	return string();
+}
+
+void FrameCapture::update(int width, int height) {
+	finishReadbacks(false);
+
+	bool recording;
+	auto path = takeRequest(recording);
+	if (path.empty() || width <= 0 || height <= 0) {
+		return;
+	}
+
+	bool started = read(width, height, path);
+
+	lock_guard<mutex> lock(mMutex);
+	if (!recording) {
+		// Try again next frame, unless another screenshot was requested meanwhile
+		if (!started && mScreenshotPath.empty()) {
+			mScreenshotPath = path;
+		}
+	} else if (started) {
+		++mNumRecorded;
+	} else {
+		++mNumDropped;
+	}
+}
+
+bool FrameCapture::read(int width, int height, const string& path) {
+	// Drop frames rather than queue them faster than they can be saved
+	if (*mPendingEncodes >= kMaxPendingEncodes) {
+		return false;
+	}
+
+	if (!mAsync) {
+		vector<unsigned char> pixels((size_t)width * height * 4);
+		glPixelStorei(GL_PACK_ALIGNMENT, 1);
+		glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, pixels.data());
+		glPixelStorei(GL_PACK_ALIGNMENT, 4);
+		encode(move(pixels), width, height, path);
+		return true;
+	}
+
+	auto& readback = mReadbacks[mNextReadback];
+	if (readback.fence) {
+		return false;
+	}
+
+	mNextReadback = (mNextReadback + 1) % kNumReadbacks;
+	gGLExtensions.bindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+	gGLExtensions.bufferData(GL_PIXEL_PACK_BUFFER, (ptrdiff_t)width * height * 4, nullptr, GL_STREAM_READ);
+	glPixelStorei(GL_PACK_ALIGNMENT, 1);
+	glReadPixels(0, 0, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	glPixelStorei(GL_PACK_ALIGNMENT, 4);
+	gGLExtensions.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+
+	readback.fence = gGLExtensions.fenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0);
+	readback.width = width;
+	readback.height = height;
+	readback.path = path;
+	return true;
+}
+
+void FrameCapture::finishReadbacks(bool wait) {
+	// Oldest first
+	for (int i = 0; i < kNumReadbacks; ++i) {
+		auto& readback = mReadbacks[(mNextReadback + i) % kNumReadbacks];
+		if (!readback.fence) {
+			continue;
+		}
+
+		// Waiting needs a flush, or the fence may never be reached
+		auto status = wait
+			? gGLExtensions.clientWaitSync(readback.fence, GL_SYNC_FLUSH_COMMANDS_BIT, kWaitTimeout)
+			: gGLExtensions.clientWaitSync(readback.fence, 0, 0);
+		bool signaled = status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+		if (!signaled && !wait) {
+			continue;
+		}
+
+		gGLExtensions.deleteSync(readback.fence);
+		readback.fence = nullptr;
+		if (!signaled) {
+			LOG_ERROR("Timed out reading back %s", readback.path.c_str());
+			continue;
+		}
+
+		vector<unsigned char> pixels((size_t)readback.width * readback.height * 4);
+		gGLExtensions.bindBuffer(GL_PIXEL_PACK_BUFFER, readback.buffer);
+		auto mapped = gGLExtensions.mapBuffer(GL_PIXEL_PACK_BUFFER, GL_READ_ONLY);
+		bool copied = mapped != nullptr;
+		if (mapped) {
+			memcpy(pixels.data(), mapped, pixels.size());
+			copied = gGLExtensions.unmapBuffer(GL_PIXEL_PACK_BUFFER) == GL_TRUE;
+		}
+
+		gGLExtensions.bindBuffer(GL_PIXEL_PACK_BUFFER, 0);
+		if (copied) {
+			encode(move(pixels), readback.width, readback.height, readback.path);
+		} else {
+			LOG_ERROR("Failed to map the readback of %s", readback.path.c_str());
+		}
+	}
+}
+
+void FrameCapture::encode(vector<unsigned char> pixels, int width, int height, const string& path) {
+	if (!gWorkers) {
+		save(pixels, width, height, path);
+		return;
+	}
+
+	auto shared = make_shared<vector<unsigned char>>(move(pixels));
+	auto pending = mPendingEncodes;
+	++*pending;
+	gWorkers->post([shared, width, height, path, pending]() {
+		save(*shared, width, height, path);
+		--*pending;
+	});
+}
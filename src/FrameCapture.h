@@ -0,0 +1,85 @@
+#ifndef FRAME_CAPTURE_H
+#define FRAME_CAPTURE_H
+
+#include <GLFW/glfw3.h>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+/**
+ * Saves screenshots, or every frame while recording, without stalling the frame
+ *
+ * A frame is read back into one of two pixel buffers and a fence is placed after the read, so
+ * glReadPixels returns at once and the GPU copies the frame while the next one is drawn. Once
+ * the fence has passed, usually a frame later, the pixels are copied out of the buffer and a
+ * worker flips and encodes them. Frames that arrive while both buffers are still being read, or
+ * while too many frames wait to be encoded, are dropped rather than waited for.
+ * Without pixel buffers or fences the frame is read synchronously, but is still encoded by a worker.
+ *
+ * Files are saved as TGA, or as BMP or DDS if the path ends in .bmp or .dds.
+ * The requests can be made from any thread, update() must be called by the rendering thread.
+ */
+class FrameCapture {
+private:
+	static const int kNumReadbacks = 2;
+	static const int kMaxPendingEncodes = 8;
+
+	struct Readback {
+		GLuint buffer;
+		void* fence; // Null if the buffer is free
+		int width, height;
+		std::string path;
+	};
+
+	Readback mReadbacks[kNumReadbacks];
+	int mNextReadback;
+	bool mAsync;
+
+	std::mutex mMutex;
+	std::string mScreenshotPath; // Saved on the next update, if not empty
+	std::string mRecordingPrefix; // Each frame is saved with this prefix, if not empty
+	int mNumRecorded;
+	int mNumDropped;
+
+	std::shared_ptr<std::atomic<int>> mPendingEncodes; // Shared with the jobs so that they can outlive the capture
+
+	FrameCapture(const FrameCapture&) = delete;
+	FrameCapture(FrameCapture&&) = delete;
+
+	/** Returns the path to save this frame to, or an empty path if the frame isn't wanted */
+	std::string takeRequest(bool& recording);
+
+	/** Starts reading the frame. Returns false if it had to be dropped. */
+	bool read(int width, int height, const std::string& path);
+
+	/** Copies out and encodes the readbacks whose fences have passed, waiting for all of them if wait is set */
+	void finishReadbacks(bool wait);
+
+	void encode(std::vector<unsigned char> pixels, int width, int height, const std::string& path);
+
+public:
+	FrameCapture();
+
+	/** Finishes the frames being read. The rendering context must still be current. */
+	~FrameCapture();
+
+	/** Saves the next frame, e.g. to screenshot.tga */
+	void requestScreenshot(const std::string& path);
+
+	/** Saves every frame as prefix-00000.tga, prefix-00001.tga, etc. until stopped */
+	void startRecording(const std::string& prefix);
+
+	/** Stops recording and returns how many frames were saved and dropped */
+	void stopRecording(int& numRecorded, int& numDropped);
+
+	bool isRecording();
+
+	/** Reads the back buffer if a frame was requested. Call after rendering the frame, before swapping. */
+	void update(int width, int height);
+};
+
+extern std::shared_ptr<FrameCapture> gFrameCapture;
+
+#endif
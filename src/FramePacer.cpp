@@ -0,0 +1,76 @@
+#include "FramePacer.h"
+
+#include <GLFW/glfw3.h>
+#include <chrono>
+#include <thread>
+
+using namespace std;
+
+static const double kSpinTime = 0.001; // Sleeps can overshoot by about this much
+static const double kLowLatencyMargin = 0.002;
+static const double kCostSmoothing = 0.1;
+
+FramePacer::FramePacer() :
+	mInterval(0.),
+	mDeadline(0.),
+	mWorkStart(0.),
+	mAverageCost(0.),
+	mLowLatency(false),
+	mSyncToPresent(false)
+{
+}
+
+void FramePacer::setInterval(double interval) {
+	mInterval = interval;
+	mDeadline = glfwGetTime() + interval;
+}
+
+void FramePacer::wait() {
+	if (mInterval > 0.) {
+		// Normally start as soon as the previous frame's deadline passes, but in low latency
+		// mode start just early enough to finish the work by this frame's deadline
+		double startTime = mDeadline - mInterval;
+		if (mLowLatency) {
+			startTime = mDeadline - mAverageCost - kLowLatencyMargin;
+		}
+
+		// Only the frame that's presented is worth a core spinning for its deadline
+		sleepUntil(startTime, true);
+	}
+
+	mWorkStart = glfwGetTime();
+}
+
+void FramePacer::endWork() {
+	double now = glfwGetTime();
+	mAverageCost += (now - mWorkStart - mAverageCost) * kCostSmoothing;
+
+	if (mInterval > 0. && !mSyncToPresent) {
+		mDeadline += mInterval;
+
+		// Skip deadlines that were missed rather than rushing frames to catch up
+		if (mDeadline < now) {
+			mDeadline = now + mInterval;
+		}
+	}
+}
+
+void FramePacer::presented() {
+	if (mInterval > 0. && mSyncToPresent) {
+		// The present returned at the vertical blank, so the next one is an interval away
+		mDeadline = glfwGetTime() + mInterval;
+	}
+}
+
+void FramePacer::sleepUntil(double time, bool spin) {
+	double spinTime = spin ? kSpinTime : 0.;
+	double remaining = time - glfwGetTime();
+	while (remaining > spinTime) {
+		this_thread::sleep_for(chrono::duration<double>(remaining - spinTime));
+		remaining = time - glfwGetTime();
+	}
+
+	while (spin && glfwGetTime() < time) {
+		this_thread::yield();
+	}
+}
@@ -0,0 +1,43 @@
+#ifndef FRAME_PACER_H
+#define FRAME_PACER_H
+
+/**
+ * Paces a loop to a target interval by sleeping until each frame is due.
+ *
+ * Usage per frame: wait(), do the work, endWork(), present, presented().
+ * The cost of the work between wait() and endWork() is averaged so that in low latency
+ * mode the frame can start as late as possible while still finishing by its deadline.
+ * When presenting blocks on vertical sync, the deadlines follow the presents instead.
+ */
+class FramePacer {
+private:
+	double mInterval;
+	double mDeadline;
+	double mWorkStart;
+	double mAverageCost;
+	bool mLowLatency;
+	bool mSyncToPresent;
+
+public:
+	FramePacer();
+
+	/** @param interval seconds between frames, or 0 to run unpaced */
+	void setInterval(double interval);
+	void setLowLatency(bool lowLatency) { mLowLatency = lowLatency; }
+	void setSyncToPresent(bool syncToPresent) { mSyncToPresent = syncToPresent; }
+
+	double getInterval() const { return mInterval; }
+	double getAverageCost() const { return mAverageCost; }
+
+	void wait();
+	void endWork();
+	void presented();
+
+	/**
+	 * Sleeps until the specified glfwGetTime time. Sleeps can overshoot by about a millisecond, so
+	 * if spin is set the last moment is spent yielding instead, which keeps a core busy while waiting.
+	 */
+	static void sleepUntil(double time, bool spin = false);
+};
+
+#endif
@@ -0,0 +1,99 @@
+#include "GLExtensions.h"
+
+#include <cstdio>
+#include <string>
+
+using namespace std;
+
+GLExtensions gGLExtensions;
+
+/**
+ * Looks up an entry point by name
+ * @param suffix empty for core entry points, or the suffix of the extension that provides it
+ * @return true if the entry point was found
+ */
+template <typename FunctionT>
+static bool loadFunction(FunctionT& function, const char* name, const char* suffix) {
+	function = (FunctionT)glfwGetProcAddress((string(name) + suffix).c_str());
+	return function != nullptr;
+}
+
+static bool isVersionSupported(int major, int minor) {
+	int contextMajor = 0;
+	int contextMinor = 0;
+	auto version = (const char*)glGetString(GL_VERSION);
+	if (!version || sscanf(version, "%d.%d", &contextMajor, &contextMinor) != 2) {
+		return false;
+	}
+
+	return contextMajor > major || (contextMajor == major && contextMinor >= minor);
+}
+
+GLExtensions::GLExtensions() :
+	vertexBufferObjects(false),
+	genBuffers(nullptr),
+	deleteBuffers(nullptr),
+	bindBuffer(nullptr),
+	bufferData(nullptr),
+	bufferSubData(nullptr),
+	mapBuffer(nullptr),
+	unmapBuffer(nullptr),
+	pixelBufferObjects(false),
+	syncObjects(false),
+	fenceSync(nullptr),
+	clientWaitSync(nullptr),
+	deleteSync(nullptr),
+	framebufferObjects(false),
+	genFramebuffers(nullptr),
+	deleteFramebuffers(nullptr),
+	bindFramebuffer(nullptr),
+	framebufferTexture2D(nullptr),
+	checkFramebufferStatus(nullptr)
+{
+}
+
+void GLExtensions::load() {
+	const char* suffix = nullptr;
+
+	if (isVersionSupported(1, 5)) {
+		suffix = "";
+	} else if (glfwExtensionSupported("GL_ARB_vertex_buffer_object")) {
+		suffix = "ARB";
+	}
+
+	if (suffix) {
+		vertexBufferObjects = loadFunction(genBuffers, "glGenBuffers", suffix)
+			&& loadFunction(deleteBuffers, "glDeleteBuffers", suffix)
+			&& loadFunction(bindBuffer, "glBindBuffer", suffix)
+			&& loadFunction(bufferData, "glBufferData", suffix)
+			&& loadFunction(bufferSubData, "glBufferSubData", suffix)
+			&& loadFunction(mapBuffer, "glMapBuffer", suffix)
+			&& loadFunction(unmapBuffer, "glUnmapBuffer", suffix);
+	}
+
+	pixelBufferObjects = vertexBufferObjects && (isVersionSupported(2, 1)
+		|| glfwExtensionSupported("GL_ARB_pixel_buffer_object")
+		|| glfwExtensionSupported("GL_EXT_pixel_buffer_object"));
+
+	// ARB_sync has no suffix
+	if (isVersionSupported(3, 2) || glfwExtensionSupported("GL_ARB_sync")) {
+		syncObjects = loadFunction(fenceSync, "glFenceSync", "")
+			&& loadFunction(clientWaitSync, "glClientWaitSync", "")
+			&& loadFunction(deleteSync, "glDeleteSync", "");
+	}
+
+	suffix = nullptr;
+	if (isVersionSupported(3, 0) || glfwExtensionSupported("GL_ARB_framebuffer_object")) {
+		suffix = "";
+	} else if (glfwExtensionSupported("GL_EXT_framebuffer_object")) {
+		suffix = "EXT";
+	}
+
+	if (suffix) {
+		framebufferObjects = loadFunction(genFramebuffers, "glGenFramebuffers", suffix)
+			&& loadFunction(deleteFramebuffers, "glDeleteFramebuffers", suffix)
+			&& loadFunction(bindFramebuffer, "glBindFramebuffer", suffix)
+			&& loadFunction(framebufferTexture2D, "glFramebufferTexture2D", suffix)
+			&& loadFunction(checkFramebufferStatus, "glCheckFramebufferStatus", suffix);
+	}
+}
@@ -0,0 +1,113 @@
+#ifndef GL_EXTENSIONS_H
+#define GL_EXTENSIONS_H
+
+#include <GLFW/glfw3.h>
+#include <cstddef>
+
+#if defined(_WIN32)
+#define GLEXT_APIENTRY __stdcall
+#else
+#define GLEXT_APIENTRY
+#endif
+
+#ifndef GL_ARRAY_BUFFER
+#define GL_ARRAY_BUFFER 0x8892
+#endif
+
+#ifndef GL_STREAM_DRAW
+#define GL_STREAM_DRAW 0x88E0
+#endif
+
+#ifndef GL_STATIC_DRAW
+#define GL_STATIC_DRAW 0x88E4
+#endif
+
+#ifndef GL_DYNAMIC_DRAW
+#define GL_DYNAMIC_DRAW 0x88E8
+#endif
+
+#ifndef GL_STREAM_READ
+#define GL_STREAM_READ 0x88E1
+#endif
+
+#ifndef GL_READ_ONLY
+#define GL_READ_ONLY 0x88B8
+#endif
+
+#ifndef GL_WRITE_ONLY
+#define GL_WRITE_ONLY 0x88B9
+#endif
+
+#ifndef GL_PIXEL_PACK_BUFFER
+#define GL_PIXEL_PACK_BUFFER 0x88EB
+#endif
+
+#ifndef GL_PIXEL_UNPACK_BUFFER
+#define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#endif
+
+#ifndef GL_SYNC_GPU_COMMANDS_COMPLETE
+#define GL_SYNC_GPU_COMMANDS_COMPLETE 0x9117
+#endif
+
+#ifndef GL_ALREADY_SIGNALED
+#define GL_ALREADY_SIGNALED 0x911A
+#endif
+
+#ifndef GL_CONDITION_SATISFIED
+#define GL_CONDITION_SATISFIED 0x911C
+#endif
+
+#ifndef GL_FRAMEBUFFER
+#define GL_FRAMEBUFFER 0x8D40
+#endif
+
+#ifndef GL_FRAMEBUFFER_COMPLETE
+#define GL_FRAMEBUFFER_COMPLETE 0x8CD5
+#endif
+
+#ifndef GL_COLOR_ATTACHMENT0
+#define GL_COLOR_ATTACHMENT0 0x8CE0
+#endif
+
+/**
+ * OpenGL entry points beyond 1.1, which is all some platforms export directly.
+ * Each group of functions is only valid if its flag is set after load().
+ */
+struct GLExtensions {
+	// OpenGL 1.5 or ARB_vertex_buffer_object
+	bool vertexBufferObjects;
+	void (GLEXT_APIENTRY *genBuffers)(GLsizei n, GLuint* buffers);
+	void (GLEXT_APIENTRY *deleteBuffers)(GLsizei n, const GLuint* buffers);
+	void (GLEXT_APIENTRY *bindBuffer)(GLenum target, GLuint buffer);
+	void (GLEXT_APIENTRY *bufferData)(GLenum target, ptrdiff_t size, const void* data, GLenum usage);
+	void (GLEXT_APIENTRY *bufferSubData)(GLenum target, ptrdiff_t offset, ptrdiff_t size, const void* data);
+	void* (GLEXT_APIENTRY *mapBuffer)(GLenum target, GLenum access);
+	GLboolean (GLEXT_APIENTRY *unmapBuffer)(GLenum target);
+
+	// OpenGL 2.1 or ARB_pixel_buffer_object, which only adds buffer targets to the functions above
+	bool pixelBufferObjects;
+
+	// OpenGL 3.2 or ARB_sync. Sync objects are declared as void* since old headers lack GLsync.
+	bool syncObjects;
+	void* (GLEXT_APIENTRY *fenceSync)(GLenum condition, GLbitfield flags);
+	GLenum (GLEXT_APIENTRY *clientWaitSync)(void* sync, GLbitfield flags, unsigned long long timeout);
+	void (GLEXT_APIENTRY *deleteSync)(void* sync);
+
+	// OpenGL 3.0, ARB_framebuffer_object or EXT_framebuffer_object
+	bool framebufferObjects;
+	void (GLEXT_APIENTRY *genFramebuffers)(GLsizei n, GLuint* framebuffers);
+	void (GLEXT_APIENTRY *deleteFramebuffers)(GLsizei n, const GLuint* framebuffers);
+	void (GLEXT_APIENTRY *bindFramebuffer)(GLenum target, GLuint framebuffer);
+	void (GLEXT_APIENTRY *framebufferTexture2D)(GLenum target, GLenum attachment, GLenum textarget, GLuint texture, GLint level);
+	GLenum (GLEXT_APIENTRY *checkFramebufferStatus)(GLenum target);
+
+	GLExtensions();
+
+	/** Looks up the supported entry points. The context must be current. */
+	void load();
+};
+
+extern GLExtensions gGLExtensions;
+
+#endif
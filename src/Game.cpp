@@ -1,20 +1,25 @@
 #include "Game.h"
 
-#include "Color.h"
-#include "Config.h"
 #include "FillRules.h"
-#include <GLFW/glfw3.h>
 #include <algorithm>
+#include <cmath>
+#include <cstdlib>
 #include <iostream>
+#include <string>
 
 using namespace std;
 
 Game::Game(int width, int height) :
 	mWidth(width), mHeight(height),
 	mWalls(width * height),
+	mStep(0),
 	mMaxPlayers(4), mNumPlayers(2),
-	mNextEntityId(0)
+	mSnapshotStep(0)
 {
+	CellSnapshot emptyCell = {-1, 0, 0.f};
+	mSnapshotCells.assign(width * height, emptyCell);
+	mDirtyCells.resize(width * height);
+
 	mFillRule.reset(new EmptyRectanglesFillRule(*this));
 	mFillRule->onInit();
 
@@ -24,23 +29,132 @@ Game::Game(int width, int height) :
 	}
 }
 
-int Game::popNextEntityId() {
-	int entityId;
-	if (mFreeEntityIds.empty()) {
-		entityId = mNextEntityId++;
-	} else {
-		entityId = mFreeEntityIds.back();
-		mFreeEntityIds.pop_back();
+static const char* kSaveHeader = "isolated-game";
+static const int kSaveVersion = 1;
+
+Game::Game(istream& in) :
+	mWidth(0), mHeight(0),
+	mStep(0),
+	mMaxPlayers(4), mNumPlayers(0),
+	mSnapshotStep(0)
+{
+	string header;
+	int version = 0;
+	double time = 0.;
+	in >> header >> version >> mWidth >> mHeight >> time;
+	if (header != kSaveHeader || version != kSaveVersion || mWidth <= 0 || mHeight <= 0) {
+		in.setstate(ios::failbit);
+		mWidth = mHeight = 0;
+		return;
+	}
+
+	mWalls.resize(mWidth * mHeight);
+	mDirtyCells.resize(mWidth * mHeight);
+	mClock.set(time);
+
+	mFillRule.reset(new EmptyRectanglesFillRule(*this));
+	mFillRule->onInit();
+
+	int numPlayers = 0;
+	in >> numPlayers;
+	for (int i = 0; i < numPlayers && in; ++i) {
+		int isBot = 0;
+		in >> isBot;
+		auto player = createPlayer(0, 0);
+		player->load(in);
+		if (isBot) {
+			mBots.emplace_back(*this, player->getPlayerId());
+		}
 	}
 
-	return entityId;
+	int numWalls = 0;
+	in >> numWalls;
+	for (int i = 0; i < numWalls && in; ++i) {
+		int x, y, playerId;
+		in >> x >> y >> playerId;
+		if (!isInBounds(x, y) || getWallAt(x, y)) {
+			in.setstate(ios::failbit);
+			break;
+		}
+
+		auto wall = newWall(x, y, playerId);
+		wall->load(in);
+		setWallAt(x, y, wall);
+		mFillRule->onWallCreated(x, y);
+	}
+
+	mSnapshotCells.resize(mWidth * mHeight);
+	for (size_t i = 0; i < mWalls.size(); ++i) {
+		updateSnapshotCell(i);
+	}
 }
 
-void Game::createPlayer(int x, int y) {
-	auto player = make_shared<Player>(*this, popNextEntityId(), mPlayers.size());
+void Game::save(ostream& out) const {
+	// The clock starts at a large value, so it needs every digit
+	auto precision = out.precision(17);
+
+	out << kSaveHeader << ' ' << kSaveVersion << '\n';
+	out << mWidth << ' ' << mHeight << ' ' << mClock.getTime() << '\n';
+
+	out << mPlayers.size() << '\n';
+	for (auto& player : mPlayers) {
+		bool isBot = false;
+		for (auto& bot : mBots) {
+			isBot = isBot || bot.getPlayerId() == player->getPlayerId();
+		}
+
+		out << (isBot ? 1 : 0) << ' ';
+		player->save(out);
+		out << '\n';
+	}
+
+	int numWalls = 0;
+	for (auto& wall : mWalls) {
+		numWalls += wall ? 1 : 0;
+	}
+
+	out << numWalls << '\n';
+	for (int i = 0; i < mWidth * mHeight; ++i) {
+		auto& wall = mWalls[i];
+		if (wall) {
+			out << i % mWidth << ' ' << i / mWidth << ' ' << wall->getPlayerId() << ' ';
+			wall->save(out);
+			out << '\n';
+		}
+	}
+
+	out.precision(precision);
+}
+
+PlayerPtr Game::createPlayer(int x, int y) {
+	auto handle = mEntities.insert(nullptr);
+	auto player = make_shared<Player>(*this, handle, mPlayers.size());
+	*mEntities.get(handle) = player;
 	mPlayers.push_back(player);
 	player->position.x = (float)x;
 	player->position.y = (float)y;
+	return player;
+}
+
+WallPtr Game::newWall(int x, int y, int playerId) {
+	auto handle = mEntities.insert(nullptr);
+	auto wall = make_shared<Wall>(*this, x, y, handle, playerId);
+	*mEntities.get(handle) = wall;
+	return wall;
+}
+
+void Game::releaseEntity(const EntityPtr& entity) {
+	mEntities.remove(entity->getHandle());
+}
+
+bool Game::spawnBot() {
+	if ((int)mPlayers.size() >= min(mMaxPlayers, (int)Input::kMaxLocalPlayers)) {
+		return false;
+	}
+
+	auto player = createPlayer(rand() % mWidth, rand() % mHeight);
+	mBots.emplace_back(*this, player->getPlayerId());
+	return true;
 }
 
 WallPtr Game::createWall(int x, int y, int playerId) {
@@ -50,8 +164,9 @@ WallPtr Game::createWall(int x, int y, int playerId) {
 
 	auto wall = getWallAt(x, y);
 	if (!wall) {
-		wall = make_shared<Wall>(*this, x, y, popNextEntityId(), playerId);
+		wall = newWall(x, y, playerId);
 		setWallAt(x, y, wall);
+		markDirty(x, y);
 		mFillRule->onWallCreated(x, y);
 		return wall;
 	} else if (wall->getPlayerId() == playerId) {
@@ -63,14 +178,131 @@ WallPtr Game::createWall(int x, int y, int playerId) {
 	return nullptr;
 }
 
+int Game::fillRect(int left, int bottom, int right, int top, int playerId) {
+	left = max(left, 0);
+	bottom = max(bottom, 0);
+	right = min(right, mWidth - 1);
+	top = min(top, mHeight - 1);
+
+	int numCreated = 0;
+	for (int j = bottom; j <= top; ++j) {
+		for (int i = left; i <= right; ++i) {
+			if (!getWallAt(i, j)) {
+				setWallAt(i, j, newWall(i, j, playerId));
+				markDirty(i, j);
+				++numCreated;
+			}
+		}
+	}
+
+	if (numCreated > 0) {
+		mFillRule->onRectFilled(left, bottom, right, top);
+	}
+
+	return numCreated;
+}
+
+void Game::apply(const GridTransaction& transaction) {
+	if (transaction.isEmpty()) {
+		return;
+	}
+
+	auto changes = transaction.getChanges();
+	sort(changes.begin(), changes.end());
+
+	struct Move {
+		WallPtr wall;
+		int from, to;
+		bool blocked;
+	};
+
+	vector<Move> moves;
+	vector<int> changedCells;
+
+	// The changes are sorted by kind, so every destruction and move comes before the creations
+	auto change = changes.begin();
+	for (; change != changes.end() && change->type != GridTransaction::CHANGE_CREATE; ++change) {
+		if (!isInBounds(change->x, change->y)) {
+			continue;
+		}
+
+		int index = change->x + change->y * mWidth;
+		auto wall = mWalls[index];
+		if (!wall) {
+			continue;
+		}
+
+		if (change->type == GridTransaction::CHANGE_DESTROY) {
+			wall->die();
+			releaseEntity(wall);
+			mWalls[index] = nullptr;
+			changedCells.push_back(index);
+		} else if (isInBounds(change->toX, change->toY)) {
+			// Lift every moving wall off the grid before placing any of them
+			Move move = {wall, index, change->toX + change->toY * mWidth, false};
+			moves.push_back(move);
+			mWalls[index] = nullptr;
+		}
+	}
+
+	// Walls that can't move are put back, which may in turn block the moves onto their cells
+	bool blocked = !moves.empty();
+	while (blocked) {
+		blocked = false;
+		set<int> destinations;
+		for (auto& move : moves) {
+			if (!move.blocked && (mWalls[move.to] || !destinations.insert(move.to).second)) {
+				move.blocked = blocked = true;
+				mWalls[move.from] = move.wall;
+			}
+		}
+	}
+
+	for (auto& move : moves) {
+		if (!move.blocked) {
+			mWalls[move.to] = move.wall;
+			move.wall->position = Vec2((float)(move.to % mWidth), (float)(move.to / mWidth));
+			changedCells.push_back(move.from);
+			changedCells.push_back(move.to);
+		}
+	}
+
+	for (; change != changes.end(); ++change) {
+		if (isInBounds(change->x, change->y) && !getWallAt(change->x, change->y)) {
+			setWallAt(change->x, change->y, newWall(change->x, change->y, change->playerId));
+			changedCells.push_back(change->x + change->y * mWidth);
+		}
+	}
+
+	if (changedCells.empty()) {
+		return;
+	}
+
+	sort(changedCells.begin(), changedCells.end());
+	changedCells.erase(unique(changedCells.begin(), changedCells.end()), changedCells.end());
+	for (auto index : changedCells) {
+		mDirtyCells.mark(index);
+	}
+
+	mFillRule->onCellsChanged(changedCells);
+
+	// Now that the whole grid is up to date, a moved wall can close a region just as a new one can
+	for (auto& move : moves) {
+		if (!move.blocked) {
+			mFillRule->onWallMoved(move.from % mWidth, move.from / mWidth, move.to % mWidth, move.to / mWidth);
+		}
+	}
+}
+
 void Game::removeWall(int x, int y) {
 	auto wall = getWallAt(x, y);
 	if (!wall) {
 		return;
 	}
 
-	mFreeEntityIds.push_back(wall->getEntityId());
+	releaseEntity(wall);
 	setWallAt(x, y, nullptr);
+	markDirty(x, y);
 
 	mFillRule->onWallDestroyed(x, y);
 }
@@ -87,6 +319,7 @@ bool Game::attackWall(int x, int y, char damage) {
 	}
 
 	wall->takeDamage(damage);
+	markDirty(x, y);
 	if (!wall->active) {
 		removeWall(x, y);
 	}
@@ -99,23 +332,37 @@ void Game::onWallCompleted(int x, int y) {
 }
 
 void Game::update(float dt) {
+	mDirtyCells.clear();
+	++mStep;
 	mClock.advance(dt);
 
-	// Update walls
+	// Update walls, removing the dead ones all at once afterwards
+	GridTransaction removals;
 	for (int i = 0; i < mWidth; ++i) {
 		for (int j = 0; j < mHeight; ++j) {
 			auto wall = getWallAt(i, j);
 			if (wall) {
 				if (wall->active) {
+					// Walls change height until they are complete
+					if (!wall->isComplete()) {
+						markDirty(i, j);
+					}
+
 					wall->update(dt);
 				} else {
-					removeWall(i, j);
+					removals.destroyWall(i, j);
 				}
 			}
 		}
 	}
 
-	// Update players
+	apply(removals);
+
+	// Update players, letting the bots decide on their input first
+	for (auto& bot : mBots) {
+		bot.update();
+	}
+
 	for (auto& player : mPlayers) {
 		player->update(dt);
 	}
@@ -123,72 +370,46 @@ void Game::update(float dt) {
 	collidePlayersWithWorld();
 }
 
-void Game::renderDebug() {
-	static Color playerColors[] = {
-		{1.f, 0.f, 0.f, 0.5f},
-		{0.f, 1.f, 0.f, 0.5f}
-	};
-
-	// Setup camera
-	glEnable(GL_BLEND);
-	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
-	glMatrixMode(GL_PROJECTION);
-	glLoadIdentity();
-	glOrtho(-1., mWidth + 1., -1., mHeight + 1., -1., 1.);
-	glMatrixMode(GL_MODELVIEW);
-
-	// Render grid
-	Color gridColor = gConfig["debug"].getColor("grid-color");
-	glColor4fv((GLfloat*)&gridColor);
-	glBegin(GL_LINES);
-	for (int i = 0; i <= mWidth; ++i) {
-		glVertex2i(i, 0);
-		glVertex2i(i, mHeight);
-	}
-
-	for (int j = 0; j <= mHeight; ++j) {
-		glVertex2i(0, j);
-		glVertex2i(mWidth, j);
+void Game::updateSnapshotCell(int index) {
+	auto& wall = mWalls[index];
+	auto& cell = mSnapshotCells[index];
+	if (wall) {
+		cell.playerId = wall->getPlayerId();
+		cell.strength = wall->getStrength();
+		cell.height = wall->getHeight();
+	} else {
+		cell.playerId = -1;
+		cell.strength = 0;
+		cell.height = 0.f;
 	}
-	glEnd();
+}
 
-	// Render walls
-	glBegin(GL_QUADS);
-	for (int i = 0; i < mWidth; ++i) {
-		for (int j = 0; j < mHeight; ++j) {
-			auto wall = getWallAt(i, j);
-			if (wall) {
-				auto& pos = wall->position;
-				float height = wall->getHeight() * 0.5f;
-				Color baseColor = playerColors[wall->getPlayerId()];
-				Color topColor = baseColor;
-				float strength = (float)wall->getStrength() / Wall::sMaxStrength;
-				topColor *= 0.7f * strength;
-				topColor.a = 1.f;
-				baseColor *= strength;
-				glColor4fv((GLfloat*)&baseColor);
-				glVertex2f(pos.x + 0.f, pos.y + 0.f);
-				glVertex2f(pos.x + 1.f, pos.y + 0.f);
-				glVertex2f(pos.x + 1.f, pos.y + 1.f);
-				glVertex2f(pos.x + 0.f, pos.y + 1.f);
-
-				glColor4fv((GLfloat*)&topColor);
-				glVertex2f(pos.x + 0.f, pos.y + height);
-				glVertex2f(pos.x + 1.f, pos.y + height);
-				glVertex2f(pos.x + 1.f, pos.y + 1.0f);
-				glVertex2f(pos.x + 0.f, pos.y + 1.0f);
-			}
+shared_ptr<GameSnapshot> Game::snapshot() {
+	// Only the dirty cells need to be copied again if the previous step was snapshotted
+	if (mSnapshotStep + 1 == mStep) {
+		for (auto index : mDirtyCells.getIndices()) {
+			updateSnapshotCell(index);
+		}
+	} else if (mSnapshotStep != mStep) {
+		for (size_t i = 0; i < mWalls.size(); ++i) {
+			updateSnapshotCell(i);
 		}
 	}
-	glEnd();
 
-	// Render players
+	mSnapshotStep = mStep;
+
+	auto snapshot = make_shared<GameSnapshot>(mWidth, mHeight);
+	snapshot->step = mStep;
+	snapshot->maxStrength = Wall::sMaxStrength;
+	snapshot->cells = mSnapshotCells;
+	snapshot->dirtyCells = mDirtyCells.getIndices();
+
+	snapshot->players.reserve(mPlayers.size());
 	for (auto& player : mPlayers) {
-		glColor4fv((const GLfloat*)&playerColors[player->getPlayerId()]);
-		player->renderDebug();
+		snapshot->players.push_back(player->snapshot());
 	}
 
-	glDisable(GL_BLEND);
+	return snapshot;
 }
 
 void Game::boundEntity(EntityPtr entity) {
@@ -1,12 +1,18 @@
 #ifndef GAME_GRID_H
 #define GAME_GRID_H
 
+#include "Bot.h"
+#include "DirtyCells.h"
+#include "GameSnapshot.h"
+#include "GridTransaction.h"
 #include "Player.h"
+#include "SlotMap.h"
 #include "Time.h"
 #include "Wall.h"
 #include <cassert>
 #include <istream>
 #include <memory>
+#include <ostream>
 #include <set>
 #include <vector>
 
@@ -58,30 +64,41 @@ class Game {
 private:
 	int mWidth, mHeight;
 	std::vector<WallPtr> mWalls;
+	DirtyCells mDirtyCells;
+	unsigned int mStep;
 
 	int mMaxPlayers;
 	int mNumPlayers;
 	std::vector<PlayerPtr> mPlayers;
-	std::vector<int> mFreeEntityIds;
-	int mNextEntityId;
+	std::vector<Bot> mBots;
+	SlotMap<EntityPtr> mEntities;
 
 	std::shared_ptr<IFillRule> mFillRule;
 
 	Clock mClock;
 
+	std::vector<CellSnapshot> mSnapshotCells;
+	unsigned int mSnapshotStep;
+
 public:
 	Game(int width, int height); // Create empty grid of the specified size
-	Game(std::istream& in);	// Load a grid from the specified stream
+	Game(std::istream& in);	// Load a grid saved by save(), check in.fail() afterwards for errors
 
 private:
-	int popNextEntityId();
-
-	void createPlayer(int x, int y);
+	PlayerPtr createPlayer(int x, int y);
+	WallPtr newWall(int x, int y, int playerId); // Doesn't place the wall on the grid
+	void releaseEntity(const EntityPtr& entity);
 
 	void setWallAt(int x, int y, WallPtr wall) {
 		mWalls[x + y * mWidth] = wall;
 	}
 
+	void markDirty(int x, int y) {
+		mDirtyCells.mark(x + y * mWidth);
+	}
+
+	void updateSnapshotCell(int index);
+
 	void removeWall(int x, int y);
 
 	void boundEntity(EntityPtr entity);
@@ -100,22 +117,60 @@ public:
 	int getMaxPlayers() const { return mMaxPlayers; }
 	int getNumPlayers() const { return mPlayers.size(); }
 
+	/** Adds a player controlled by a Bot. Returns false if the game is full. */
+	bool spawnBot();
+
 	EntityPtr createEntity(int x, int y, int type);
 	void destroyEntity(EntityPtr entity);
 
+	/** Returns null if the entity has been destroyed */
+	EntityPtr getEntity(EntityHandle handle) const {
+		auto entity = mEntities.get(handle);
+		return entity ? *entity : nullptr;
+	}
+
 	WallPtr getWallAt(int x, int y) {
 		return mWalls[x + y * mWidth];
 	}
 
 	WallPtr createWall(int x, int y, int playerId);
+
+	/**
+	 * Creates a wall in every empty cell from (left, bottom) to (right, top) inclusive, notifying
+	 * the fill rule once for the whole rectangle. Returns the number of walls created.
+	 */
+	int fillRect(int left, int bottom, int right, int top, int playerId);
+
+	/**
+	 * Applies every change in the transaction, then notifies the fill rule once with all the cells
+	 * that changed, which are also marked dirty
+	 */
+	void apply(const GridTransaction& transaction);
+
 	bool attackWall(int x, int y, char damage); // Returns true if attack hit a Wall
 	void onWallCompleted(int x, int y);
 
 	const Clock& getClock() const { return mClock; }
 
+	/** The number of times the game has been updated */
+	unsigned int getStep() const { return mStep; }
+
+	/**
+	 * Continues counting steps from the specified step. Used when a loaded game replaces
+	 * another, so that its steps can't be mistaken for the next steps of the previous game.
+	 */
+	void setStep(unsigned int step) { mStep = mSnapshotStep = step; }
+
+	/** Cells that were created, destroyed, damaged or changed height during the last update */
+	const DirtyCells& getDirtyCells() const { return mDirtyCells; }
+
 	void update(float dt);
 
-	void renderDebug();
+	/** Writes the state of the grid and players, to be loaded by Game(std::istream&) */
+	void save(std::ostream& out) const;
+
+	/** Copies the state needed to render the game */
+	std::shared_ptr<GameSnapshot> snapshot();
 };
 
 #endif
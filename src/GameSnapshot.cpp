@@ -0,0 +1,109 @@
+#include "GameSnapshot.h"
+
+#include "GridRenderer.h"
+#include "Input.h"
+#include <GLFW/glfw3.h>
+#include <cmath>
+
+static Color playerColors[] = {
+	{1.f, 0.f, 0.f, 0.5f},
+	{0.f, 1.f, 0.f, 0.5f},
+	{0.f, 0.4f, 1.f, 0.5f},
+	{1.f, 0.9f, 0.f, 0.5f}
+};
+
+static const int kNumPlayerColors = sizeof(playerColors) / sizeof(playerColors[0]);
+static_assert(kNumPlayerColors >= Input::kMaxLocalPlayers, "Every player needs a color");
+
+const Color& getPlayerColor(int playerId) {
+	return playerColors[playerId % kNumPlayerColors];
+}
+
+static float lerp(float a, float b, float t) {
+	return a + (b - a) * t;
+}
+
+static void renderPlayer(const PlayerSnapshot& player, const Vec2& position) {
+	// Render the player body
+	glColor4fv((const GLfloat*)&getPlayerColor(player.playerId));
+	glBegin(GL_TRIANGLES);
+	glVertex2f(position.x + 0.f, position.y);
+	glVertex2f(position.x + player.size.x, position.y);
+	glVertex2f(position.x + player.size.x / 2.f, position.y + player.size.y);
+	glEnd();
+
+	// Render player stock at the top of the screen
+	glPointSize(5.f);
+	glBegin(GL_POINTS);
+	float stockBarOffset = player.playerId * 4.f;
+	for (int i = 0; i < player.stock; ++i) {
+		glVertex2f(i * 0.4f + stockBarOffset, -0.5f);
+	}
+	glEnd();
+
+	// Render the selection
+	if (player.selecting) {
+		int selectionX = player.selectionX;
+		int selectionY = player.selectionY;
+
+		glColor4f(0.3f, 0.3f, 0.5f, 0.3f);
+		glBegin(GL_QUADS);
+		glVertex2i(selectionX, selectionY);
+		glVertex2i(selectionX + 1, selectionY);
+		glVertex2i(selectionX + 1, selectionY + 1);
+		glVertex2i(selectionX, selectionY + 1);
+		glEnd();
+	}
+
+	// Render the currently building indicator
+	if (player.building) {
+		int wallStreamX = player.wallStreamX;
+		int wallStreamY = player.wallStreamY;
+
+		glColor4f(1.f, 1.f, 1.f, 0.1f);
+		glBegin(GL_LINE_STRIP);
+		glVertex2i(wallStreamX, wallStreamY);
+		glVertex2i(wallStreamX + 1, wallStreamY);
+		glVertex2i(wallStreamX + 1, wallStreamY + 1);
+		glVertex2i(wallStreamX, wallStreamY + 1);
+		glVertex2i(wallStreamX, wallStreamY);
+		glEnd();
+	}
+}
+
+void GameSnapshot::render(const SceneSnapshot* previousScene, float alpha) const {
+	// Only interpolate from a snapshot of the same game
+	auto previous = dynamic_cast<const GameSnapshot*>(previousScene);
+	if (previous && (previous->width != width || previous->height != height)) {
+		previous = nullptr;
+	}
+
+	// Setup camera
+	glEnable(GL_BLEND);
+	glBlendFunc(GL_ONE, GL_ONE_MINUS_SRC_ALPHA);
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(-1., width + 1., -1., height + 1., -1., 1.);
+	glMatrixMode(GL_MODELVIEW);
+
+	// Render grid and walls
+	gGridRenderer->render(*this, previous, alpha);
+
+	// Render players
+	for (size_t i = 0; i < players.size(); ++i) {
+		auto& player = players[i];
+		auto position = player.position;
+		if (previous && i < previous->players.size()) {
+			// Don't interpolate players that were moved to respawn
+			auto& previousPosition = previous->players[i].position;
+			if (fabsf(position.x - previousPosition.x) + fabsf(position.y - previousPosition.y) < 1.f) {
+				position.x = lerp(previousPosition.x, position.x, alpha);
+				position.y = lerp(previousPosition.y, position.y, alpha);
+			}
+		}
+
+		renderPlayer(player, position);
+	}
+
+	glDisable(GL_BLEND);
+}
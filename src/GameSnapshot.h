@@ -0,0 +1,54 @@
+#ifndef GAME_SNAPSHOT_H
+#define GAME_SNAPSHOT_H
+
+#include "Color.h"
+#include "Scene.h"
+#include "Vector.h"
+#include <vector>
+
+const Color& getPlayerColor(int playerId);
+
+struct CellSnapshot {
+	int playerId; // -1 if there is no wall in the cell
+	int strength;
+	float height;
+};
+
+struct PlayerSnapshot {
+	int playerId;
+	int stock;
+	Vec2 position;
+	Vec2 size;
+	bool selecting;
+	int selectionX, selectionY;
+	bool building;
+	int wallStreamX, wallStreamY;
+};
+
+/**
+ * The state of a Game at the end of a step, as needed for rendering
+ */
+class GameSnapshot : public SceneSnapshot {
+public:
+	unsigned int step;
+	int width, height;
+	int maxStrength;
+	Color gridColor;
+	std::vector<CellSnapshot> cells;
+	std::vector<int> dirtyCells; // Indices of the cells that changed during this step
+	std::vector<PlayerSnapshot> players;
+
+	GameSnapshot(int width, int height) :
+		step(0),
+		width(width), height(height),
+		maxStrength(1),
+		cells(width * height) {}
+
+	const CellSnapshot& getCellAt(int x, int y) const {
+		return cells[x + y * width];
+	}
+
+	void render(const SceneSnapshot* previous, float alpha) const override;
+};
+
+#endif
@@ -0,0 +1,207 @@
+#include "GridRenderer.h"
+
+#include "GLExtensions.h"
+#include <climits>
+#include <cstddef>
+
+using namespace std;
+
+shared_ptr<GridRenderer> gGridRenderer;
+
+static float lerp(float a, float b, float t) {
+	return a + (b - a) * t;
+}
+
+static bool operator!=(const Color& a, const Color& b) {
+	return a.r != b.r || a.g != b.g || a.b != b.b || a.a != b.a;
+}
+
+static bool operator!=(const CellSnapshot& a, const CellSnapshot& b) {
+	return a.playerId != b.playerId || a.strength != b.strength || a.height != b.height;
+}
+
+GridRenderer::GridRenderer() :
+	mWidth(0), mHeight(0),
+	mMaxStrength(0),
+	mDrawnStep(0),
+	mGridColor(Color::kWhite),
+	mGridBuffer(0), mCellBuffer(0)
+{
+	if (gGLExtensions.vertexBufferObjects) {
+		gGLExtensions.genBuffers(1, &mGridBuffer);
+		gGLExtensions.genBuffers(1, &mCellBuffer);
+	}
+}
+
+GridRenderer::~GridRenderer() {
+	if (gGLExtensions.vertexBufferObjects) {
+		gGLExtensions.deleteBuffers(1, &mGridBuffer);
+		gGLExtensions.deleteBuffers(1, &mCellBuffer);
+	}
+}
+
+void GridRenderer::resize(int width, int height, const Color& gridColor) {
+	mWidth = width;
+	mHeight = height;
+	mGridColor = gridColor;
+
+	// Build the grid lines, which never change for a given size
+	mGridVertices.clear();
+	for (int i = 0; i <= mWidth; ++i) {
+		mGridVertices.push_back(Vec2((float)i, 0.f));
+		mGridVertices.push_back(Vec2((float)i, (float)mHeight));
+	}
+
+	for (int j = 0; j <= mHeight; ++j) {
+		mGridVertices.push_back(Vec2(0.f, (float)j));
+		mGridVertices.push_back(Vec2((float)mWidth, (float)j));
+	}
+
+	// Start with every cell empty
+	CellSnapshot emptyCell = {-1, 0, 0.f};
+	mDrawnCells.assign(mWidth * mHeight, emptyCell);
+	mCellVertices.resize(mWidth * mHeight * kVerticesPerCell);
+	for (int i = 0; i < mWidth * mHeight; ++i) {
+		buildCell(i, emptyCell);
+	}
+
+	if (gGLExtensions.vertexBufferObjects) {
+		gGLExtensions.bindBuffer(GL_ARRAY_BUFFER, mGridBuffer);
+		gGLExtensions.bufferData(GL_ARRAY_BUFFER, mGridVertices.size() * sizeof(Vec2), mGridVertices.data(), GL_STATIC_DRAW);
+		gGLExtensions.bindBuffer(GL_ARRAY_BUFFER, mCellBuffer);
+		gGLExtensions.bufferData(GL_ARRAY_BUFFER, mCellVertices.size() * sizeof(Vertex), mCellVertices.data(), GL_DYNAMIC_DRAW);
+		gGLExtensions.bindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+}
+
+void GridRenderer::buildCell(int index, const CellSnapshot& cell) {
+	auto vertices = &mCellVertices[index * kVerticesPerCell];
+
+	// Empty cells are drawn as degenerate quads so every cell keeps a fixed place in the buffer
+	if (cell.playerId < 0) {
+		Vertex empty = {0.f, 0.f, {0.f, 0.f, 0.f, 0.f}};
+		for (int i = 0; i < kVerticesPerCell; ++i) {
+			vertices[i] = empty;
+		}
+
+		return;
+	}
+
+	float x = (float)(index % mWidth);
+	float y = (float)(index / mWidth);
+	float height = cell.height * 0.5f;
+	Color baseColor = getPlayerColor(cell.playerId);
+	Color topColor = baseColor;
+	float strength = (float)cell.strength / mMaxStrength;
+	topColor *= 0.7f * strength;
+	topColor.a = 1.f;
+	baseColor *= strength;
+
+	Vertex cellVertices[kVerticesPerCell] = {
+		{x + 0.f, y + 0.f, baseColor},
+		{x + 1.f, y + 0.f, baseColor},
+		{x + 1.f, y + 1.f, baseColor},
+		{x + 0.f, y + 1.f, baseColor},
+
+		{x + 0.f, y + height, topColor},
+		{x + 1.f, y + height, topColor},
+		{x + 1.f, y + 1.f, topColor},
+		{x + 0.f, y + 1.f, topColor}
+	};
+
+	for (int i = 0; i < kVerticesPerCell; ++i) {
+		vertices[i] = cellVertices[i];
+	}
+}
+
+void GridRenderer::updateCell(int index, const GameSnapshot& snapshot, const GameSnapshot* previous, float alpha, int& firstDirtyCell, int& lastDirtyCell) {
+	auto cell = snapshot.cells[index];
+	if (previous && previous->cells[index].playerId == cell.playerId) {
+		cell.height = lerp(previous->cells[index].height, cell.height, alpha);
+	}
+
+	if (cell != mDrawnCells[index]) {
+		mDrawnCells[index] = cell;
+		buildCell(index, cell);
+
+		if (index < firstDirtyCell) {
+			firstDirtyCell = index;
+		}
+
+		if (index > lastDirtyCell) {
+			lastDirtyCell = index;
+		}
+	}
+}
+
+void GridRenderer::render(const GameSnapshot& snapshot, const GameSnapshot* previous, float alpha) {
+	bool resized = false;
+	if (snapshot.width != mWidth || snapshot.height != mHeight || snapshot.gridColor != mGridColor || snapshot.maxStrength != mMaxStrength) {
+		mMaxStrength = snapshot.maxStrength;
+		resize(snapshot.width, snapshot.height, snapshot.gridColor);
+		resized = true;
+	}
+
+	// Rebuild the cells that look different than when they were last drawn
+	int firstDirtyCell = INT_MAX;
+	int lastDirtyCell = -1;
+
+	// The only cells that can differ from the last frame are the ones that changed during
+	// the steps being interpolated, as long as no step was skipped since the last frame
+	bool consecutive = !resized && previous && previous->step + 1 == snapshot.step
+		&& (mDrawnStep == previous->step || mDrawnStep == snapshot.step);
+
+	if (consecutive) {
+		for (auto index : previous->dirtyCells) {
+			updateCell(index, snapshot, previous, alpha, firstDirtyCell, lastDirtyCell);
+		}
+
+		for (auto index : snapshot.dirtyCells) {
+			updateCell(index, snapshot, previous, alpha, firstDirtyCell, lastDirtyCell);
+		}
+	} else {
+		for (int i = 0; i < mWidth * mHeight; ++i) {
+			updateCell(i, snapshot, previous, alpha, firstDirtyCell, lastDirtyCell);
+		}
+	}
+
+	mDrawnStep = snapshot.step;
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+
+	// Render grid
+	const GLvoid* gridVertices = mGridVertices.data();
+	if (gGLExtensions.vertexBufferObjects) {
+		gGLExtensions.bindBuffer(GL_ARRAY_BUFFER, mGridBuffer);
+		gridVertices = nullptr;
+	}
+
+	glColor4fv((GLfloat*)&mGridColor);
+	glVertexPointer(2, GL_FLOAT, sizeof(Vec2), gridVertices);
+	glDrawArrays(GL_LINES, 0, (GLsizei)mGridVertices.size());
+
+	// Render walls, uploading the span of cells that changed in one go
+	auto cellVertices = (const char*)mCellVertices.data();
+	if (gGLExtensions.vertexBufferObjects) {
+		gGLExtensions.bindBuffer(GL_ARRAY_BUFFER, mCellBuffer);
+
+		if (lastDirtyCell >= 0) {
+			auto offset = firstDirtyCell * kVerticesPerCell * sizeof(Vertex);
+			auto size = (lastDirtyCell - firstDirtyCell + 1) * kVerticesPerCell * sizeof(Vertex);
+			gGLExtensions.bufferSubData(GL_ARRAY_BUFFER, offset, size, cellVertices + offset);
+		}
+
+		cellVertices = nullptr;
+	}
+
+	glEnableClientState(GL_COLOR_ARRAY);
+	glVertexPointer(2, GL_FLOAT, sizeof(Vertex), cellVertices);
+	glColorPointer(4, GL_FLOAT, sizeof(Vertex), cellVertices + offsetof(Vertex, color));
+	glDrawArrays(GL_QUADS, 0, (GLsizei)mCellVertices.size());
+	glDisableClientState(GL_COLOR_ARRAY);
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	if (gGLExtensions.vertexBufferObjects) {
+		gGLExtensions.bindBuffer(GL_ARRAY_BUFFER, 0);
+	}
+}
@@ -0,0 +1,56 @@
+#ifndef GRID_RENDERER_H
+#define GRID_RENDERER_H
+
+#include "Color.h"
+#include "GameSnapshot.h"
+#include "Vector.h"
+#include <GLFW/glfw3.h>
+#include <memory>
+#include <vector>
+
+/**
+ * Draws the grid lines and walls of a GameSnapshot with one draw call each.
+ *
+ * The vertices of every cell are kept in a vertex buffer object and only the cells whose
+ * owner, strength or height changed since the last frame are rebuilt and uploaded.
+ * Consecutive snapshots only have their dirty cells checked for changes.
+ * Falls back to client side vertex arrays if vertex buffer objects are unsupported.
+ * Note: The rendering context must be initialized before instantiating a renderer
+ */
+class GridRenderer {
+private:
+	struct Vertex {
+		float x, y;
+		Color color;
+	};
+
+	static const int kVerticesPerCell = 8;
+
+	int mWidth;
+	int mHeight;
+	int mMaxStrength;
+	unsigned int mDrawnStep;
+	Color mGridColor;
+	GLuint mGridBuffer;
+	GLuint mCellBuffer;
+	std::vector<Vec2> mGridVertices;
+	std::vector<Vertex> mCellVertices;
+	std::vector<CellSnapshot> mDrawnCells; // The state each cell's vertices were built from
+
+	GridRenderer(const GridRenderer&) = delete;
+	GridRenderer(GridRenderer&&) = delete;
+
+	void resize(int width, int height, const Color& gridColor);
+	void buildCell(int index, const CellSnapshot& cell);
+	void updateCell(int index, const GameSnapshot& snapshot, const GameSnapshot* previous, float alpha, int& firstDirtyCell, int& lastDirtyCell);
+
+public:
+	GridRenderer();
+	~GridRenderer();
+
+	void render(const GameSnapshot& snapshot, const GameSnapshot* previous, float alpha);
+};
+
+extern std::shared_ptr<GridRenderer> gGridRenderer;
+
+#endif
@@ -0,0 +1,65 @@
+#ifndef GRID_TRANSACTION_H
+#define GRID_TRANSACTION_H
+
+#include <vector>
+
+/**
+ * Changes to many cells of a Game's grid, recorded and then applied together by Game::apply().
+ *
+ * The changes are applied sorted by kind and then by cell, regardless of the order they were
+ * recorded in: walls are destroyed, then moved, then created. Moves are applied simultaneously, so
+ * a chain of walls can be pushed along by one cell. A move onto a cell that is still occupied, or
+ * onto the same cell as an earlier move, leaves its wall where it was. A completed wall that moves
+ * fills the empty rectangles it closes, like a wall that has just risen.
+ */
+class GridTransaction {
+public:
+	enum ChangeType {
+		CHANGE_DESTROY,
+		CHANGE_MOVE,
+		CHANGE_CREATE
+	};
+
+	struct Change {
+		ChangeType type;
+		int x, y;
+		int toX, toY; // Only for moves
+		int playerId; // Only for creations
+
+		bool operator<(const Change& other) const {
+			if (type != other.type) {
+				return type < other.type;
+			} else if (y != other.y) {
+				return y < other.y;
+			}
+
+			return x < other.x;
+		}
+	};
+
+private:
+	std::vector<Change> mChanges;
+
+public:
+	bool isEmpty() const { return mChanges.empty(); }
+	const std::vector<Change>& getChanges() const { return mChanges; }
+
+	void createWall(int x, int y, int playerId) {
+		Change change = {CHANGE_CREATE, x, y, x, y, playerId};
+		mChanges.push_back(change);
+	}
+
+	void destroyWall(int x, int y) {
+		Change change = {CHANGE_DESTROY, x, y, x, y, -1};
+		mChanges.push_back(change);
+	}
+
+	void moveWall(int fromX, int fromY, int toX, int toY) {
+		Change change = {CHANGE_MOVE, fromX, fromY, toX, toY, -1};
+		mChanges.push_back(change);
+	}
+
+	void clear() { mChanges.clear(); }
+};
+
+#endif
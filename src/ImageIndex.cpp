@@ -0,0 +1,135 @@
+#include "ImageIndex.h"
+
+#include "AssetArchive.h"
+#include "BakedImage.h"
+#include <soil/stb_image_aug.h>
+#include <cctype>
+#include <set>
+#include <vector>
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <dirent.h>
+#endif
+
+using namespace std;
+
+static const char* kImageExtensions[] = {".png", ".jpg", ".jpeg"};
+
+static bool isImage(const string& name) {
+	auto dot = name.rfind('.');
+	if (dot == string::npos) {
+		return false;
+	}
+
+	string extension = name.substr(dot);
+	for (auto& c : extension) {
+		c = (char)tolower(c);
+	}
+
+	for (auto imageExtension : kImageExtensions) {
+		if (extension == imageExtension) {
+			return true;
+		}
+	}
+
+	return false;
+}
+
+/** Lists the names of the regular files in a directory */
+static vector<string> listFiles(const char* directory) {
+	vector<string> names;
+
+#ifdef _WIN32
+	WIN32_FIND_DATAA found;
+	HANDLE find = FindFirstFileA((string(directory) + "\\*").c_str(), &found);
+	if (find == INVALID_HANDLE_VALUE) {
+		return names;
+	}
+
+	do {
+		if (!(found.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY)) {
+			names.push_back(found.cFileName);
+		}
+	} while (FindNextFileA(find, &found));
+
+	FindClose(find);
+#else
+	DIR* dir = opendir(directory);
+	if (!dir) {
+		return names;
+	}
+
+	while (auto entry = readdir(dir)) {
+		if (entry->d_type == DT_REG || entry->d_type == DT_LNK || entry->d_type == DT_UNKNOWN) {
+			names.push_back(entry->d_name);
+		}
+	}
+
+	closedir(dir);
+#endif
+
+	return names;
+}
+
+bool hasCurrentBakedImage(const string& path) {
+	auto bakedTime = AssetFile::getModifiedTime(getBakedPath(path).c_str());
+	return bakedTime >= 0 && bakedTime >= AssetFile::getModifiedTime(path.c_str());
+}
+
+bool readImageInfo(const string& path, ImageInfo& info) {
+	AssetFile file;
+	BakedImageInfo bakedInfo;
+	if (hasCurrentBakedImage(path) && file.open(getBakedPath(path).c_str()) && readBakedImageInfo(file.getData(), file.getSize(), bakedInfo)) {
+		info.width = bakedInfo.width;
+		info.height = bakedInfo.height;
+		info.channels = 4;
+		info.baked = true;
+		return true;
+	}
+
+	if (!file.open(path.c_str())) {
+		return false;
+	}
+
+	info.baked = false;
+	return stbi_info_from_memory(file.getData(), (int)file.getSize(), &info.width, &info.height, &info.channels) != 0;
+}
+
+int ImageIndex::scan(const char* directory) {
+	// Both the loose files and those in the archive, which may be stale or missing some of them
+	set<string> paths;
+	for (auto& name : listFiles(directory)) {
+		paths.insert(string(directory) + "/" + name);
+	}
+
+	for (auto& path : gArchive.list(directory)) {
+		paths.insert(path);
+	}
+
+	int numAdded = 0;
+	for (auto& path : paths) {
+		if (isImage(path) && add(path)) {
+			++numAdded;
+		}
+	}
+
+	return numAdded;
+}
+
+bool ImageIndex::add(const string& path) {
+	ImageInfo info;
+	if (!readImageInfo(path, info)) {
+		return false;
+	}
+
+	mImages[path] = info;
+	return true;
+}
+
+const ImageInfo* ImageIndex::find(const string& path) const {
+	auto image = mImages.find(path);
+	return image != mImages.end() ? &image->second : nullptr;
+}
@@ -0,0 +1,45 @@
+#ifndef IMAGE_INDEX_H
+#define IMAGE_INDEX_H
+
+#include <string>
+#include <unordered_map>
+
+/** The size of an image, read from its header or from its baked version */
+struct ImageInfo {
+	int width, height;
+	int channels; // Of the source image, or 4 if baked
+	bool baked;
+};
+
+/**
+ * Returns true if the image has a baked version that is at least as new as the image itself,
+ * so that an image edited since it was baked is loaded from the image until it's baked again
+ */
+bool hasCurrentBakedImage(const std::string& path);
+
+/** Maps an image, or its baked version if it's current, from gArchive or the loose files, and reads its size from the header without decoding anything */
+bool readImageInfo(const std::string& path, ImageInfo& info);
+
+/**
+ * Index of the images in the data directories
+ * Only the headers of the images are read, which is cheap enough to index the whole data
+ * directory at startup. Only JPEG and PNG images, and images that have been baked, are indexed.
+ */
+class ImageIndex {
+private:
+	std::unordered_map<std::string, ImageInfo> mImages;
+
+public:
+	/** Indexes the images directly inside a directory, or in gArchive under it, as directory/name. Returns how many were indexed. */
+	int scan(const char* directory);
+
+	/** Indexes a single image. Returns false if it can't be read. */
+	bool add(const std::string& path);
+
+	/** Returns nullptr if the image isn't indexed */
+	const ImageInfo* find(const std::string& path) const;
+
+	size_t size() const { return mImages.size(); }
+};
+
+#endif
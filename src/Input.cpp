@@ -22,6 +22,8 @@ PlayerInputState::PlayerInputState() {
 Input::Input() :
 	mInputStates(kMaxLocalPlayers)
 {
+	mAppliedEvents.reserve(16);
+
 	// Setup the names of mappable special keys
 	mNameKeyMap["unmapped"] = GLFW_KEY_UNKNOWN;
 	mNameKeyMap[""] = GLFW_KEY_UNKNOWN;
@@ -113,6 +115,12 @@ bool Input::isActive(int playerId, PlayerInput input) const {
 	return mInputStates[playerId].current[input];
 }
 
+void Input::setActive(int playerId, PlayerInput input, bool active) {
+	assert(input < INPUT_COUNT);
+	assert(playerId < kMaxLocalPlayers);
+	mInputStates[playerId].current[input] = active;
+}
+
 bool Input::isActive(PlayerInput input) const {
 	bool result = false;
 
@@ -157,21 +165,88 @@ bool Input::justDeactivated(PlayerInput input) const {
 	return result;
 }
 
-void Input::update(GLFWwindow* window) {
+bool Input::pushKeyEvent(double time, int key, int action, int mods) {
+	InputEvent event = {time, key, action, mods, false};
+	return mEvents.push(event);
+}
+
+bool Input::releaseAll(double time) {
+	InputEvent event = {time, GLFW_KEY_UNKNOWN, GLFW_RELEASE, 0, true};
+	return mEvents.push(event);
+}
+
+void Input::update(double time) {
 	for (auto& state : mInputStates) {
 		for (int i = 0; i < INPUT_COUNT; ++i) {
 			state.previous[i] = state.current[i];
-			state.current[i] = false;
 		}
 	}
 
-	for (auto& p : mKeyMap) {
-		auto key = p.first;
-		auto& axis = p.second;
-		mInputStates[axis.playerId].current[axis.input] = glfwGetKey(window, key) == GLFW_PRESS;
+	mAppliedEvents.clear();
+
+	// Apply the events in the order they were received. If an event can't be applied
+	// this tick then it and every event after it are left for the next tick.
+	while (auto event = mEvents.front()) {
+		if (event->time > time || !applyEvent(*event)) {
+			break;
+		}
+
+		if (!event->releaseAll) {
+			mAppliedEvents.push_back(*event);
+		}
+
+		mEvents.pop();
 	}
 }
 
+/**
+ * Applies an event to the current input state
+ * @return false if the event changes an input that already changed during this tick.
+ *   Deferring the event keeps a press and release shorter than a tick from cancelling out,
+ *   so justActivated and justDeactivated are still reported on consecutive ticks.
+ */
+bool Input::applyEvent(const InputEvent& event) {
+	if (event.action == GLFW_REPEAT) {
+		return true;
+	}
+
+	if (event.releaseAll) {
+		for (auto& state : mInputStates) {
+			for (int i = 0; i < INPUT_COUNT; ++i) {
+				if (state.current[i] && state.current[i] != state.previous[i]) {
+					return false;
+				}
+			}
+		}
+
+		for (auto& state : mInputStates) {
+			for (int i = 0; i < INPUT_COUNT; ++i) {
+				state.current[i] = false;
+			}
+		}
+
+		return true;
+	}
+
+	auto it = mKeyMap.find(event.key);
+	if (it == mKeyMap.end()) {
+		return true;
+	}
+
+	auto& axis = it->second;
+	auto& state = mInputStates[axis.playerId];
+	bool active = event.action == GLFW_PRESS;
+
+	if (state.current[axis.input] == active) {
+		return true;
+	} else if (state.current[axis.input] != state.previous[axis.input]) {
+		return false;
+	}
+
+	state.current[axis.input] = active;
+	return true;
+}
+
 void Input::clearMappings() {
 	mInputTypeMap.clear();
 	mKeyMap.clear();
@@ -1,6 +1,7 @@
 #ifndef INPUT_H
 #define INPUT_H
 
+#include "SpscQueue.h"
 #include <map>
 #include <string>
 #include <vector>
@@ -28,6 +29,15 @@ struct PlayerInputState {
 	PlayerInputState();
 };
 
+/** A key event as received from the window system, stamped with the time it was received */
+struct InputEvent {
+	double time;
+	int key;
+	int action;
+	int mods;
+	bool releaseAll; // Set by Input::releaseAll, which isn't a key event at all
+};
+
 struct InputAxis {
 	int playerId;
 	PlayerInput input;
@@ -56,7 +66,6 @@ inline bool operator<(const JoyAxis& a, const JoyAxis& b) {
 	return a.joyId < b.joyId || a.axis < b.axis || a.sign < b.sign;
 }
 
-struct GLFWwindow;
 class ConfigSection;
 
 class Input {
@@ -67,6 +76,8 @@ private:
 	std::map<JoyButton, InputAxis> mJoyButtonMap;
 	std::map<JoyAxis, InputAxis> mJoyAxisMap;
 	std::vector<PlayerInputState> mInputStates;
+	SpscQueue<InputEvent, 256> mEvents;
+	std::vector<InputEvent> mAppliedEvents;
 
 public:
 	static const int kMaxLocalPlayers = 4;
@@ -80,7 +91,26 @@ public:
 	bool justDeactivated(int playerId, PlayerInput input) const;
 	bool justDeactivated(PlayerInput input) const;
 
-	void update(GLFWwindow* window);
+	/** Sets an input directly, for players that aren't controlled by a person. Lasts until changed again. */
+	void setActive(int playerId, PlayerInput input, bool active);
+
+	/**
+	 * Queues a key event to be applied by the tick that spans its timestamp.
+	 * May be called from a different thread than update(). Returns false if the queue is full.
+	 */
+	bool pushKeyEvent(double time, int key, int action, int mods);
+
+	/** Queues an event that deactivates every input, e.g. when focus moves to the console */
+	bool releaseAll(double time);
+
+	/**
+	 * Advances the input state by one tick, applying the queued events that happened
+	 * before the specified end time of the tick in the order they were received.
+	 */
+	void update(double time);
+
+	/** The key events that were applied by the last update, including unmapped keys */
+	const std::vector<InputEvent>& getAppliedEvents() const { return mAppliedEvents; }
 
 	void clearMappings();
 	void addKeyMapping(int code, int playerId, PlayerInput input);
@@ -90,6 +120,7 @@ public:
 	void loadMappingFromConfig();
 
 private:
+	bool applyEvent(const InputEvent& event);
 	void loadInputFromConfig(ConfigSection& config, int playerId, const char* inputName, PlayerInput input);
 };
 
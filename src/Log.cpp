@@ -0,0 +1,173 @@
+#include "Log.h"
+
+#include "DebugConsole.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+
+using namespace std;
+
+Logger gLog;
+
+static const chrono::milliseconds kIdleSleep(5);
+
+static const char* getLevelName(int level) {
+	switch (level) {
+	case LOG_LEVEL_DEBUG: return "debug";
+	case LOG_LEVEL_INFO: return "info";
+	case LOG_LEVEL_WARNING: return "warning";
+	case LOG_LEVEL_ERROR: return "error";
+	default: return "";
+	}
+}
+
+Logger::Logger() :
+	mLevel(LOG_MIN_LEVEL),
+	mNumDropped(0),
+	mRunning(false)
+{
+}
+
+Logger::~Logger() {
+	stop();
+}
+
+void Logger::start(const char* path) {
+	if (mRunning) {
+		return;
+	}
+
+	if (path && *path) {
+		mFile.open(path);
+		if (!mFile) {
+			printf("Failed to open log file %s\n", path);
+		}
+	}
+
+	mRunning = true;
+	mThread = thread(&Logger::run, this);
+}
+
+void Logger::stop() {
+	mRunning = false;
+	if (mThread.joinable()) {
+		mThread.join();
+	}
+
+	// Pick up anything logged after the thread's last check
+	drain();
+	mFile.close();
+}
+
+void Logger::setConsole(shared_ptr<AbstractDebugConsole> console) {
+	lock_guard<mutex> lock(mConsoleMutex);
+	mConsole = move(console);
+}
+
+void Logger::write(int level, const char* format, ...) {
+	va_list args;
+	va_start(args, format);
+	vwrite(level, format, args);
+	va_end(args);
+}
+
+void Logger::vwrite(int level, const char* format, va_list args) {
+	if (!isEnabled(level)) {
+		return;
+	}
+
+	LogRecord record;
+	record.time = glfwGetTime();
+	record.level = level;
+	record.length = vsnprintf(record.text, sizeof(record.text), format, args);
+	if (record.length < 0) {
+		return;
+	}
+	record.length = min(record.length, LogRecord::kMaxLength - 1);
+
+	if (!mRecords.push(record)) {
+		++mNumDropped;
+	}
+}
+
+void Logger::writeText(int level, const char* text, int length) {
+	if (!isEnabled(level)) {
+		return;
+	}
+
+	LogRecord record;
+	record.time = glfwGetTime();
+	record.level = level;
+	record.length = min(length, LogRecord::kMaxLength - 1);
+	copy(text, text + record.length, record.text);
+	record.text[record.length] = 0;
+
+	if (!mRecords.push(record)) {
+		++mNumDropped;
+	}
+}
+
+void Logger::writeToSinks(const LogRecord& record) {
+	if (mFile.is_open()) {
+		char prefix[32];
+		snprintf(prefix, sizeof(prefix), "[%10.3f] %-7s ", record.time, getLevelName(record.level));
+		mFile << prefix;
+		mFile.write(record.text, record.length);
+		mFile << '\n';
+	}
+
+	lock_guard<mutex> lock(mConsoleMutex);
+	if (mConsole) {
+		if (record.level >= LOG_LEVEL_WARNING) {
+			mConsole->print("%s: %s", getLevelName(record.level), record.text);
+		} else {
+			mConsole->print("%s", record.text);
+		}
+	}
+}
+
+bool Logger::drain() {
+	bool wroteAny = false;
+
+	while (auto record = mRecords.front()) {
+		writeToSinks(*record);
+		mRecords.pop();
+		wroteAny = true;
+	}
+
+	unsigned int numDropped = mNumDropped.exchange(0);
+	if (numDropped > 0) {
+		LogRecord record;
+		record.time = glfwGetTime();
+		record.level = LOG_LEVEL_WARNING;
+		record.length = snprintf(record.text, sizeof(record.text), "%u log messages were dropped", numDropped);
+		writeToSinks(record);
+		wroteAny = true;
+	}
+
+	if (wroteAny) {
+		mFile.flush();
+	}
+
+	return wroteAny;
+}
+
+void Logger::run() {
+	while (mRunning) {
+		if (!drain()) {
+			this_thread::sleep_for(kIdleSleep);
+		}
+	}
+}
+
+LogStream::LogStream(int level) :
+	ostream(this),
+	mLevel(level)
+{
+	setp(mBuffer, mBuffer + sizeof(mBuffer) - 1);
+}
+
+LogStream::~LogStream() {
+	gLog.writeText(mLevel, pbase(), (int)(pptr() - pbase()));
+}
@@ -0,0 +1,133 @@
+#ifndef LOG_H
+#define LOG_H
+
+#include "MpscQueue.h"
+#include <atomic>
+#include <cstdarg>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <ostream>
+#include <streambuf>
+#include <thread>
+
+#define LOG_LEVEL_DEBUG 0
+#define LOG_LEVEL_INFO 1
+#define LOG_LEVEL_WARNING 2
+#define LOG_LEVEL_ERROR 3
+#define LOG_LEVEL_NONE 4
+
+// Messages below this level are compiled out entirely
+#ifndef LOG_MIN_LEVEL
+#ifdef NDEBUG
+#define LOG_MIN_LEVEL LOG_LEVEL_INFO
+#else
+#define LOG_MIN_LEVEL LOG_LEVEL_DEBUG
+#endif
+#endif
+
+class AbstractDebugConsole;
+
+struct LogRecord {
+	static const int kMaxLength = 256;
+
+	double time;
+	int level;
+	int length;
+	char text[kMaxLength];
+};
+
+/**
+ * Asynchronous logger
+ * Any thread can write a message, which is formatted on the calling thread into a record and
+ * pushed onto a lock-free queue. A background thread writes the records to the log file and
+ * prints them to the debug console. Writing never blocks: if the queue is full the message is
+ * dropped and counted, and the number of dropped messages is logged once there is room again.
+ */
+class Logger {
+private:
+	static const size_t kQueueCapacity = 1024;
+
+	MpscQueue<LogRecord, kQueueCapacity> mRecords;
+	std::atomic<int> mLevel;
+	std::atomic<unsigned int> mNumDropped;
+	std::atomic<bool> mRunning;
+	std::thread mThread;
+	std::ofstream mFile;
+	std::mutex mConsoleMutex; // Only taken by the logging thread and setConsole
+	std::shared_ptr<AbstractDebugConsole> mConsole;
+
+	Logger(const Logger&) = delete;
+	Logger(Logger&&) = delete;
+
+	void run();
+	void writeToSinks(const LogRecord& record);
+	bool drain();
+
+public:
+	Logger();
+	~Logger();
+
+	bool isEnabled(int level) const { return level >= mLevel.load(std::memory_order_relaxed); }
+	void setLevel(int level) { mLevel = level; }
+
+	/** Opens the log file, which may be null to only log to the console, and starts the logging thread */
+	void start(const char* path);
+
+	/** Writes out all messages logged so far and stops the logging thread */
+	void stop();
+
+	/** Sets the console messages are printed to. May be null. */
+	void setConsole(std::shared_ptr<AbstractDebugConsole> console);
+
+	/** Logs a message using printf syntax */
+	void write(int level, const char* format, ...);
+	void vwrite(int level, const char* format, va_list args);
+
+	/** Logs already formatted text */
+	void writeText(int level, const char* text, int length);
+};
+
+extern Logger gLog;
+
+/**
+ * ostream that formats one message into a fixed size buffer and logs it when destroyed
+ * Use through the LOG macro: LOG(LOG_LEVEL_INFO) << "Player " << id << " died";
+ */
+class LogStream : private std::streambuf, public std::ostream {
+private:
+	int mLevel;
+	char mBuffer[LogRecord::kMaxLength];
+
+public:
+	LogStream(int level);
+	~LogStream();
+};
+
+#define LOG(level) if ((level) < LOG_MIN_LEVEL || !gLog.isEnabled(level)) {} else LogStream(level)
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_DEBUG
+#define LOG_DEBUG(...) (gLog.isEnabled(LOG_LEVEL_DEBUG) ? gLog.write(LOG_LEVEL_DEBUG, __VA_ARGS__) : (void)0)
+#else
+#define LOG_DEBUG(...) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_INFO
+#define LOG_INFO(...) (gLog.isEnabled(LOG_LEVEL_INFO) ? gLog.write(LOG_LEVEL_INFO, __VA_ARGS__) : (void)0)
+#else
+#define LOG_INFO(...) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_WARNING
+#define LOG_WARNING(...) (gLog.isEnabled(LOG_LEVEL_WARNING) ? gLog.write(LOG_LEVEL_WARNING, __VA_ARGS__) : (void)0)
+#else
+#define LOG_WARNING(...) ((void)0)
+#endif
+
+#if LOG_MIN_LEVEL <= LOG_LEVEL_ERROR
+#define LOG_ERROR(...) (gLog.isEnabled(LOG_LEVEL_ERROR) ? gLog.write(LOG_LEVEL_ERROR, __VA_ARGS__) : (void)0)
+#else
+#define LOG_ERROR(...) ((void)0)
+#endif
+
+#endif
@@ -1,63 +1,183 @@
+#include "AssetArchive.h"
+#include "AssetCache.h"
+#include "CommandRegistry.h"
 #include "Config.h"
 #include "DebugFont.h"
 #include "DebugConsole.h"
+#include "FrameCapture.h"
+#include "FramePacer.h"
+#include "GLExtensions.h"
+#include "GridRenderer.h"
 #include "Input.h"
+#include "Log.h"
 #include "SceneGameSetup.h"
+#include "Simulation.h"
+#include "WorkerPool.h"
 #include <GLFW/glfw3.h>
 #include <SOIL/SOIL.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
 #include <cstdlib>
+#include <ctime>
 #include <iostream>
 #include <memory>
 #include <sstream>
 
-#ifdef WIN32
-extern "C" void __stdcall Sleep(int millis);
-#endif
-
 using namespace std;
 
-void run(GLFWwindow* window) {
-	double fixedTimeStep = 1 / 60.f;
-	double accumulatedTime = 0.;
-	double lastFrameTime = glfwGetTime();
+static const double kStatsSmoothing = 0.05;
+static const double kStatsUpdateInterval = 0.25;
 
-	while (!glfwWindowShouldClose(window) && !gScenes->isEmpty()) {
-		accumulatedTime += glfwGetTime() - lastFrameTime;
-		lastFrameTime = glfwGetTime();
+/** Render thread statistics, shown by the stats overlay and the timings command */
+static struct FrameStats {
+	atomic<bool> visible;
+	atomic<double> averageInterval;
+	atomic<double> averageCost;
+	double lastFrameTime;
+	double nextUpdateTime;
+	char text[128];
+} sFrameStats;
 
-		while (accumulatedTime >= fixedTimeStep) {
-			accumulatedTime -= fixedTimeStep;
+static void renderStats(double now) {
+	// Only change the text a few times a second so that it's readable
+	if (now >= sFrameStats.nextUpdateTime) {
+		sFrameStats.nextUpdateTime = now + kStatsUpdateInterval;
+		double interval = sFrameStats.averageInterval;
+		snprintf(sFrameStats.text, sizeof(sFrameStats.text), "%.0f fps  frame %.2f ms  step %.2f ms",
+			interval > 0. ? 1. / interval : 0., sFrameStats.averageCost * 1000., gSimulation->getAverageStepCost() * 1000.);
+	}
 
-			if (!gConsole->isOpen()) {
-				gInput.update(window);
-			}
+	GLint viewport[4];
+	glGetIntegerv(GL_VIEWPORT, viewport);
+
+	glMatrixMode(GL_PROJECTION);
+	glLoadIdentity();
+	glOrtho(0., viewport[2], 0., viewport[3], -1., 1.);
+	glMatrixMode(GL_MODELVIEW);
+	glPushMatrix();
+	glLoadIdentity();
+	glTranslatef((float)DebugFont::kGlyphWidth, (float)(viewport[3] - DebugFont::kGlyphHeight * 2), 0.f);
+	glColor4f(1.f, 1.f, 1.f, 1.f);
+	gDebugFont->renderString(sFrameStats.text);
+	glPopMatrix();
+	gDebugFont->flush();
+}
+
+static void registerCommands() {
+	gCommands.addCommand("stats", "", "Shows or hides the frame statistics overlay", [](const CommandRegistry::Arguments& args) {
+		sFrameStats.visible = !sFrameStats.visible;
+	});
+
+	gCommands.addCommand("timings", "", "Prints the average cost of each part of a frame and step", [](const CommandRegistry::Arguments& args) {
+		double ms = 1000.;
+		CommandRegistry::print("render: interval %.2f ms, cost %.2f ms", sFrameStats.averageInterval * ms, sFrameStats.averageCost * ms);
+		CommandRegistry::print("step: %.3f ms (input %.3f, update %.3f, snapshot %.3f)",
+			gSimulation->getAverageStepCost() * ms, gSimulation->getAverageInputCost() * ms,
+			gSimulation->getAverageUpdateCost() * ms, gSimulation->getAverageSnapshotCost() * ms);
+	});
+
+	gCommands.addCommand("screenshot", "[path]", "Saves the next frame as TGA, or BMP or DDS by extension", [](const CommandRegistry::Arguments& args) {
+		string path;
+		if (args.size() > 1) {
+			path = args[1];
+		} else {
+			char name[64];
+			time_t now = time(nullptr);
+			strftime(name, sizeof(name), "screenshot-%Y%m%d-%H%M%S.tga", localtime(&now));
+			path = name;
+		}
+
+		gFrameCapture->requestScreenshot(path);
+		CommandRegistry::print("Saving %s", path.c_str());
+	});
 
-			gScenes->update((float)fixedTimeStep);
+	gCommands.addCommand("record", "[prefix]", "Starts or stops saving every frame as prefix-00000.tga, etc.", [](const CommandRegistry::Arguments& args) {
+		if (gFrameCapture->isRecording()) {
+			int numRecorded, numDropped;
+			gFrameCapture->stopRecording(numRecorded, numDropped);
+			CommandRegistry::print("Recorded %d frames, dropped %d", numRecorded, numDropped);
+		} else {
+			gFrameCapture->startRecording(args.size() > 1 ? args[1] : "capture");
+		}
+	});
+}
+
+void run(GLFWwindow* window, FramePacer& pacer) {
+	SimulationFrame previousFrame;
+	SimulationFrame currentFrame;
+	SimulationFrame newFrame;
+
+	gSimulation->start();
+
+	while (!glfwWindowShouldClose(window) && gSimulation->isRunning()) {
+		pacer.wait();
+		glfwPollEvents();
+		gAssets->update();
+
+		// Keep the two most recent steps to interpolate between
+		if (gSimulation->pollFrame(newFrame)) {
+			previousFrame = move(currentFrame);
+			currentFrame = move(newFrame);
 		}
 
 		glClear(GL_COLOR_BUFFER_BIT);
 
-		gScenes->render();
+		if (currentFrame.scene) {
+			// Render one step behind the simulation, blending by the time elapsed since the latest step
+			float alpha = 1.f;
+			double stepTime = currentFrame.time - previousFrame.time;
+			if (previousFrame.scene && stepTime > 0.) {
+				alpha = (float)((glfwGetTime() - currentFrame.time) / stepTime);
+				alpha = min(max(alpha, 0.f), 1.f);
+			}
+
+			currentFrame.scene->render(previousFrame.scene.get(), alpha);
+		}
+
+		// Draw the scene's text in one batch, beneath the console
+		gDebugFont->flush();
+
+		if (sFrameStats.visible) {
+			renderStats(glfwGetTime());
+		}
+
 		gConsole->render();
 
+		int framebufferWidth, framebufferHeight;
+		glfwGetFramebufferSize(window, &framebufferWidth, &framebufferHeight);
+		gFrameCapture->update(framebufferWidth, framebufferHeight);
+
+		pacer.endWork();
 		glfwSwapBuffers(window);
-		glfwPollEvents();
-#ifdef WIN32
-		Sleep(1);
-#endif
+		pacer.presented();
+
+		double now = glfwGetTime();
+		if (sFrameStats.lastFrameTime > 0.) {
+			sFrameStats.averageInterval = sFrameStats.averageInterval + (now - sFrameStats.lastFrameTime - sFrameStats.averageInterval) * kStatsSmoothing;
+		}
+		sFrameStats.lastFrameTime = now;
+		sFrameStats.averageCost = pacer.getAverageCost();
 	}
+
+	gSimulation->stop();
 }
 
 void onKeyEvent(GLFWwindow* window, int key, int scancode, int action, int mods) {
-	// Pass the event to the current scene
+	// Pass the event to the simulation, which forwards it to the current scene
 	if (!gConsole->isOpen()) {
-		gScenes->onKeyEvent(key, action, mods);
+		gInput.pushKeyEvent(glfwGetTime(), key, action, mods);
 	}
 
 	// Update the debug console based on the received key event
 	if (action == GLFW_PRESS || action == GLFW_REPEAT) {
 		if (key == GLFW_KEY_F1) {
 			gConsole->toggleOpen();
+
+			// Keys released while the console is open are never seen by the game
+			if (gConsole->isOpen()) {
+				gInput.releaseAll(glfwGetTime());
+			}
 		} else if (gConsole->isOpen()) {
 			switch (key) {
 			case GLFW_KEY_ENTER:
@@ -67,16 +187,22 @@ void onKeyEvent(GLFWwindow* window, int key, int scancode, int action, int mods)
 				gConsole->onCharacter(8);
 				break;
 			case GLFW_KEY_LEFT:
+				gConsole->onNavigationCharacter(DEBUG_CONSOLE_CURSOR_PREVIOUS);
 				break;
 			case GLFW_KEY_RIGHT:
+				gConsole->onNavigationCharacter(DEBUG_CONSOLE_CURSOR_NEXT);
 				break;
 			case GLFW_KEY_UP:
+				gConsole->onNavigationCharacter(DEBUG_CONSOLE_HISTORY_PREVIOUS);
 				break;
 			case GLFW_KEY_DOWN:
+				gConsole->onNavigationCharacter(DEBUG_CONSOLE_HISTORY_NEXT);
 				break;
 			case GLFW_KEY_PAGE_UP:
+				gConsole->onNavigationCharacter(DEBUG_CONSOLE_PAGE_UP);
 				break;
 			case GLFW_KEY_PAGE_DOWN:
+				gConsole->onNavigationCharacter(DEBUG_CONSOLE_PAGE_DOWN);
 				break;
 			}
 		}
@@ -94,15 +220,23 @@ int main() {
 		return -1;
 	}
 
+	// Read the assets from the archive if it has been packed, and from the loose files otherwise
+	gArchive.open("data.pak");
+
 	// Setup OpenGL window
 	gConfig.addFile("data/settings.ini"); // TODO: make cwd data directory
 	auto& config = gConfig["application"];
 	int width = config.getInt("width", 600);
 	int height = config.getInt("height", 600);
 	bool fullscreen = config.getBool("fullscreen");
+	auto videoMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
+
+	// Start logging
+	auto& debugConfig = gConfig["debug"];
+	gLog.setLevel(debugConfig.getInt("log-level", LOG_LEVEL_INFO));
+	gLog.start(debugConfig.getString("log-file", "isolated.log"));
 
 	if (fullscreen) {
-		auto videoMode = glfwGetVideoMode(glfwGetPrimaryMonitor());
 		width = videoMode->width;
 		height = videoMode->height;
 
@@ -123,15 +257,40 @@ int main() {
 	}
 
 	glfwMakeContextCurrent(window);
+
+	// Setup frame pacing. With vertical sync the presents pace the frames, otherwise sleep
+	// until each frame is due. A target of 0 matches the refresh rate of the display.
+	bool vsync = config.getBool("vsync", true);
+	int targetFps = config.getInt("target-fps", 0);
+	if (targetFps <= 0) {
+		targetFps = videoMode && videoMode->refreshRate > 0 ? videoMode->refreshRate : 60;
+	}
+
+	glfwSwapInterval(vsync ? 1 : 0);
+	FramePacer pacer;
+	pacer.setInterval(1. / targetFps);
+	pacer.setLowLatency(config.getBool("low-latency"));
+	pacer.setSyncToPresent(vsync);
+
 	glfwSetKeyCallback(window, onKeyEvent);
 	glfwSetCharCallback(window, onCharacterEvent);
 
-	// Initialize the debug font
+	gGLExtensions.load();
+
+	// Initialize the asset cache and the debug font
+	gWorkers.reset(new WorkerPool());
+	gAssets.reset(new AssetCache());
+	gAssets->indexDirectory("data");
+	gFrameCapture.reset(new FrameCapture());
 	gDebugFont.reset(new DebugFont());
-	int fontScale = gConfig["debug"].getInt("console-font-scale", 2);
+	int fontScale = debugConfig.getInt("console-font-scale", 2);
 
 	// Initialize the console
 	gConsole.reset(new DebugConsole(width, height / 2, width, height, fontScale));
+	gLog.setConsole(gConsole);
+
+	// Initialize the renderers
+	gGridRenderer.reset(new GridRenderer());
 
 	// Initialize the input mappings
 	gConfig.addFile("data/controls.ini");
@@ -141,11 +300,22 @@ int main() {
 	gScenes.reset(new SceneStack());
 	gScenes->push(make_shared<SceneGameSetup>(width, height));
 
-	run(window);
+	// Initialize the simulation and the console commands it runs
+	gSimulation.reset(new Simulation(1 / 60., config.getDouble("max-frame-time", 0.25)));
+	registerCommands();
+
+	run(window, pacer);
 
+	gSimulation.reset();
 	gScenes.reset();
+	gLog.stop();
+	gLog.setConsole(nullptr);
+	gGridRenderer.reset();
 	gDebugFont.reset();
 	gConsole.reset();
+	gFrameCapture.reset();
+	gAssets.reset();
+	gWorkers.reset();
 	glfwTerminate();
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,145 @@
+#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+using namespace std;
+
+#ifdef _WIN32
+
+MappedFile::MappedFile() :
+	mData(nullptr),
+	mSize(0),
+	mFile(INVALID_HANDLE_VALUE),
+	mMapping(nullptr)
+{
+}
+
+bool MappedFile::open(const char* path) {
+	close();
+
+	mFile = CreateFileA(path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+	if (mFile == INVALID_HANDLE_VALUE) {
+		return false;
+	}
+
+	LARGE_INTEGER size;
+	if (!GetFileSizeEx(mFile, &size) || size.QuadPart == 0) {
+		close();
+		return false;
+	}
+
+	mMapping = CreateFileMappingA(mFile, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (!mMapping) {
+		close();
+		return false;
+	}
+
+	mData = (const unsigned char*)MapViewOfFile(mMapping, FILE_MAP_READ, 0, 0, 0);
+	if (!mData) {
+		close();
+		return false;
+	}
+
+	mSize = (size_t)size.QuadPart;
+	return true;
+}
+
+void MappedFile::close() {
+	if (mData) {
+		UnmapViewOfFile(mData);
+	}
+
+	if (mMapping) {
+		CloseHandle(mMapping);
+	}
+
+	if (mFile != INVALID_HANDLE_VALUE) {
+		CloseHandle(mFile);
+	}
+
+	mData = nullptr;
+	mSize = 0;
+	mFile = INVALID_HANDLE_VALUE;
+	mMapping = nullptr;
+}
+
+long long MappedFile::getModifiedTime(const char* path) {
+	WIN32_FILE_ATTRIBUTE_DATA info;
+	if (!GetFileAttributesExA(path, GetFileExInfoStandard, &info)) {
+		return -1;
+	}
+
+	return (long long)info.ftLastWriteTime.dwHighDateTime << 32 | info.ftLastWriteTime.dwLowDateTime;
+}
+
+#else
+
+MappedFile::MappedFile() :
+	mData(nullptr),
+	mSize(0),
+	mFile(-1)
+{
+}
+
+bool MappedFile::open(const char* path) {
+	close();
+
+	mFile = ::open(path, O_RDONLY);
+	if (mFile < 0) {
+		return false;
+	}
+
+	// Empty files can't be mapped
+	struct stat info;
+	if (fstat(mFile, &info) != 0 || info.st_size == 0) {
+		close();
+		return false;
+	}
+
+	void* data = mmap(nullptr, (size_t)info.st_size, PROT_READ, MAP_PRIVATE, mFile, 0);
+	if (data == MAP_FAILED) {
+		close();
+		return false;
+	}
+
+	mData = (const unsigned char*)data;
+	mSize = (size_t)info.st_size;
+	return true;
+}
+
+void MappedFile::close() {
+	if (mData) {
+		munmap((void*)mData, mSize);
+	}
+
+	if (mFile >= 0) {
+		::close(mFile);
+	}
+
+	mData = nullptr;
+	mSize = 0;
+	mFile = -1;
+}
+
+long long MappedFile::getModifiedTime(const char* path) {
+	struct stat info;
+	if (stat(path, &info) != 0) {
+		return -1;
+	}
+
+	return (long long)info.st_mtime;
+}
+
+#endif
+
+MappedFile::~MappedFile() {
+	close();
+}
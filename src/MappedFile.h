@@ -0,0 +1,41 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+
+/**
+ * A file mapped read-only into memory
+ * The operating system pages the contents in as they are touched, so opening a file costs
+ * about the same whatever its size and nothing is copied into the process.
+ */
+class MappedFile {
+private:
+	const unsigned char* mData;
+	size_t mSize;
+#ifdef _WIN32
+	void* mFile;
+	void* mMapping;
+#else
+	int mFile;
+#endif
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile(MappedFile&&) = delete;
+
+public:
+	MappedFile();
+	~MappedFile();
+
+	/** Maps the whole file, closing any file mapped before. Returns false if it can't be mapped. */
+	bool open(const char* path);
+	void close();
+
+	bool isOpen() const { return mData != nullptr; }
+	const unsigned char* getData() const { return mData; }
+	size_t getSize() const { return mSize; }
+
+	/** Returns when a file was last written, only to be compared with other times from here, or -1 if it doesn't exist */
+	static long long getModifiedTime(const char* path);
+};
+
+#endif
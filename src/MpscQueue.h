@@ -0,0 +1,88 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Bounded lock-free queue for any number of producer threads and one consumer thread.
+ * Each slot carries a sequence number that tells producers when it is free to write and the
+ * consumer when it has been written, so producers only contend on claiming a position.
+ * Capacity must be a power of two. Pushing onto a full queue fails instead of blocking.
+ */
+template <typename T, size_t Capacity>
+class MpscQueue {
+private:
+	static_assert((Capacity & (Capacity - 1)) == 0, "MpscQueue capacity must be a power of two");
+
+	struct Slot {
+		std::atomic<size_t> sequence;
+		T item;
+	};
+
+	Slot mSlots[Capacity];
+	std::atomic<size_t> mTail; // Next position to be claimed by a producer
+	size_t mHead;              // Next position to be read, only used by the consumer
+
+	MpscQueue(const MpscQueue&) = delete;
+	MpscQueue(MpscQueue&&) = delete;
+
+	/** Claims the next free slot, or returns nullptr if the queue is full */
+	Slot* claim(size_t& position) {
+		position = mTail.load(std::memory_order_relaxed);
+		for (;;) {
+			auto& slot = mSlots[position & (Capacity - 1)];
+			auto sequence = slot.sequence.load(std::memory_order_acquire);
+			auto difference = (ptrdiff_t)sequence - (ptrdiff_t)position;
+
+			if (difference == 0) {
+				if (mTail.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+					return &slot;
+				}
+			} else if (difference < 0) {
+				return nullptr;
+			} else {
+				position = mTail.load(std::memory_order_relaxed);
+			}
+		}
+	}
+
+public:
+	MpscQueue() : mTail(0), mHead(0) {
+		for (size_t i = 0; i < Capacity; ++i) {
+			mSlots[i].sequence.store(i, std::memory_order_relaxed);
+		}
+	}
+
+	/** Called by producers. Returns false if the queue is full. */
+	bool push(const T& item) {
+		size_t position;
+		auto slot = claim(position);
+		if (!slot) {
+			return false;
+		}
+
+		slot->item = item;
+		slot->sequence.store(position + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** Called by the consumer. Returns nullptr if the queue is empty. */
+	const T* front() const {
+		auto& slot = mSlots[mHead & (Capacity - 1)];
+		if (slot.sequence.load(std::memory_order_acquire) != mHead + 1) {
+			return nullptr;
+		}
+
+		return &slot.item;
+	}
+
+	/** Called by the consumer to discard the item returned by front() */
+	void pop() {
+		auto& slot = mSlots[mHead & (Capacity - 1)];
+		slot.sequence.store(mHead + Capacity, std::memory_order_release);
+		++mHead;
+	}
+};
+
+#endif
@@ -0,0 +1,33 @@
+#include "AssetArchive.h"
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+using namespace std;
+
+/**
+ * isolated_pack: packs files into an archive under the paths they are given by, e.g. data/settings.ini
+ * Usage: isolated_pack archive file...
+ */
+int main(int argc, char* argv[]) {
+	if (argc < 3) {
+		fprintf(stderr, "Usage: %s archive file...\n", argv[0]);
+		return 1;
+	}
+
+	// The game looks assets up with forward slashes on every platform
+	vector<string> paths(argv + 2, argv + argc);
+	for (auto& path : paths) {
+		replace(path.begin(), path.end(), '\\', '/');
+	}
+
+	string error;
+	if (!AssetArchive::build(argv[1], paths, error)) {
+		fprintf(stderr, "Failed to pack %s: %s\n", argv[1], error.c_str());
+		return 1;
+	}
+
+	printf("Packed %d files into %s\n", (int)paths.size(), argv[1]);
+	return 0;
+}
@@ -3,16 +3,15 @@
 #include "Config.h"
 #include "Game.h"
 #include "Input.h"
-#include <GLFW/glfw3.h>
+#include "Log.h"
 #include <cmath>
-#include <iostream>
 
 using namespace std;
 
 float Player::sBuildAdvanceTime = 0.3f;
 
-Player::Player(Game& game, int entityId, int playerId) :
-	Entity(entityId, ENTITY_PLAYER),
+Player::Player(Game& game, EntityHandle handle, int playerId) :
+	Entity(handle, ENTITY_PLAYER),
 	mGame(game),
 	mState(PLAYER_NORMAL),
 	mPlayerId(playerId),
@@ -87,9 +86,9 @@ void Player::die() {
 	mState = PLAYER_NORMAL;
 	mWall.reset();
 	--mStock;
-	cout << "Player " << mPlayerId << " died, " << mStock << " lives left" << endl;
+	LOG_INFO("Player %d died, %d lives left", mPlayerId, mStock);
 	if (mStock == 0) {
-		cout << "Player " << mPlayerId << " lost" << endl;
+		LOG_INFO("Player %d lost", mPlayerId);
 	}
 }
 
@@ -152,46 +151,28 @@ void Player::update(float dt) {
 	}
 }
 
-void Player::renderDebug() const {
-	// Render the player body
-	glBegin(GL_TRIANGLES);
-	glVertex2f(position.x + 0.f, position.y);
-	glVertex2f(position.x + size.x, position.y);
-	glVertex2f(position.x + size.x / 2.f, position.y + size.y);
-	glEnd();
-
-	// Render player stock at the top of the screen
-	glPointSize(5.f);
-	glBegin(GL_POINTS);
-	float stockBarOffset = mPlayerId * 4.f;
-	for (int i = 0; i < mStock; ++i) {
-		glVertex2f(i * 0.4f + stockBarOffset, -0.5f);
-	}
-	glEnd();
+void Player::save(ostream& out) const {
+	out << position.x << ' ' << position.y << ' ' << mStock << ' ' << (int)mFacing;
+}
 
-	// Render the selection
-	if (mState == PLAYER_NORMAL) {
-		int selectionX, selectionY;
-		getSelection(selectionX, selectionY);
-
-		glColor4f(0.3f, 0.3f, 0.5f, 0.3f);
-		glBegin(GL_QUADS);
-		glVertex2i(selectionX, selectionY);
-		glVertex2i(selectionX + 1, selectionY);
-		glVertex2i(selectionX + 1, selectionY + 1);
-		glVertex2i(selectionX, selectionY + 1);
-		glEnd();
-	}
+void Player::load(istream& in) {
+	int facing = DIR_RIGHT;
+	in >> position.x >> position.y >> mStock >> facing;
+	mFacing = (Direction)facing;
+	mState = PLAYER_NORMAL;
+	mWall.reset();
+}
 
-	// Render the currently building indicator
-	if (mState == PLAYER_BUILDING || mState == PLAYER_BUILDING_ADVANCING) {
-		glColor4f(1.f, 1.f, 1.f, 0.1f);
-		glBegin(GL_LINE_STRIP);
-		glVertex2i(mWallStreamX, mWallStreamY);
-		glVertex2i(mWallStreamX + 1, mWallStreamY);
-		glVertex2i(mWallStreamX + 1, mWallStreamY + 1);
-		glVertex2i(mWallStreamX, mWallStreamY + 1);
-		glVertex2i(mWallStreamX, mWallStreamY);
-		glEnd();
-	}
+PlayerSnapshot Player::snapshot() const {
+	PlayerSnapshot snapshot;
+	snapshot.playerId = mPlayerId;
+	snapshot.stock = mStock;
+	snapshot.position = position;
+	snapshot.size = size;
+	snapshot.selecting = mState == PLAYER_NORMAL;
+	getSelection(snapshot.selectionX, snapshot.selectionY);
+	snapshot.building = mState == PLAYER_BUILDING || mState == PLAYER_BUILDING_ADVANCING;
+	snapshot.wallStreamX = mWallStreamX;
+	snapshot.wallStreamY = mWallStreamY;
+	return snapshot;
 }
\ No newline at end of file
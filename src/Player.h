@@ -1,8 +1,11 @@
 #ifndef PLAYER_H
 #define PLAYER_H
 
+#include "GameSnapshot.h"
 #include "Wall.h"
+#include <istream>
 #include <memory>
+#include <ostream>
 
 class Game;
 
@@ -34,7 +37,7 @@ public:
 	char pushStrength;
 	float speed;
 
-	Player(Game& game, int entityId, int playerId);
+	Player(Game& game, EntityHandle handle, int playerId);
 
 	int getPlayerId() const { return mPlayerId; }
 	int getStock() const { return mStock; }
@@ -50,7 +53,11 @@ public:
 
 	void update(float dt); // Handle input and move!
 
-	void renderDebug() const;
+	PlayerSnapshot snapshot() const;
+
+	/** Saves the position and stock. Players are loaded standing, not building. */
+	void save(std::ostream& out) const;
+	void load(std::istream& in);
 };
 
 typedef std::shared_ptr<Player> PlayerPtr;
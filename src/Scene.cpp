@@ -31,8 +31,6 @@ void SceneStack::update(float dt) {
 	}
 }
 
-void SceneStack::render() {
-	if (!mScenes.empty()) {
-		mScenes.top()->render();
-	}
+SceneSnapshotPtr SceneStack::snapshot() {
+	return mScenes.empty() ? nullptr : mScenes.top()->snapshot();
 }
@@ -4,8 +4,28 @@
 #include <memory>
 #include <stack>
 
+/**
+ * Immutable copy of the state a scene needs to draw itself.
+ * Snapshots are created by the simulation thread and rendered by the render thread.
+ */
+class SceneSnapshot {
+public:
+	virtual ~SceneSnapshot() {}
+
+	/**
+	 * Renders this snapshot blended with the previous one
+	 * @param previous the snapshot from an earlier step, may be null or of a different scene
+	 * @param alpha interpolation value between [0, 1] from previous to this snapshot
+	 */
+	virtual void render(const SceneSnapshot* previous, float alpha) const = 0;
+};
+
+typedef std::shared_ptr<const SceneSnapshot> SceneSnapshotPtr;
+
 class Scene {
 public:
+	virtual ~Scene() {}
+
 	virtual void onActivate() {}
 
 	virtual void onDeactivate() {}
@@ -14,7 +34,7 @@ public:
 
 	virtual void update(float dt) {}
 
-	virtual void render() {}
+	virtual SceneSnapshotPtr snapshot() { return nullptr; }
 };
 
 typedef std::shared_ptr<Scene> ScenePtr;
@@ -34,7 +54,7 @@ public:
 
 	void update(float dt);
 
-	void render();
+	SceneSnapshotPtr snapshot();
 };
 
 extern std::shared_ptr<SceneStack> gScenes;
@@ -9,10 +9,19 @@
 
 using namespace std;
 
-void DebugMenuItem::render() {
+class SceneGameSetupSnapshot : public SceneSnapshot {
+public:
+	int screenWidth;
+	int screenHeight;
+	float fontScale;
+	vector<DebugMenuLine> lines;
+
+	void render(const SceneSnapshot* previous, float alpha) const override;
+};
+
+string DebugMenuItem::getText() const {
 	auto& config = gConfig[mCategory];
-	string itemStr = (string(mKey) + ' ') + config.getString(mKey);
-	gDebugFont->renderString(itemStr.c_str());
+	return (string(mKey) + ' ') + config.getString(mKey);
 }
 
 DebugMenuItemInt::DebugMenuItemInt(const char* category, const char* key, int min, int max, bool active) :
@@ -133,23 +142,22 @@ void DebugMenu::update(float dt) {
 	mItems[mSelectionIndex]->update(dt);
 }
 
-void DebugMenu::render() {
-	glPushMatrix();
+void DebugMenu::snapshot(vector<DebugMenuLine>& lines) const {
+	lines.resize(mItems.size());
 	for (size_t i = 0; i < mItems.size(); ++i) {
 		auto item = mItems[i];
+		auto& line = lines[i];
 
 		if (!item->isActive()) {
-			glColor4fv((GLfloat*)&mDisabledColor);
+			line.color = mDisabledColor;
 		} else if (mSelectionIndex == i) {
-			glColor4fv((GLfloat*)&mSelectedColor);
+			line.color = mSelectedColor;
 		} else {
-			glColor4fv((GLfloat*)&mUnselectedColor);
+			line.color = mUnselectedColor;
 		}
 
-		item->render();
-		glTranslatef(0.f, -DebugFont::kGlyphHeight - 3.f, 0.f);
+		line.text = item->getText();
 	}
-	glPopMatrix();
 }
 
 SceneGameSetup::SceneGameSetup(int screenWidth, int screenHeight) :
@@ -187,20 +195,33 @@ void SceneGameSetup::update(float dt) {
 	}
 }
 
-void SceneGameSetup::render() {
+SceneSnapshotPtr SceneGameSetup::snapshot() {
+	auto snapshot = make_shared<SceneGameSetupSnapshot>();
+	snapshot->screenWidth = mScreenWidth;
+	snapshot->screenHeight = mScreenHeight;
+	snapshot->fontScale = mFontScale;
+	mMenu.snapshot(snapshot->lines);
+	return snapshot;
+}
+
+void SceneGameSetupSnapshot::render(const SceneSnapshot* previous, float alpha) const {
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
-	glOrtho(0., mScreenWidth / mFontScale, 0., mScreenHeight / mFontScale, -1., 1.);
+	glOrtho(0., screenWidth / fontScale, 0., screenHeight / fontScale, -1., 1.);
 	glMatrixMode(GL_MODELVIEW);
 
 	glPushMatrix();
-	glTranslatef((float)DebugFont::kGlyphWidth, (float)mScreenHeight / mFontScale - DebugFont::kGlyphHeight * 2, 0.f);
-	mMenu.render();
+	glTranslatef((float)DebugFont::kGlyphWidth, (float)screenHeight / fontScale - DebugFont::kGlyphHeight * 2, 0.f);
+	for (auto& line : lines) {
+		glColor4fv((GLfloat*)&line.color);
+		gDebugFont->renderString(line.text.c_str());
+		glTranslatef(0.f, -DebugFont::kGlyphHeight - 3.f, 0.f);
+	}
 	glPopMatrix();
 
 	glColor4f(1.f, 1.f, 1.f, 1.f);
 	glPushMatrix();
-	glTranslatef(mScreenWidth / mFontScale / 2.f, 0.f, 0.f);
+	glTranslatef(screenWidth / fontScale / 2.f, 0.f, 0.f);
 	gDebugFont->renderString("Press enter or wall to start", true);
 	glPopMatrix();
-}
\ No newline at end of file
+}
@@ -24,7 +24,7 @@ public:
 
 	virtual void update(float dt) {}
 
-	virtual void render();
+	virtual std::string getText() const;
 };
 
 class DebugMenuItemInt : public DebugMenuItem {
@@ -53,6 +53,11 @@ public:
 	void update(float dt) override;
 };
 
+struct DebugMenuLine {
+	Color color;
+	std::string text;
+};
+
 class DebugMenu {
 private:
 	int mScreenHeight;
@@ -75,7 +80,7 @@ public:
 
 	void update(float dt);
 
-	void render();
+	void snapshot(std::vector<DebugMenuLine>& lines) const;
 };
 
 class SceneGameSetup : public Scene {
@@ -98,7 +103,7 @@ public:
 
 	void update(float dt) override;
 
-	void render() override;
+	SceneSnapshotPtr snapshot() override;
 };
 
 #endif
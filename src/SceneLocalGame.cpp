@@ -1,10 +1,15 @@
 #include "SceneLocalGame.h"
 
 #include <GLFW/glfw3.h>
+#include "CommandRegistry.h"
 #include "Config.h"
 #include "Game.h"
 #include "Wall.h"
 #include "Player.h"
+#include <cstdlib>
+#include <sstream>
+
+using namespace std;
 
 void SceneLocalGame::onActivate() {
 	// Load settings from config
@@ -14,10 +19,60 @@ void SceneLocalGame::onActivate() {
 	Wall::sMaxStrength = config.getInt("wall-strength", Wall::sMaxStrength);
 	Player::sBuildAdvanceTime = config.getFloat("build-advance-time", Player::sBuildAdvanceTime);
 	mGame.reset(new Game(config.getInt("grid-size", 10), config.getInt("grid-size", 10)));
+	mGridColor = gConfig["debug"].getColor("grid-color");
+
+	gCommands.addVariable("wall-rise-time", &Wall::sRiseTime, "defaults", "Seconds for a wall to rise");
+	gCommands.addVariable("wall-fall-time", &Wall::sFallTime, "defaults", "Seconds for an unfinished wall to fall");
+	gCommands.addVariable("wall-strength", &Wall::sMaxStrength, "defaults", "Hits it takes to destroy a new wall");
+	gCommands.addVariable("build-advance-time", &Player::sBuildAdvanceTime, "defaults", "Seconds between walls while building");
+
+	gCommands.addCommand("snapshot", "[name]", "Saves the state of the game", [this](const CommandRegistry::Arguments& args) {
+		auto name = args.size() > 1 ? args[1] : "quick";
+		ostringstream out;
+		mGame->save(out);
+		mSavedGames[name] = out.str();
+		CommandRegistry::print("Saved step %u as '%s'", mGame->getStep(), name.c_str());
+	});
+
+	gCommands.addCommand("restore", "[name]", "Restores a game saved by snapshot", [this](const CommandRegistry::Arguments& args) {
+		auto name = args.size() > 1 ? args[1] : "quick";
+		auto savedGame = mSavedGames.find(name);
+		if (savedGame == mSavedGames.end()) {
+			CommandRegistry::print("No snapshot named '%s'", name.c_str());
+			return;
+		}
+
+		istringstream in(savedGame->second);
+		auto game = make_shared<Game>(in);
+		if (in.fail()) {
+			CommandRegistry::print("Snapshot '%s' is corrupt", name.c_str());
+			return;
+		}
+
+		game->setStep(mGame->getStep() + 1);
+		mGame = game;
+		CommandRegistry::print("Restored '%s'", name.c_str());
+	});
+
+	gCommands.addCommand("spawn-bot", "[count]", "Adds players controlled by the computer", [this](const CommandRegistry::Arguments& args) {
+		int count = args.size() > 1 ? atoi(args[1].c_str()) : 1;
+		for (int i = 0; i < count; ++i) {
+			if (!mGame->spawnBot()) {
+				CommandRegistry::print("The game is full");
+				break;
+			}
+		}
+	});
 }
 
 void SceneLocalGame::onDeactivate() {
-
+	gCommands.removeCommand("snapshot");
+	gCommands.removeCommand("restore");
+	gCommands.removeCommand("spawn-bot");
+	gCommands.removeVariable("wall-rise-time");
+	gCommands.removeVariable("wall-fall-time");
+	gCommands.removeVariable("wall-strength");
+	gCommands.removeVariable("build-advance-time");
 }
 
 void SceneLocalGame::onKeyEvent(int key, int action, int mods) {
@@ -30,6 +85,8 @@ void SceneLocalGame::update(float dt) {
 	mGame->update(dt);
 }
 
-void SceneLocalGame::render() {
-	mGame->renderDebug();
+SceneSnapshotPtr SceneLocalGame::snapshot() {
+	auto snapshot = mGame->snapshot();
+	snapshot->gridColor = mGridColor;
+	return snapshot;
 }
\ No newline at end of file
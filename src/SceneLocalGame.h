@@ -1,13 +1,22 @@
 #ifndef SCENE_LOCAL_GAME_H
 #define SCENE_LOCAL_GAME_H
 
+#include "Color.h"
 #include "Scene.h"
+#include <map>
+#include <string>
 
 class Game;
 
+/**
+ * Registers the console commands snapshot [name], restore [name] and spawn-bot [count],
+ * and variables for the wall and building timings while active.
+ */
 class SceneLocalGame : public Scene {
 private:
 	std::shared_ptr<Game> mGame;
+	Color mGridColor;
+	std::map<std::string, std::string> mSavedGames; // Saved by the snapshot command
 
 public:
 	void onActivate() override;
@@ -18,7 +27,7 @@ public:
 
 	void update(float dt) override;
 
-	void render() override;
+	SceneSnapshotPtr snapshot() override;
 };
 
 #endif
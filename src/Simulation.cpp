@@ -0,0 +1,141 @@
+#include "Simulation.h"
+
+#include "CommandRegistry.h"
+#include "FramePacer.h"
+#include "Input.h"
+#include <GLFW/glfw3.h>
+#include <algorithm>
+#include <cstdlib>
+
+using namespace std;
+
+shared_ptr<Simulation> gSimulation;
+
+static const double kCostSmoothing = 0.1;
+
+static void addCost(atomic<double>& averageCost, double cost) {
+	averageCost = averageCost + (cost - averageCost) * kCostSmoothing;
+}
+
+Simulation::Simulation(double timeStep, double maxFrameTime) :
+	mTimeStep(timeStep),
+	mMaxFrameTime(maxFrameTime),
+	mAverageStepCost(0.),
+	mAverageInputCost(0.),
+	mAverageUpdateCost(0.),
+	mAverageSnapshotCost(0.),
+	mPaused(false),
+	mPendingSteps(0),
+	mRunning(false)
+{
+	gCommands.addCommand("pause", "", "Pauses or resumes the simulation", [this](const CommandRegistry::Arguments& args) {
+		mPaused = !mPaused;
+		mPendingSteps = 0;
+		CommandRegistry::print(mPaused ? "Simulation paused" : "Simulation resumed");
+	});
+
+	gCommands.addCommand("step", "[count]", "Pauses the simulation and runs count steps", [this](const CommandRegistry::Arguments& args) {
+		mPaused = true;
+		mPendingSteps += args.size() > 1 ? max(atoi(args[1].c_str()), 0) : 1;
+	});
+}
+
+Simulation::~Simulation() {
+	stop();
+	gCommands.removeCommand("pause");
+	gCommands.removeCommand("step");
+}
+
+void Simulation::start() {
+	if (mRunning) {
+		return;
+	}
+
+	mRunning = true;
+	mThread = thread(&Simulation::run, this);
+}
+
+void Simulation::stop() {
+	mRunning = false;
+	if (mThread.joinable()) {
+		mThread.join();
+	}
+}
+
+bool Simulation::pollFrame(SimulationFrame& frame) {
+	if (!mFrames.update()) {
+		return false;
+	}
+
+	frame = mFrames.front();
+	return true;
+}
+
+void Simulation::run() {
+	double accumulatedTime = 0.;
+	double lastFrameTime = glfwGetTime();
+
+	while (mRunning) {
+		gCommands.runPosted();
+
+		double now = glfwGetTime();
+		accumulatedTime += now - lastFrameTime;
+		lastFrameTime = now;
+
+		if (mPaused) {
+			// Only run the steps requested by the step command
+			accumulatedTime = 0.;
+			for (; mRunning && mPendingSteps > 0; --mPendingSteps) {
+				step(now);
+			}
+
+			FramePacer::sleepUntil(now + mTimeStep);
+			continue;
+		}
+
+		// If steps take longer than the time they simulate, catching up only makes it worse.
+		// Drop the time that can't be simulated and let the game run slower instead.
+		if (accumulatedTime > mMaxFrameTime) {
+			accumulatedTime = mMaxFrameTime;
+		}
+
+		while (mRunning && accumulatedTime >= mTimeStep) {
+			accumulatedTime -= mTimeStep;
+
+			step(lastFrameTime - accumulatedTime);
+		}
+
+		// Sleep until the next step is due
+		FramePacer::sleepUntil(lastFrameTime - accumulatedTime + mTimeStep);
+	}
+}
+
+void Simulation::step(double time) {
+	double stepStart = glfwGetTime();
+
+	// Apply the input events that were received before the end of this step
+	gInput.update(time);
+	for (auto& event : gInput.getAppliedEvents()) {
+		gScenes->onKeyEvent(event.key, event.action, event.mods);
+	}
+
+	double updateStart = glfwGetTime();
+	gScenes->update((float)mTimeStep);
+
+	if (gScenes->isEmpty()) {
+		mRunning = false;
+		return;
+	}
+
+	double snapshotStart = glfwGetTime();
+	auto& frame = mFrames.back();
+	frame.time = time;
+	frame.scene = gScenes->snapshot();
+	mFrames.publish();
+
+	double stepEnd = glfwGetTime();
+	addCost(mAverageInputCost, updateStart - stepStart);
+	addCost(mAverageUpdateCost, snapshotStart - updateStart);
+	addCost(mAverageSnapshotCost, stepEnd - snapshotStart);
+	addCost(mAverageStepCost, stepEnd - stepStart);
+}
@@ -0,0 +1,72 @@
+#ifndef SIMULATION_H
+#define SIMULATION_H
+
+#include "Scene.h"
+#include "TripleBuffer.h"
+#include <atomic>
+#include <memory>
+#include <thread>
+
+/** The result of a simulation step as handed to the render thread */
+struct SimulationFrame {
+	double time; // Time at the end of the step, on the glfwGetTime clock
+	SceneSnapshotPtr scene;
+
+	SimulationFrame() : time(0.) {}
+};
+
+/**
+ * Steps the scene stack at a fixed rate on its own thread, independently of rendering.
+ * Key events reach the scenes through gInput, and each step publishes a snapshot of the
+ * active scene for the render thread. Console commands posted to gCommands are run
+ * between steps.
+ *
+ * Registers the console commands pause and step [count].
+ */
+class Simulation {
+private:
+	double mTimeStep;
+	double mMaxFrameTime;
+	std::atomic<double> mAverageStepCost;
+	std::atomic<double> mAverageInputCost;
+	std::atomic<double> mAverageUpdateCost;
+	std::atomic<double> mAverageSnapshotCost;
+	bool mPaused;      // Only used by the simulation thread
+	int mPendingSteps; // Steps to run while paused
+	std::atomic<bool> mRunning;
+	std::thread mThread;
+	TripleBuffer<SimulationFrame> mFrames;
+
+	Simulation(const Simulation&) = delete;
+	Simulation(Simulation&&) = delete;
+
+	void run();
+	void step(double time);
+
+public:
+	/**
+	 * @param timeStep seconds simulated by each step
+	 * @param maxFrameTime the most time the simulation will try to catch up on at once
+	 */
+	Simulation(double timeStep, double maxFrameTime);
+	~Simulation();
+
+	double getTimeStep() const { return mTimeStep; }
+	double getAverageStepCost() const { return mAverageStepCost; }
+	double getAverageInputCost() const { return mAverageInputCost; }
+	double getAverageUpdateCost() const { return mAverageUpdateCost; }
+	double getAverageSnapshotCost() const { return mAverageSnapshotCost; }
+
+	/** Returns false once the scene stack is empty or stop() has been called */
+	bool isRunning() const { return mRunning; }
+
+	void start();
+	void stop(); // Blocks until the simulation thread finishes its current step
+
+	/** Called by the render thread. Returns true and copies out the latest step if there is a new one */
+	bool pollFrame(SimulationFrame& frame);
+};
+
+extern std::shared_ptr<Simulation> gSimulation;
+
+#endif
@@ -0,0 +1,134 @@
+#ifndef SLOT_MAP_H
+#define SLOT_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+/**
+ * Refers to a value in a SlotMap. A handle is two plain integers, so it can be sent over the
+ * network or saved in a replay, and it never refers to a different value than the one it was
+ * created for: once that value is removed the handle stays invalid, even after its slot is reused.
+ * The default handle is never valid.
+ */
+struct SlotHandle {
+	uint32_t index;
+	uint32_t generation;
+
+	SlotHandle() : index(0), generation(0) {}
+	SlotHandle(uint32_t index, uint32_t generation) : index(index), generation(generation) {}
+
+	bool operator==(const SlotHandle& other) const {
+		return index == other.index && generation == other.generation;
+	}
+
+	bool operator!=(const SlotHandle& other) const { return !(*this == other); }
+};
+
+/**
+ * Values addressed by handles, with constant time insertion, removal and lookup.
+ * The values are kept packed together for iteration. Removing a value moves the last value into
+ * its place, so the order of iteration changes, but handles to the moved value stay valid.
+ */
+template <typename T>
+class SlotMap {
+private:
+	static const uint32_t kNone = 0xffffffffu;
+
+	struct Slot {
+		uint32_t generation; // Of the value in the slot, or of the next one if the slot is free
+		uint32_t position;   // Of the value in mValues, or the next free slot if the slot is free
+	};
+
+	std::vector<Slot> mSlots;
+	std::vector<T> mValues;
+	std::vector<uint32_t> mValueSlots; // The slot of each value
+	uint32_t mFreeSlot; // The most recently freed slot
+
+	bool isInUse(uint32_t index) const {
+		auto position = mSlots[index].position;
+		return position < mValueSlots.size() && mValueSlots[position] == index;
+	}
+
+public:
+	typedef typename std::vector<T>::iterator iterator;
+	typedef typename std::vector<T>::const_iterator const_iterator;
+
+	SlotMap() : mFreeSlot(kNone) {}
+
+	SlotHandle insert(T value) {
+		uint32_t index = mFreeSlot;
+		if (index == kNone) {
+			index = (uint32_t)mSlots.size();
+			Slot slot = {1, 0};
+			mSlots.push_back(slot);
+		} else {
+			mFreeSlot = mSlots[index].position;
+		}
+
+		auto& slot = mSlots[index];
+		slot.position = (uint32_t)mValues.size();
+		mValues.push_back(std::move(value));
+		mValueSlots.push_back(index);
+		return SlotHandle(index, slot.generation);
+	}
+
+	/** Returns false if the handle was already invalid */
+	bool remove(SlotHandle handle) {
+		if (!contains(handle)) {
+			return false;
+		}
+
+		auto& slot = mSlots[handle.index];
+		uint32_t last = (uint32_t)mValues.size() - 1;
+		if (slot.position != last) {
+			mValues[slot.position] = std::move(mValues[last]);
+			mValueSlots[slot.position] = mValueSlots[last];
+			mSlots[mValueSlots[last]].position = slot.position;
+		}
+
+		mValues.pop_back();
+		mValueSlots.pop_back();
+
+		// Skip generation 0 when wrapping around, so the default handle stays invalid
+		if (++slot.generation == 0) {
+			slot.generation = 1;
+		}
+
+		slot.position = mFreeSlot;
+		mFreeSlot = handle.index;
+		return true;
+	}
+
+	bool contains(SlotHandle handle) const {
+		return handle.index < mSlots.size() && mSlots[handle.index].generation == handle.generation &&
+			isInUse(handle.index);
+	}
+
+	/** Returns null if the handle is invalid */
+	T* get(SlotHandle handle) {
+		return contains(handle) ? &mValues[mSlots[handle.index].position] : nullptr;
+	}
+
+	const T* get(SlotHandle handle) const {
+		return contains(handle) ? &mValues[mSlots[handle.index].position] : nullptr;
+	}
+
+	size_t size() const { return mValues.size(); }
+	bool isEmpty() const { return mValues.empty(); }
+
+	iterator begin() { return mValues.begin(); }
+	iterator end() { return mValues.end(); }
+	const_iterator begin() const { return mValues.begin(); }
+	const_iterator end() const { return mValues.end(); }
+
+	void clear() {
+		while (!mValues.empty()) {
+			uint32_t index = mValueSlots.back();
+			remove(SlotHandle(index, mSlots[index].generation));
+		}
+	}
+};
+
+#endif
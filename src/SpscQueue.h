@@ -0,0 +1,59 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+
+/**
+ * Bounded lock-free queue for exactly one producer thread and one consumer thread.
+ * Capacity must be a power of two. Pushing onto a full queue fails instead of blocking.
+ */
+template <typename T, size_t Capacity>
+class SpscQueue {
+private:
+	static_assert((Capacity & (Capacity - 1)) == 0, "SpscQueue capacity must be a power of two");
+
+	T mItems[Capacity];
+	std::atomic<size_t> mHead; // Next item to be read, only written by the consumer
+	std::atomic<size_t> mTail; // Next slot to be written, only written by the producer
+
+	SpscQueue(const SpscQueue&) = delete;
+	SpscQueue(SpscQueue&&) = delete;
+
+public:
+	SpscQueue() : mHead(0), mTail(0) {}
+
+	bool isEmpty() const {
+		return mHead.load(std::memory_order_acquire) == mTail.load(std::memory_order_acquire);
+	}
+
+	/** Called by the producer. Returns false if the queue is full. */
+	bool push(const T& item) {
+		auto tail = mTail.load(std::memory_order_relaxed);
+		if (tail - mHead.load(std::memory_order_acquire) == Capacity) {
+			return false;
+		}
+
+		mItems[tail & (Capacity - 1)] = item;
+		mTail.store(tail + 1, std::memory_order_release);
+		return true;
+	}
+
+	/** Called by the consumer. Returns nullptr if the queue is empty. */
+	const T* front() const {
+		auto head = mHead.load(std::memory_order_relaxed);
+		if (head == mTail.load(std::memory_order_acquire)) {
+			return nullptr;
+		}
+
+		return &mItems[head & (Capacity - 1)];
+	}
+
+	/** Called by the consumer to discard the item returned by front() */
+	void pop() {
+		auto head = mHead.load(std::memory_order_relaxed);
+		mHead.store(head + 1, std::memory_order_release);
+	}
+};
+
+#endif
@@ -0,0 +1,147 @@
+#include "Game.h"
+#include <cstdio>
+#include <sstream>
+#include <string>
+
+using namespace std;
+
+static const int kSize = 10;
+static const int kWallStatic = 3; // Wall::WALL_STATIC, as Wall::save() writes it
+
+/**
+ * Loads a game with no players from rows of text, top row first, where '#' is a completed wall of
+ * player 0 and '.' is an empty cell
+ */
+static Game* loadGame(const char* const rows[kSize]) {
+	ostringstream out;
+	int numWalls = 0;
+	ostringstream walls;
+	for (int y = 0; y < kSize; ++y) {
+		for (int x = 0; x < kSize; ++x) {
+			if (rows[kSize - 1 - y][x] == '#') {
+				walls << x << ' ' << y << " 0 " << kWallStatic << " 100 0 0\n";
+				++numWalls;
+			}
+		}
+	}
+
+	out << "isolated-game 1\n" << kSize << ' ' << kSize << " 0\n0\n" << numWalls << '\n' << walls.str();
+	istringstream in(out.str());
+	auto game = new Game(in);
+	if (in.fail()) {
+		fprintf(stderr, "Unable to load the test game\n");
+		delete game;
+		return nullptr;
+	}
+
+	return game;
+}
+
+/** Returns true if every cell of the rectangle holds a wall */
+static bool isFilled(Game& game, int left, int bottom, int right, int top) {
+	for (int y = bottom; y <= top; ++y) {
+		for (int x = left; x <= right; ++x) {
+			if (!game.getWallAt(x, y)) {
+				return false;
+			}
+		}
+	}
+
+	return true;
+}
+
+// A box with a gap on its right side, and a chain of two walls that can be pushed into the gap
+static const char* kOpenBox[kSize] = {
+	"..........",
+	"..........",
+	"..........",
+	"..#####...",
+	"..#...#...",
+	"..#....##.",
+	"..#...#...",
+	"..#####...",
+	"..........",
+	"..........",
+};
+
+/** Pushing the chain by one cell into the gap closes the box, which fills the inside */
+static bool testChainPushFillsRegion() {
+	Game* game = loadGame(kOpenBox);
+	if (!game) {
+		return false;
+	}
+
+	bool passed = true;
+	if (game->getWallAt(4, 4)) {
+		fprintf(stderr, "testChainPushFillsRegion: the box is filled before it's closed\n");
+		passed = false;
+	}
+
+	GridTransaction transaction;
+	transaction.moveWall(7, 4, 6, 4);
+	transaction.moveWall(8, 4, 7, 4);
+	game->apply(transaction);
+
+	if (!game->getWallAt(6, 4) || !game->getWallAt(7, 4) || game->getWallAt(8, 4)) {
+		fprintf(stderr, "testChainPushFillsRegion: the chain wasn't pushed\n");
+		passed = false;
+	}
+
+	if (!isFilled(*game, 3, 3, 5, 5)) {
+		fprintf(stderr, "testChainPushFillsRegion: the closed box isn't filled\n");
+		passed = false;
+	}
+
+	if (game->getWallAt(0, 0) || game->getWallAt(9, 9)) {
+		fprintf(stderr, "testChainPushFillsRegion: cells outside the box were filled\n");
+		passed = false;
+	}
+
+	delete game;
+	return passed;
+}
+
+/** Pushing the chain away from the gap leaves the box open and empty */
+static bool testChainPushLeavesOpenRegion() {
+	Game* game = loadGame(kOpenBox);
+	if (!game) {
+		return false;
+	}
+
+	GridTransaction transaction;
+	transaction.moveWall(7, 4, 8, 4);
+	transaction.moveWall(8, 4, 9, 4);
+	game->apply(transaction);
+
+	bool passed = true;
+	if (game->getWallAt(7, 4) || !game->getWallAt(8, 4) || !game->getWallAt(9, 4)) {
+		fprintf(stderr, "testChainPushLeavesOpenRegion: the chain wasn't pushed\n");
+		passed = false;
+	}
+
+	if (game->getWallAt(4, 4) || game->getWallAt(6, 4)) {
+		fprintf(stderr, "testChainPushLeavesOpenRegion: the open box was filled\n");
+		passed = false;
+	}
+
+	delete game;
+	return passed;
+}
+
+/**
+ * isolated_test_game: checks how transactions applied to the grid interact with the fill rule
+ * Usage: isolated_test_game
+ */
+int main() {
+	int numFailed = 0;
+	numFailed += testChainPushFillsRegion() ? 0 : 1;
+	numFailed += testChainPushLeavesOpenRegion() ? 0 : 1;
+
+	if (numFailed > 0) {
+		printf("%d tests failed\n", numFailed);
+		return 1;
+	}
+
+	printf("All tests passed\n");
+	return 0;
+}
@@ -0,0 +1,112 @@
+#include "TextureAtlas.h"
+
+#include <algorithm>
+#include <climits>
+
+using namespace std;
+
+TextureAtlas::TextureAtlas(int width, int height, GLint filter) :
+	mWidth(width), mHeight(height)
+{
+	SkylineNode floor = {0, 0, width};
+	mSkyline.push_back(floor);
+
+	glGenTextures(1, &mTexture);
+	glBindTexture(GL_TEXTURE_2D, mTexture);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, filter);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP);
+	glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP);
+
+	// Clear to transparent so that sampling next to an image never picks up garbage
+	vector<unsigned char> clear(width * height * 4, 0);
+	glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA8, width, height, 0, GL_RGBA, GL_UNSIGNED_BYTE, clear.data());
+}
+
+TextureAtlas::~TextureAtlas() {
+	glDeleteTextures(1, &mTexture);
+}
+
+int TextureAtlas::fit(size_t index, int width, int height) const {
+	if (mSkyline[index].x + width > mWidth) {
+		return -1;
+	}
+
+	// The rectangle rests on the highest node under it
+	int y = 0;
+	for (int remaining = width; remaining > 0; ++index) {
+		y = max(y, mSkyline[index].y);
+		if (y + height > mHeight) {
+			return -1;
+		}
+
+		remaining -= mSkyline[index].width;
+	}
+
+	return y;
+}
+
+bool TextureAtlas::allocate(int width, int height, int& x, int& y) {
+	size_t bestIndex = 0;
+	int bestTop = INT_MAX;
+	int bestWidth = INT_MAX;
+
+	for (size_t i = 0; i < mSkyline.size(); ++i) {
+		int fitY = fit(i, width, height);
+		if (fitY < 0) {
+			continue;
+		}
+
+		// Prefer the lowest top edge, then the narrowest gap so wide gaps stay free
+		if (fitY + height < bestTop || (fitY + height == bestTop && mSkyline[i].width < bestWidth)) {
+			bestIndex = i;
+			bestTop = fitY + height;
+			bestWidth = mSkyline[i].width;
+		}
+	}
+
+	if (bestTop == INT_MAX) {
+		return false;
+	}
+
+	x = mSkyline[bestIndex].x;
+	y = bestTop - height;
+
+	// Raise the skyline under the new rectangle
+	SkylineNode node = {x, bestTop, width};
+	mSkyline.insert(mSkyline.begin() + bestIndex, node);
+
+	for (size_t i = bestIndex + 1; i < mSkyline.size();) {
+		auto& previous = mSkyline[i - 1];
+		auto& current = mSkyline[i];
+		int overlap = previous.x + previous.width - current.x;
+		if (overlap <= 0) {
+			break;
+		}
+
+		if (overlap < current.width) {
+			current.x += overlap;
+			current.width -= overlap;
+			break;
+		}
+
+		mSkyline.erase(mSkyline.begin() + i);
+	}
+
+	// Merge neighbours at the same height
+	for (size_t i = 1; i < mSkyline.size();) {
+		if (mSkyline[i - 1].y == mSkyline[i].y) {
+			mSkyline[i - 1].width += mSkyline[i].width;
+			mSkyline.erase(mSkyline.begin() + i);
+		} else {
+			++i;
+		}
+	}
+
+	return true;
+}
+
+void TextureAtlas::upload(TextureUploader& uploader, int x, int y, int width, int height, const unsigned char* pixels) {
+	glBindTexture(GL_TEXTURE_2D, mTexture);
+	uploader.upload(x, y, width, height, pixels);
+}
@@ -0,0 +1,48 @@
+#ifndef TEXTURE_ATLAS_H
+#define TEXTURE_ATLAS_H
+
+#include "TextureUploader.h"
+#include <GLFW/glfw3.h>
+#include <cstddef>
+#include <vector>
+
+/**
+ * RGBA texture that many images are packed into, so they can be drawn without rebinding.
+ * Space is allocated with a bottom-left skyline packer: the atlas tracks the height of the
+ * packed images along its width and puts each new image where its top edge will be lowest.
+ * Note: The rendering context must be initialized before instantiating an atlas
+ */
+class TextureAtlas {
+private:
+	struct SkylineNode {
+		int x, y;
+		int width;
+	};
+
+	int mWidth;
+	int mHeight;
+	GLuint mTexture;
+	std::vector<SkylineNode> mSkyline;
+
+	TextureAtlas(const TextureAtlas&) = delete;
+	TextureAtlas(TextureAtlas&&) = delete;
+
+	/** Returns the lowest y that a rectangle starting at the specified node fits at, or -1 */
+	int fit(size_t index, int width, int height) const;
+
+public:
+	TextureAtlas(int width, int height, GLint filter = GL_NEAREST);
+	~TextureAtlas();
+
+	int getWidth() const { return mWidth; }
+	int getHeight() const { return mHeight; }
+	GLuint getTexture() const { return mTexture; }
+
+	/** Reserves a width x height rectangle. Returns false if there is no room. */
+	bool allocate(int width, int height, int& x, int& y);
+
+	/** Copies tightly packed RGBA pixels into the specified rectangle */
+	void upload(TextureUploader& uploader, int x, int y, int width, int height, const unsigned char* pixels);
+};
+
+#endif
@@ -0,0 +1,72 @@
+#include "TextureUploader.h"
+
+#include "GLExtensions.h"
+#include <cstring>
+
+using namespace std;
+
+TextureUploader::TextureUploader() :
+	mNextBuffer(0),
+	mUseBuffers(gGLExtensions.pixelBufferObjects)
+{
+	if (mUseBuffers) {
+		gGLExtensions.genBuffers(kNumBuffers, mBuffers);
+	}
+}
+
+TextureUploader::~TextureUploader() {
+	if (mUseBuffers) {
+		gGLExtensions.deleteBuffers(kNumBuffers, mBuffers);
+	}
+}
+
+bool TextureUploader::uploadBand(int x, int y, int width, int height, const unsigned char* pixels) {
+	size_t size = (size_t)width * height * 4;
+	gGLExtensions.bindBuffer(GL_PIXEL_UNPACK_BUFFER, mBuffers[mNextBuffer]);
+	mNextBuffer = (mNextBuffer + 1) % kNumBuffers;
+
+	// Orphan the previous contents, which a transfer may still be reading
+	gGLExtensions.bufferData(GL_PIXEL_UNPACK_BUFFER, size, nullptr, GL_STREAM_DRAW);
+	auto mapped = gGLExtensions.mapBuffer(GL_PIXEL_UNPACK_BUFFER, GL_WRITE_ONLY);
+	bool copied = mapped != nullptr;
+	if (mapped) {
+		memcpy(mapped, pixels, size);
+		// The contents are lost if the mapping was invalidated, e.g. by a mode switch
+		copied = gGLExtensions.unmapBuffer(GL_PIXEL_UNPACK_BUFFER) == GL_TRUE;
+	}
+
+	if (copied) {
+		glTexSubImage2D(GL_TEXTURE_2D, 0, x, y, width, height, GL_RGBA, GL_UNSIGNED_BYTE, nullptr);
+	}
+
+	gGLExtensions.bindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+	return copied;
+}
+
+void TextureUploader::upload(int x, int y, int width, int height, const unsigned char* pixels) {
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 1);
+
+	size_t rowSize = (size_t)width * 4;
+	int bandHeight = mUseBuffers ? (int)(kMaxBandSize / rowSize) : 0;
+	for (int row = 0; row < height;) {
+		int rows = height - row;
+		if (rows > bandHeight) {
+			rows = bandHeight;
+		}
+
+		auto band = pixels + row * rowSize;
+		if (rows == 0) {
+			// Too wide for a buffer, or no buffers at all
+			glTexSubImage2D(GL_TEXTURE_2D, 0, x, y + row, width, height - row, GL_RGBA, GL_UNSIGNED_BYTE, band);
+			break;
+		}
+
+		if (!uploadBand(x, y + row, width, rows, band)) {
+			glTexSubImage2D(GL_TEXTURE_2D, 0, x, y + row, width, rows, GL_RGBA, GL_UNSIGNED_BYTE, band);
+		}
+
+		row += rows;
+	}
+
+	glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
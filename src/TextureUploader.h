@@ -0,0 +1,44 @@
+#ifndef TEXTURE_UPLOADER_H
+#define TEXTURE_UPLOADER_H
+
+#include <GLFW/glfw3.h>
+#include <cstddef>
+
+/**
+ * Streams RGBA pixels into textures through a ring of pixel buffer objects
+ *
+ * glTexSubImage2D from client memory can't return until the driver has copied the pixels, and
+ * may wait for the GPU to stop using the texture first. Sourced from a pixel buffer, the call
+ * only queues the transfer, which the GPU does while the frame is drawn. Each buffer is orphaned
+ * before it's refilled so that filling it never waits on the transfer still reading it, and the
+ * uploads cycle through several buffers to give the driver time to recycle them. The new storage
+ * is only as large as the band being uploaded, so small images don't cost a whole band.
+ * Images larger than kMaxBandSize are streamed in bands of rows. Without pixel buffer objects the
+ * pixels are uploaded directly.
+ *
+ * Only to be used by the rendering thread.
+ */
+class TextureUploader {
+private:
+	static const int kNumBuffers = 4;
+	static const size_t kMaxBandSize = 4 << 20;
+
+	GLuint mBuffers[kNumBuffers];
+	int mNextBuffer;
+	bool mUseBuffers;
+
+	TextureUploader(const TextureUploader&) = delete;
+	TextureUploader(TextureUploader&&) = delete;
+
+	/** Returns false if the band couldn't be copied into a buffer */
+	bool uploadBand(int x, int y, int width, int height, const unsigned char* pixels);
+
+public:
+	TextureUploader();
+	~TextureUploader();
+
+	/** Copies tightly packed RGBA pixels into a rectangle of the currently bound GL_TEXTURE_2D */
+	void upload(int x, int y, int width, int height, const unsigned char* pixels);
+};
+
+#endif
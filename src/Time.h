@@ -42,11 +42,15 @@ public:
 		return t * t;
 	}
 
+	float getDuration() const { return mDuration; }
 	float getElapsedTime() const { return (float)(mClock.getTime() - mStartTime); }
 	bool isExpired() const { return mEndTime - mClock.getTime() <= 0; }
 
 	void setDuration(float duration) { mDuration = duration; reset(); }
 	void reset() { mStartTime = mClock.getTime(); mEndTime = mStartTime + mDuration; }
+
+	/** Restarts the timer as if it had started the specified number of seconds ago */
+	void setElapsedTime(float elapsed) { mStartTime = mClock.getTime() - elapsed; mEndTime = mStartTime + mDuration; }
 };
 
 // Timers as processes that spawn other processes when they expire
@@ -0,0 +1,49 @@
+#ifndef TRIPLE_BUFFER_H
+#define TRIPLE_BUFFER_H
+
+#include <atomic>
+
+/**
+ * Passes values from one producer thread to one consumer thread without locking.
+ * The producer fills back() and publishes it; the consumer calls update() to take the
+ * most recently published value as front(). Values published while the consumer is busy
+ * are overwritten, so neither side ever waits on the other.
+ */
+template <typename T>
+class TripleBuffer {
+private:
+	static const int kIndexMask = 3;
+	static const int kFresh = 4; // Set on the shared index when it holds an unread value
+
+	T mBuffers[3];
+	std::atomic<int> mShared;
+	int mBack;  // Only touched by the producer
+	int mFront; // Only touched by the consumer
+
+	TripleBuffer(const TripleBuffer&) = delete;
+	TripleBuffer(TripleBuffer&&) = delete;
+
+public:
+	TripleBuffer() : mShared(1), mBack(0), mFront(2) {}
+
+	T& back() { return mBuffers[mBack]; }
+
+	/** Called by the producer once back() is filled in */
+	void publish() {
+		mBack = mShared.exchange(mBack | kFresh, std::memory_order_acq_rel) & kIndexMask;
+	}
+
+	/** Called by the consumer. Returns true if front() changed to a newly published value */
+	bool update() {
+		if (!(mShared.load(std::memory_order_relaxed) & kFresh)) {
+			return false;
+		}
+
+		mFront = mShared.exchange(mFront, std::memory_order_acq_rel) & kIndexMask;
+		return true;
+	}
+
+	const T& front() const { return mBuffers[mFront]; }
+};
+
+#endif
@@ -9,8 +9,8 @@ float Wall::sRiseTime = 0.7f;
 float Wall::sFallTime = 0.7f;
 int Wall::sMaxStrength = 3;
 
-Wall::Wall(Game& game, int x, int y, int entityId, int playerId) :
-	Entity(entityId, ENTITY_WALL), // TODO: Give walls an entityId
+Wall::Wall(Game& game, int x, int y, EntityHandle handle, int playerId) :
+	Entity(handle, ENTITY_WALL),
 	mState(WALL_RISING),
 	mGame(game),
 	mPlayerId(playerId),
@@ -60,6 +60,21 @@ void Wall::die() {
 	// TODO: notify our WallStream that it should stop
 }
 
+void Wall::save(std::ostream& out) const {
+	out << (int)mState << ' ' << mStrength << ' ' << mBuildTimer.getDuration() << ' ' << mBuildTimer.getElapsedTime();
+}
+
+void Wall::load(std::istream& in) {
+	int state = WALL_STATIC;
+	float duration = 0.f;
+	float elapsed = 0.f;
+	in >> state >> mStrength >> duration >> elapsed;
+
+	mState = (State)state;
+	mBuildTimer.setDuration(duration);
+	mBuildTimer.setElapsedTime(elapsed);
+}
+
 void Wall::update(float dt) {
 	if (mState == WALL_RISING) {
 		if (mBuildTimer.isExpired()) {
@@ -3,7 +3,9 @@
 
 #include "Entity.h"
 #include "Time.h"
+#include <istream>
 #include <memory>
+#include <ostream>
 
 class Wall;
 typedef std::shared_ptr<Wall> WallPtr;
@@ -35,7 +37,7 @@ public:
 	static float sFallTime;
 	static int sMaxStrength;
 
-	Wall(Game& game, int x, int y, int entityId, int playerId);
+	Wall(Game& game, int x, int y, EntityHandle handle, int playerId);
 
 	int getPlayerId() const { return mPlayerId; }
 	int getStrength() const { return mStrength; }
@@ -48,6 +50,9 @@ public:
 	void die();
 
 	void update(float dt);
+
+	void save(std::ostream& out) const;
+	void load(std::istream& in);
 };
 
 #endif
@@ -0,0 +1,61 @@
+#include "WorkerPool.h"
+
+#include <algorithm>
+
+using namespace std;
+
+shared_ptr<WorkerPool> gWorkers;
+
+static const int kReservedThreads = 2; // The main and simulation threads
+
+WorkerPool::WorkerPool(int numThreads) :
+	mStopping(false)
+{
+	if (numThreads <= 0) {
+		numThreads = max((int)thread::hardware_concurrency() - kReservedThreads, 1);
+	}
+
+	for (int i = 0; i < numThreads; ++i) {
+		mThreads.emplace_back(&WorkerPool::run, this);
+	}
+}
+
+WorkerPool::~WorkerPool() {
+	{
+		lock_guard<mutex> lock(mMutex);
+		mStopping = true;
+	}
+
+	mJobPosted.notify_all();
+	for (auto& worker : mThreads) {
+		worker.join();
+	}
+}
+
+void WorkerPool::post(function<void()> job) {
+	{
+		lock_guard<mutex> lock(mMutex);
+		mJobs.push_back(move(job));
+	}
+
+	mJobPosted.notify_one();
+}
+
+void WorkerPool::run() {
+	for (;;) {
+		function<void()> job;
+
+		{
+			unique_lock<mutex> lock(mMutex);
+			mJobPosted.wait(lock, [this]() { return mStopping || !mJobs.empty(); });
+			if (mJobs.empty()) {
+				return;
+			}
+
+			job = move(mJobs.front());
+			mJobs.pop_front();
+		}
+
+		job();
+	}
+}
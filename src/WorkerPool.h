@@ -0,0 +1,53 @@
+#ifndef WORKER_POOL_H
+#define WORKER_POOL_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/**
+ * Fixed set of threads that run posted jobs in the order they were posted
+ * For work that doesn't touch OpenGL or the game, like decoding and encoding images.
+ */
+class WorkerPool {
+private:
+	std::vector<std::thread> mThreads;
+	std::deque<std::function<void()>> mJobs;
+	std::mutex mMutex;
+	std::condition_variable mJobPosted;
+	bool mStopping;
+
+	WorkerPool(const WorkerPool&) = delete;
+	WorkerPool(WorkerPool&&) = delete;
+
+	void run();
+
+public:
+	/** @param numThreads the number of workers, or 0 for one per core not used by the main and simulation threads */
+	explicit WorkerPool(int numThreads = 0);
+
+	/** Finishes the jobs already posted, then stops the workers */
+	~WorkerPool();
+
+	int getNumThreads() const { return (int)mThreads.size(); }
+
+	void post(std::function<void()> job);
+
+	/** Posts a job and returns a future for its result */
+	template <typename FunctionT>
+	auto async(FunctionT function) -> std::future<decltype(function())> {
+		auto task = std::make_shared<std::packaged_task<decltype(function())()>>(std::move(function));
+		auto result = task->get_future();
+		post([task]() { (*task)(); });
+		return result;
+	}
+};
+
+extern std::shared_ptr<WorkerPool> gWorkers;
+
+#endif